@@ -0,0 +1,45 @@
+#ifndef ALIGNED_ALLOCATOR_H
+#define ALIGNED_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+
+namespace OrderBookProgrammingProblem {
+  inline constexpr size_t cache_line_size = 64;
+
+  // Allocator for std::vector whose storage starts on a cache line boundary,
+  // so that a sweep over the elements touches the minimum number of lines and
+  // aligned SIMD loads can be used from the first element
+  template<typename T, size_t Alignment = cache_line_size>
+  struct AlignedAllocator {
+    static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0);
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+      using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {
+    }
+
+    [[nodiscard]] T *allocate(const size_t n) {
+      return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T *p, const size_t n) noexcept {
+      ::operator delete(p, n * sizeof(T), std::align_val_t{Alignment});
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept {
+      return true;
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // ALIGNED_ALLOCATOR_H
@@ -0,0 +1,80 @@
+#ifndef ALLOCATION_STATS_H
+#define ALLOCATION_STATS_H
+
+#include "order.h"
+
+#include <array>
+#include <cstddef>
+#include <format>
+#include <string>
+
+namespace OrderBookProgrammingProblem {
+  // Heap allocations per message, broken down by message type. Messages
+  // after the first warm_up ones are in the steady state, where the engine is
+  // expected not to allocate at all, so those that did are counted apart.
+  // Recording never allocates, so that it can sit in the measured loop.
+  class AllocationStats {
+    struct Entry {
+      size_t messages = 0;
+      size_t allocations = 0;
+      size_t steady_messages = 0;
+      size_t steady_allocating_messages = 0;
+      size_t steady_allocations = 0;
+    };
+
+    // Indexed by the Order::Type character
+    std::array<Entry, 256> entries{};
+    size_t warm_up;
+    size_t message_count = 0;
+
+    static std::string type_name(const Order::Type type) {
+      switch (type) {
+        case Order::Type::Add: return "add";
+        case Order::Type::Reduce: return "reduce";
+        case Order::Type::Cancel: return "cancel";
+        case Order::Type::Replace: return "replace";
+      }
+      return std::string(1, static_cast<char>(type));
+    }
+
+  public:
+    explicit AllocationStats(const size_t warm_up_messages) : warm_up(warm_up_messages) {
+    }
+
+    [[nodiscard]] bool in_steady_state() const { return message_count >= warm_up; }
+
+    // Returns true if the message allocated in the steady state
+    bool record(const Order::Type type, const size_t allocations) {
+      auto &entry = entries[static_cast<unsigned char>(type)];
+      ++entry.messages;
+      entry.allocations += allocations;
+      const bool steady = in_steady_state();
+      ++message_count;
+      if (!steady)
+        return false;
+      ++entry.steady_messages;
+      entry.steady_allocations += allocations;
+      if (allocations == 0)
+        return false;
+      ++entry.steady_allocating_messages;
+      return true;
+    }
+
+    [[nodiscard]] std::string to_string() const {
+      std::string out = std::format("{:<8} {:>10} {:>12} {:>10} {:>16} {:>14}\n", "type", "messages", "allocations",
+                                    "per msg", "steady allocs", "steady msgs");
+      for (size_t i = 0; i < entries.size(); ++i) {
+        const auto &entry = entries[i];
+        if (entry.messages == 0)
+          continue;
+        out += std::format("{:<8} {:>10} {:>12} {:>10.2f} {:>16} {:>8}/{:<5}\n",
+                           type_name(static_cast<Order::Type>(i)), entry.messages, entry.allocations,
+                           static_cast<double>(entry.allocations) / static_cast<double>(entry.messages),
+                           entry.steady_allocations, entry.steady_allocating_messages, entry.steady_messages);
+      }
+      return out;
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // ALLOCATION_STATS_H
@@ -1,8 +1,18 @@
 #ifndef BST_LOCKED_IMPL_H
 #define BST_LOCKED_IMPL_H
 
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <iterator>
 #include <print>
+#include <ranges>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace OrderBookProgrammingProblem {
@@ -19,9 +29,149 @@ namespace OrderBookProgrammingProblem {
     }
   };
 
-  // Enum for traversal order
+  // Enum for traversal order, LeftRootRight visits values in ascending order
+  // and RightRootLeft in descending order
   enum class TraversalOrder { LeftRootRight, RightRootLeft };
 
+  // Bidirectional in-order iterator over a BST without parent links: it keeps
+  // the path from the root to the current node on an explicit stack, so a
+  // walk is a plain loop with no recursion and no indirect calls. Links
+  // describes the tree: Handle, a null handle, left(h), right(h) and value(h).
+  // The end iterator has an empty path, decrementing it goes to the last node.
+  template<typename Links, TraversalOrder Order>
+  class BstInorderIterator {
+    using Handle = typename Links::Handle;
+
+    // Stack of handles, kept inline up to the depth of any reasonable tree
+    class Path {
+      static constexpr size_t inline_capacity = 32;
+      std::array<Handle, inline_capacity> inline_items;
+      std::vector<Handle> spill;
+      size_t count = 0;
+
+    public:
+      void push(const Handle h) {
+        if (count < inline_capacity)
+          inline_items[count] = h;
+        else
+          spill.push_back(h);
+        ++count;
+      }
+
+      void pop() {
+        --count;
+        if (count >= inline_capacity)
+          spill.pop_back();
+      }
+
+      [[nodiscard]] Handle back() const {
+        return count <= inline_capacity ? inline_items[count - 1] : spill.back();
+      }
+
+      [[nodiscard]] bool empty() const { return count == 0; }
+      void clear() {
+        count = 0;
+        spill.clear();
+      }
+    };
+
+    Links links{};
+    Handle root = Links::null;
+    Path path;
+
+    // "Near" is the side visited first, i.e., the left one in LeftRootRight
+    [[nodiscard]] Handle near(const Handle h) const {
+      return Order == TraversalOrder::LeftRootRight ? links.left(h) : links.right(h);
+    }
+
+    [[nodiscard]] Handle far(const Handle h) const {
+      return Order == TraversalOrder::LeftRootRight ? links.right(h) : links.left(h);
+    }
+
+    // Pushes h and then its near-most descendants
+    template<bool Near>
+    void descend(Handle h) {
+      while (h != Links::null) {
+        path.push(h);
+        h = Near ? near(h) : far(h);
+      }
+    }
+
+    // Moves to the next node in Order (Forward) or the previous one
+    template<bool Forward>
+    void step() {
+      const Handle h = path.back();
+      if (const Handle child = Forward ? far(h) : near(h); child != Links::null) {
+        descend<Forward>(child);
+        return;
+      }
+      // Climb until we leave a subtree that was visited before its parent
+      Handle from;
+      do {
+        from = path.back();
+        path.pop();
+      } while (!path.empty() && (Forward ? far(path.back()) : near(path.back())) == from);
+    }
+
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = std::remove_cvref_t<decltype(std::declval<Links>().value(std::declval<Handle>()))>;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type &;
+
+    BstInorderIterator() = default;
+
+    // The first node in Order if begin, the end iterator otherwise
+    BstInorderIterator(const Links l, const Handle tree_root, const bool begin) : links(l), root(tree_root) {
+      if (begin)
+        descend<true>(root);
+    }
+
+    reference operator*() const { return links.value(path.back()); }
+    value_type *operator->() const { return &links.value(path.back()); }
+
+    BstInorderIterator &operator++() {
+      step<true>();
+      return *this;
+    }
+
+    BstInorderIterator operator++(int) {
+      auto previous = *this;
+      ++*this;
+      return previous;
+    }
+
+    BstInorderIterator &operator--() {
+      if (path.empty())
+        descend<false>(root);
+      else
+        step<false>();
+      return *this;
+    }
+
+    BstInorderIterator operator--(int) {
+      auto previous = *this;
+      --*this;
+      return previous;
+    }
+
+    bool operator==(const BstInorderIterator &other) const {
+      if (path.empty() || other.path.empty())
+        return path.empty() == other.path.empty();
+      return path.back() == other.path.back();
+    }
+  };
+
+  template<std::totally_ordered T>
+  struct TreeNodeLinks {
+    using Handle = TreeNode<T> *;
+    static constexpr Handle null = nullptr;
+
+    static Handle left(const Handle h) { return h->left; }
+    static Handle right(const Handle h) { return h->right; }
+    static T &value(const Handle h) { return h->val; }
+  };
+
 
   template<std::totally_ordered T>
   class BinarySearchTree {
@@ -73,7 +223,7 @@ namespace OrderBookProgrammingProblem {
       if (root == nullptr)
         return true;
 
-      if constexpr (Order != TraversalOrder::LeftRootRight) {
+      if constexpr (Order == TraversalOrder::LeftRootRight) {
         if (root->left != nullptr)
           if (!inorder_traversal_cb<Order>(root->left, callback, context)) return false;
 
@@ -183,6 +333,13 @@ namespace OrderBookProgrammingProblem {
       return true;
     }
 
+    // Values in Order as a range, e.g., for (auto &val: BST::inorder<Order>(root))
+    template<TraversalOrder Order>
+    static auto inorder(TreeNode<T> *root) {
+      using Iterator = BstInorderIterator<TreeNodeLinks<T>, Order>;
+      return std::ranges::subrange(Iterator({}, root, true), Iterator({}, root, false));
+    }
+
     static void visualize_tree(TreeNode<T> *root, int depth = 0,
                                char branch = ' ') {
       if (root == nullptr) {
@@ -198,6 +355,254 @@ namespace OrderBookProgrammingProblem {
       visualize_tree(root->left, depth + 1, '\\');
     }
   };
+
+  // Augment policy of ArenaBinarySearchTree that keeps no subtree summary
+  template<typename T>
+  struct NoAugment {
+    struct Summary {
+    };
+
+    static Summary of(const T &) { return {}; }
+    static Summary combine(const Summary &, const Summary &) { return {}; }
+  };
+
+  // Same unbalanced BST as BinarySearchTree, but the nodes of one tree live in
+  // a single arena with 32-bit child indices, and freed nodes are recycled
+  // through a free list: once the tree reached its peak size inserting and
+  // deleting values never allocates, and a node takes 8 bytes of links instead
+  // of 16. Deleting a node with two children relinks its successor in its
+  // place rather than copying the successor's value over.
+  //
+  // Augment can make every node summarize its subtree: Augment::of(val) is the
+  // node's own contribution and Augment::combine() an associative merge.
+  // Summaries are fixed up along the changed path on insert() and
+  // delete_node(), and refresh() does the same after a value changed in place.
+  template<std::totally_ordered T, typename Augment = NoAugment<T> >
+    requires std::default_initializable<T>
+  class ArenaBinarySearchTree {
+  public:
+    using Index = uint32_t;
+    static constexpr Index null = UINT32_MAX;
+    using Summary = typename Augment::Summary;
+    static constexpr bool augmented = !std::is_empty_v<Summary>;
+
+    struct Sums {
+      // The node's own value, and the node plus both subtrees
+      Summary own{};
+      Summary subtree{};
+    };
+
+    struct NoSums {
+    };
+
+    struct Node {
+      T val{};
+      Index left = null;
+      // Links the free list while the node is unused
+      Index right = null;
+      [[no_unique_address]] std::conditional_t<augmented, Sums, NoSums> sums{};
+    };
+
+  private:
+    std::vector<Node> nodes;
+    Index root_idx = null;
+    Index free_head = null;
+    size_t count = 0;
+    // Nodes whose summary is stale, deepest last
+    std::vector<Index> path;
+
+    // The link (root_idx or a child index) that points to the node equal to
+    // val, or to where it would be inserted. The nodes passed on the way are
+    // recorded in path if augmented
+    template<typename T2>
+    Index *find_link(const T2 &val) {
+      if constexpr (augmented)
+        path.clear();
+      Index *link = &root_idx;
+      while (*link != null) {
+        auto &node = nodes[*link];
+        if (node.val == val)
+          break;
+        if constexpr (augmented)
+          path.push_back(*link);
+        link = node.val > val ? &node.left : &node.right;
+      }
+      return link;
+    }
+
+    void update_path_summaries() {
+      for (const auto idx: path | std::views::reverse) {
+        auto &node = nodes[idx];
+        node.sums.subtree = Augment::combine(Augment::combine(summary(node.left), node.sums.own),
+                                             summary(node.right));
+      }
+    }
+
+    Index allocate(T &&val) {
+      if (free_head == null) {
+        if (nodes.size() >= null)
+          throw std::length_error("ArenaBinarySearchTree is full");
+        nodes.push_back(Node{std::move(val), null, null});
+        return static_cast<Index>(nodes.size() - 1);
+      }
+      const auto idx = free_head;
+      free_head = nodes[idx].right;
+      nodes[idx] = Node{std::move(val), null, null};
+      return idx;
+    }
+
+    void release(const Index idx) {
+      // Drop whatever the value holds (e.g., the orders of a price level)
+      nodes[idx] = Node{T{}, null, free_head};
+      free_head = idx;
+    }
+
+  public:
+    [[nodiscard]] Index root() const { return root_idx; }
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] bool empty() const { return count == 0; }
+    // Nodes in the arena, used or free
+    [[nodiscard]] size_t capacity() const { return nodes.size(); }
+
+    Node &node(const Index idx) { return nodes[idx]; }
+    const Node &node(const Index idx) const { return nodes[idx]; }
+
+    // Summary of the subtree rooted at idx, empty for null
+    [[nodiscard]] Summary summary(const Index idx) const requires augmented {
+      return idx == null ? Summary{} : nodes[idx].sums.subtree;
+    }
+
+    // Returns nullptr if no value equals val. The pointer is valid until the
+    // next insert()
+    template<typename T2>
+    T *search(const T2 &val) {
+      const auto idx = *find_link(val);
+      return idx == null ? nullptr : &nodes[idx].val;
+    }
+
+    // Returns false (leaving val alone) if an equal value is in the tree
+    bool insert(T val) {
+      if constexpr (augmented)
+        path.clear();
+      Index parent = null;
+      bool to_left = false;
+      for (Index idx = root_idx; idx != null;) {
+        const auto &node = nodes[idx];
+        if (node.val == val)
+          return false;
+        if constexpr (augmented)
+          path.push_back(idx);
+        parent = idx;
+        to_left = node.val > val;
+        idx = to_left ? node.left : node.right;
+      }
+      // allocate() may grow the arena, so the parent is linked afterwards
+      const auto idx = allocate(std::move(val));
+      if (parent == null)
+        root_idx = idx;
+      else if (to_left)
+        nodes[parent].left = idx;
+      else
+        nodes[parent].right = idx;
+      if constexpr (augmented) {
+        const auto own = Augment::of(nodes[idx].val);
+        nodes[idx].sums = Sums{own, own};
+        update_path_summaries();
+      }
+      ++count;
+      return true;
+    }
+
+    // Recomputes the summaries that depend on the value equal to val after it
+    // was modified through search(), returns false if there is no such value
+    template<typename T2>
+    bool refresh(const T2 &val) requires augmented {
+      const auto idx = *find_link(val);
+      if (idx == null)
+        return false;
+      nodes[idx].sums.own = Augment::of(nodes[idx].val);
+      path.push_back(idx);
+      update_path_summaries();
+      return true;
+    }
+
+    template<typename T2>
+    bool delete_node(const T2 &val) {
+      Index *link = find_link(val);
+      const auto idx = *link;
+      if (idx == null)
+        return false;
+      auto &node = nodes[idx];
+      if (node.left == null || node.right == null) {
+        *link = node.left != null ? node.left : node.right;
+      } else {
+        // Unlink the successor (the leftmost node of the right subtree) and
+        // put it where the deleted node was
+        [[maybe_unused]] const auto ancestors = path.size();
+        Index *successor_link = &node.right;
+        while (nodes[*successor_link].left != null) {
+          if constexpr (augmented)
+            path.push_back(*successor_link);
+          successor_link = &nodes[*successor_link].left;
+        }
+        const auto successor = *successor_link;
+        *successor_link = nodes[successor].right;
+        nodes[successor].left = node.left;
+        nodes[successor].right = node.right;
+        *link = successor;
+        // The successor now sits between the ancestors and the nodes it was
+        // found under
+        if constexpr (augmented)
+          path.insert(path.begin() + static_cast<ptrdiff_t>(ancestors), successor);
+      }
+      release(idx);
+      if constexpr (augmented)
+        update_path_summaries();
+      --count;
+      return true;
+    }
+
+    struct Links {
+      using Handle = Index;
+      static constexpr Handle null = ArenaBinarySearchTree::null;
+      ArenaBinarySearchTree *tree = nullptr;
+
+      [[nodiscard]] Handle left(const Handle h) const { return tree->nodes[h].left; }
+      [[nodiscard]] Handle right(const Handle h) const { return tree->nodes[h].right; }
+      T &value(const Handle h) const { return tree->nodes[h].val; }
+    };
+
+    template<TraversalOrder Order>
+    using Iterator = BstInorderIterator<Links, Order>;
+
+    // Values in Order as a range, invalidated by insert() and delete_node()
+    template<TraversalOrder Order>
+    auto inorder() {
+      return std::ranges::subrange(Iterator<Order>(Links{this}, root_idx, true),
+                                   Iterator<Order>(Links{this}, root_idx, false));
+    }
+
+    std::vector<T> inorder_traversal() {
+      return inorder<TraversalOrder::LeftRootRight>() | std::ranges::to<std::vector<T> >();
+    }
+
+    bool is_valid_bst() const {
+      // (node, exclusive lower bound, exclusive upper bound)
+      std::vector<std::tuple<Index, const T *, const T *> > pending{{root_idx, nullptr, nullptr}};
+      while (!pending.empty()) {
+        const auto [idx, lower, upper] = pending.back();
+        pending.pop_back();
+        if (idx == null)
+          continue;
+        const auto &val = nodes[idx].val;
+        if ((lower != nullptr && !(*lower < val)) || (upper != nullptr && !(val < *upper)))
+          return false;
+        pending.emplace_back(nodes[idx].left, lower, &val);
+        pending.emplace_back(nodes[idx].right, &val, upper);
+      }
+      return true;
+    }
+  };
 } // namespace OrderBookProgrammingProblem
 
 #endif // BST_LOCKED_IMPL_H
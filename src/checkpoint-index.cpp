@@ -0,0 +1,64 @@
+#include "input/input-source-registry.h"
+#include "journal/book-checkpoint.h"
+#include "order-book/order-book-std-map.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace Problem = OrderBookProgrammingProblem;
+namespace Journal = Problem::Journal;
+
+// Replays a feed once and writes a checkpoint of the book every so many
+// lines plus an index of them, for `pricer --at=<timestamp>
+// --checkpoint-index=<index>` to start from the nearest one, e.g.:
+//   checkpoint-index pricer.idx --input-file=pricer.in --every=100000
+// Rebuilds the index (and its checkpoints) from scratch.
+int main(const int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <index-path> [--input-file=<path>] [--input=<source>] [--every=<lines>]"
+        << std::endl;
+    return 1;
+  }
+  std::string input_file;
+  std::string input_source;
+  uint64_t every = 100'000;
+  for (int i = 2; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg.starts_with("--input-file="))
+      input_file = arg.substr(std::string_view("--input-file=").size());
+    else if (arg.starts_with("--input="))
+      input_source = arg.substr(std::string_view("--input=").size());
+    else if (arg.starts_with("--every="))
+      every = std::stoull(std::string(arg.substr(std::string_view("--every=").size())));
+    else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return 1;
+    }
+  }
+  if (input_source.empty())
+    input_source = Problem::input_source_for_path(input_file);
+  if (!input_file.empty() && std::freopen(input_file.c_str(), "rb", stdin) == nullptr) {
+    std::cerr << "Failed to open " << input_file << ": " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  Journal::CheckpointIndex index(argv[1]);
+  index.clear();
+  // Checkpoints hold orders, not levels, so any book can load them
+  Problem::OrderBookStdMap<> order_book;
+  const auto line_count = Problem::visit_input_source(input_source, STDIN_FILENO, [&](auto &input) {
+    return Journal::build_checkpoint_index(order_book, input, index, every);
+  });
+  std::cerr << argv[0] << " wrote " << index.entries().size() << " checkpoint(s) over " << line_count
+      << " line(s) in " << std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+  return 0;
+}
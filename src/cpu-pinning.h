@@ -0,0 +1,46 @@
+#ifndef CPU_PINNING_H
+#define CPU_PINNING_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+namespace OrderBookProgrammingProblem {
+  // Runs the calling thread on cpu only
+  inline void pin_current_thread(const int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE)
+      throw std::invalid_argument("CPU out of range: " + std::to_string(cpu));
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    if (const int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus); err != 0)
+      throw std::system_error(err, std::generic_category(), "pthread_setaffinity_np(" + std::to_string(cpu) + ")");
+  }
+
+  // Makes the process allocate its pages on node whenever that node has free
+  // memory, called directly as glibc has no wrapper without libnuma
+  inline void prefer_numa_node(const int node) {
+    constexpr int mpol_preferred = 1;
+    if (node < 0 || node >= static_cast<int>(sizeof(unsigned long) * 8))
+      throw std::invalid_argument("NUMA node out of range: " + std::to_string(node));
+    const unsigned long nodes = 1UL << node;
+    if (syscall(SYS_set_mempolicy, mpol_preferred, &nodes, sizeof(nodes) * 8) != 0)
+      throw std::system_error(errno, std::generic_category(), "set_mempolicy(" + std::to_string(node) + ")");
+  }
+
+  // Locks the current and future pages of the process in memory, usually
+  // needs a raised RLIMIT_MEMLOCK or CAP_IPC_LOCK
+  inline void lock_process_memory() {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+      throw std::system_error(errno, std::generic_category(), "mlockall()");
+  }
+} // namespace OrderBookProgrammingProblem
+
+#endif // CPU_PINNING_H
@@ -0,0 +1,187 @@
+#ifndef DEPTH_KERNEL_H
+#define DEPTH_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DEPTH_KERNEL_HAS_AVX2 1
+#else
+#define DEPTH_KERNEL_HAS_AVX2 0
+#endif
+
+// Kernels answering "what does target_size cost" over structure-of-arrays
+// depth, i.e., a prefix sum of sizes searched for target_size together with
+// the prefix sum of price * size up to that point, and the inverse queries
+// (total size of a range of levels, size a budget buys). Levels are walked
+// from index 0 upwards (ascending) or from index n - 1 downwards
+// (descending), empty levels must have a size of 0. All sums use 64-bit
+// accumulators.
+namespace OrderBookProgrammingProblem::DepthKernel {
+  template<bool Descending>
+  std::optional<int64_t> fill_cost_cent_scalar(const int32_t *prices,
+                                               const int32_t *sizes,
+                                               const size_t n,
+                                               int64_t target_size) {
+    int64_t cost_cent = 0;
+    for (size_t k = 0; k < n; ++k) {
+      const auto i = Descending ? n - 1 - k : k;
+      if (target_size > sizes[i]) {
+        target_size -= sizes[i];
+        cost_cent += static_cast<int64_t>(prices[i]) * sizes[i];
+      } else {
+        return cost_cent + target_size * prices[i];
+      }
+    }
+    return std::nullopt;
+  }
+
+  inline int64_t total_size_scalar(const int32_t *sizes, const size_t n) {
+    int64_t total = 0;
+    for (size_t i = 0; i < n; ++i)
+      total += sizes[i];
+    return total;
+  }
+
+  // Levels are taken whole while their notional fits in what is left of the
+  // budget, then the level where it runs out gives what it can afford
+  template<bool Descending>
+  int64_t size_within_budget_scalar(const int32_t *prices, const int32_t *sizes, const size_t n,
+                                    int64_t budget_cent) {
+    int64_t size = 0;
+    for (size_t k = 0; k < n; ++k) {
+      const auto i = Descending ? n - 1 - k : k;
+      const auto notional = static_cast<int64_t>(prices[i]) * sizes[i];
+      if (notional > budget_cent)
+        return size + budget_cent / prices[i];
+      budget_cent -= notional;
+      size += sizes[i];
+    }
+    return size;
+  }
+
+#if DEPTH_KERNEL_HAS_AVX2
+  __attribute__((target("avx2"))) inline int64_t horizontal_sum_epi64(const __m256i v) {
+    const __m128i sum2 = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return _mm_cvtsi128_si64(sum2) + _mm_extract_epi64(sum2, 1);
+  }
+
+  __attribute__((target("avx2"))) inline int64_t total_size_avx2(const int32_t *sizes, const size_t n) {
+    constexpr size_t lanes = 8;
+    __m256i acc = _mm256_setzero_si256();
+    size_t done = 0;
+    for (; done + lanes <= n; done += lanes) {
+      const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sizes + done));
+      acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(s)));
+      acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(s, 1)));
+    }
+    return horizontal_sum_epi64(acc) + total_size_scalar(sizes + done, n - done);
+  }
+
+  // Takes blocks of 8 levels whole while their notional fits in the budget
+  template<bool Descending>
+  __attribute__((target("avx2"))) int64_t
+  size_within_budget_avx2(const int32_t *prices, const int32_t *sizes, const size_t n, int64_t budget_cent) {
+    constexpr size_t lanes = 8;
+    int64_t size = 0;
+    size_t done = 0;
+    for (; done + lanes <= n; done += lanes) {
+      const auto first = Descending ? n - done - lanes : done;
+      const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sizes + first));
+      const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(prices + first));
+      const __m256i s_lo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(s));
+      const __m256i s_hi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(s, 1));
+      const __m256i p_lo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(p));
+      const __m256i p_hi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(p, 1));
+      const int64_t block_notional = horizontal_sum_epi64(
+        _mm256_add_epi64(_mm256_mul_epi32(p_lo, s_lo), _mm256_mul_epi32(p_hi, s_hi)));
+      if (block_notional > budget_cent)
+        break;
+      budget_cent -= block_notional;
+      size += horizontal_sum_epi64(_mm256_add_epi64(s_lo, s_hi));
+    }
+    return size + (Descending
+                     ? size_within_budget_scalar<Descending>(prices, sizes, n - done, budget_cent)
+                     : size_within_budget_scalar<Descending>(prices + done, sizes + done, n - done, budget_cent));
+  }
+
+  // Sums a block of 8 levels at once and only falls back to the scalar walk
+  // for the block in which target_size is reached
+  template<bool Descending>
+  __attribute__((target("avx2"))) std::optional<int64_t>
+  fill_cost_cent_avx2(const int32_t *prices, const int32_t *sizes,
+                      const size_t n, int64_t target_size) {
+    constexpr size_t lanes = 8;
+    __m256i notional_acc = _mm256_setzero_si256();
+    size_t done = 0;
+    for (; done + lanes <= n; done += lanes) {
+      const auto first = Descending ? n - done - lanes : done;
+      const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sizes + first));
+      const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(prices + first));
+      const __m256i s_lo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(s));
+      const __m256i s_hi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(s, 1));
+      const __m256i s_sum4 = _mm256_add_epi64(s_lo, s_hi);
+      const __m128i s_sum2 = _mm_add_epi64(_mm256_castsi256_si128(s_sum4),
+                                           _mm256_extracti128_si256(s_sum4, 1));
+      const int64_t block_size = _mm_cvtsi128_si64(s_sum2) + _mm_extract_epi64(s_sum2, 1);
+      if (target_size <= block_size)
+        break;
+      target_size -= block_size;
+      const __m256i p_lo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(p));
+      const __m256i p_hi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(p, 1));
+      notional_acc = _mm256_add_epi64(notional_acc, _mm256_mul_epi32(p_lo, s_lo));
+      notional_acc = _mm256_add_epi64(notional_acc, _mm256_mul_epi32(p_hi, s_hi));
+    }
+    const __m128i acc2 = _mm_add_epi64(_mm256_castsi256_si128(notional_acc),
+                                       _mm256_extracti128_si256(notional_acc, 1));
+    const int64_t cost_cent = _mm_cvtsi128_si64(acc2) + _mm_extract_epi64(acc2, 1);
+    // The remaining levels are [0, n - done) for descending walks and
+    // [done, n) for ascending ones
+    const auto rest = Descending
+                        ? fill_cost_cent_scalar<Descending>(prices, sizes, n - done, target_size)
+                        : fill_cost_cent_scalar<Descending>(prices + done, sizes + done, n - done,
+                                                            target_size);
+    if (!rest.has_value())
+      return std::nullopt;
+    return cost_cent + rest.value();
+  }
+
+  inline bool cpu_supports_avx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+  }
+#endif
+
+  template<bool Descending>
+  std::optional<int64_t> fill_cost_cent(const int32_t *prices,
+                                        const int32_t *sizes, const size_t n,
+                                        const int64_t target_size) {
+#if DEPTH_KERNEL_HAS_AVX2
+    if (cpu_supports_avx2())
+      return fill_cost_cent_avx2<Descending>(prices, sizes, n, target_size);
+#endif
+    return fill_cost_cent_scalar<Descending>(prices, sizes, n, target_size);
+  }
+
+  inline int64_t total_size(const int32_t *sizes, const size_t n) {
+#if DEPTH_KERNEL_HAS_AVX2
+    if (cpu_supports_avx2())
+      return total_size_avx2(sizes, n);
+#endif
+    return total_size_scalar(sizes, n);
+  }
+
+  template<bool Descending>
+  int64_t size_within_budget(const int32_t *prices, const int32_t *sizes, const size_t n,
+                             const int64_t budget_cent) {
+#if DEPTH_KERNEL_HAS_AVX2
+    if (cpu_supports_avx2())
+      return size_within_budget_avx2<Descending>(prices, sizes, n, budget_cent);
+#endif
+    return size_within_budget_scalar<Descending>(prices, sizes, n, budget_cent);
+  }
+} // namespace OrderBookProgrammingProblem::DepthKernel
+
+#endif // DEPTH_KERNEL_H
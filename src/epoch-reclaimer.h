@@ -0,0 +1,106 @@
+#ifndef EPOCH_RECLAIMER_H
+#define EPOCH_RECLAIMER_H
+
+#include "aligned-allocator.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+namespace OrderBookProgrammingProblem {
+  // Epoch based reclamation for a single writer: memory that readers may still
+  // be looking at is retired instead of freed, and only freed once every reader
+  // pinned at the time of retirement has unpinned. Readers never block the
+  // writer, the writer never waits for readers.
+  class EpochReclaimer {
+  public:
+    static constexpr size_t max_readers = 64;
+
+  private:
+    static constexpr uint64_t idle = UINT64_MAX;
+
+    struct alignas(cache_line_size) ReaderSlot {
+      std::atomic<uint64_t> epoch{idle};
+      std::atomic<bool> in_use{false};
+    };
+
+    std::atomic<uint64_t> global_epoch{0};
+    std::array<ReaderSlot, max_readers> slots;
+    // Writer only, (epoch at retirement, deleter) pairs
+    std::vector<std::pair<uint64_t, std::function<void()> > > retired;
+
+  public:
+    // Pins a reader slot for the lifetime of the guard
+    class Guard {
+      ReaderSlot &slot;
+
+    public:
+      Guard(EpochReclaimer &reclaimer, const size_t reader) : slot(reclaimer.slots[reader]) {
+        slot.epoch.store(reclaimer.global_epoch.load(std::memory_order_seq_cst),
+                         std::memory_order_seq_cst);
+      }
+
+      Guard(const Guard &) = delete;
+
+      Guard &operator=(const Guard &) = delete;
+
+      ~Guard() { slot.epoch.store(idle, std::memory_order_release); }
+    };
+
+    EpochReclaimer() = default;
+
+    EpochReclaimer(const EpochReclaimer &) = delete;
+
+    EpochReclaimer &operator=(const EpochReclaimer &) = delete;
+
+    // Returns a slot index to be passed to Guard by one reader thread
+    size_t register_reader() {
+      for (size_t i = 0; i < max_readers; ++i) {
+        bool expected = false;
+        if (slots[i].in_use.compare_exchange_strong(expected, true))
+          return i;
+      }
+      throw std::runtime_error("Too many concurrent readers");
+    }
+
+    void unregister_reader(const size_t reader) {
+      slots[reader].in_use.store(false, std::memory_order_release);
+    }
+
+    // Called by the writer once nothing new can reach the retired memory
+    void retire(std::function<void()> deleter) {
+      retired.emplace_back(global_epoch.fetch_add(1, std::memory_order_seq_cst),
+                           std::move(deleter));
+      reclaim();
+    }
+
+    void reclaim() {
+      if (retired.empty())
+        return;
+      uint64_t oldest_pinned = idle;
+      for (const auto &slot: slots)
+        oldest_pinned = std::min(oldest_pinned, slot.epoch.load(std::memory_order_seq_cst));
+      std::erase_if(retired, [&](auto &item) {
+        if (item.first >= oldest_pinned)
+          return false;
+        item.second();
+        return true;
+      });
+    }
+
+    [[nodiscard]] size_t retired_count() const { return retired.size(); }
+
+    // Readers must be gone by now
+    ~EpochReclaimer() {
+      for (auto &deleter: retired | std::views::values)
+        deleter();
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // EPOCH_RECLAIMER_H
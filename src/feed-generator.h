@@ -0,0 +1,66 @@
+#ifndef FEED_GENERATOR_H
+#define FEED_GENERATOR_H
+
+#include "order.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <format>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace OrderBookProgrammingProblem {
+  // Synthetic feed in the shape of pricer.in: adds around a mid price doing a
+  // random walk from 44.20 and reduces of live orders only, so any book must
+  // accept all of it. At most max_live orders rest in the book at a time. The
+  // same seed always gives the same feed. Adds land up to price_spread cents
+  // away from the mid, a small spread concentrates the book (and the fills)
+  // in a few levels around the top of the book.
+  inline std::vector<Order::LimitOrder> generate_synthetic_feed(const size_t n, const uint64_t seed,
+                                                                const size_t max_live = 2'000,
+                                                                const int price_spread = 50) {
+    constexpr std::array sizes = {10, 50, 100, 157, 200, 1000};
+    std::mt19937_64 gen(seed);
+    std::vector<Order::LimitOrder> feed;
+    feed.reserve(n);
+    // Live order ids, plus their position in live_ids and remaining size
+    std::vector<std::string> live_ids;
+    std::unordered_map<std::string, std::pair<size_t, int> > live;
+    int mid_cent = 4420;
+    uint64_t timestamp = 28'800'000;
+    for (size_t i = 0; i < n; ++i) {
+      Order::LimitOrder lo;
+      lo.timestamp = timestamp += gen() % 3;
+      if (!live_ids.empty() && (live_ids.size() >= max_live || gen() % 100 < 45)) {
+        lo.type = Order::Type::Reduce;
+        lo.id = live_ids[gen() % live_ids.size()];
+        auto &[pos, remaining] = live.at(lo.id);
+        lo.size = gen() % 2 ? remaining : 1 + static_cast<int>(gen() % remaining);
+        remaining -= lo.size;
+        if (remaining == 0) {
+          live.at(live_ids.back()).first = pos;
+          std::swap(live_ids[pos], live_ids.back());
+          live_ids.pop_back();
+          live.erase(lo.id);
+        }
+      } else {
+        mid_cent = std::clamp(mid_cent + static_cast<int>(gen() % 3) - 1, 1'000, 9'000);
+        lo.type = Order::Type::Add;
+        lo.id = std::format("{:x}", i);
+        lo.side = gen() % 2 ? Order::Side::Bid : Order::Side::Ask;
+        const auto offset = static_cast<int>(gen() % price_spread);
+        lo.price_cent = lo.side == Order::Side::Bid ? mid_cent - 1 - offset : mid_cent + offset;
+        lo.size = sizes[gen() % sizes.size()];
+        live.emplace(lo.id, std::pair(live_ids.size(), lo.size));
+        live_ids.push_back(lo.id);
+      }
+      feed.push_back(std::move(lo));
+    }
+    return feed;
+  }
+} // namespace OrderBookProgrammingProblem
+
+#endif // FEED_GENERATOR_H
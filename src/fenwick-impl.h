@@ -0,0 +1,82 @@
+#ifndef FENWICK_IMPL_H
+#define FENWICK_IMPL_H
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <vector>
+
+namespace OrderBookProgrammingProblem {
+  // Fenwick (binary indexed) tree over n values, all 0 initially: point
+  // updates and prefix sums in O(log n). The search functions assume that no
+  // value is negative, i.e., that prefix sums never decrease.
+  template<typename T>
+    requires std::integral<T> || std::floating_point<T>
+  class FenwickTree {
+    // tree[i] (1-based) holds the sum of the (i & -i) values ending at i
+    std::vector<T> tree{T{0}};
+
+    [[nodiscard]] static size_t lowbit(const size_t i) { return i & (~i + 1); }
+
+  public:
+    [[nodiscard]] size_t size() const { return tree.size() - 1; }
+
+    // Grows to n values keeping the current ones, new values are 0. Shrinking
+    // is not supported, callers zero the values they no longer need
+    void grow(const size_t n) {
+      const auto old_size = size();
+      if (n <= old_size)
+        return;
+      // Undo the partial sums, extend, and build again, both in O(n)
+      for (auto i = old_size; i >= 1; --i) {
+        if (const auto parent = i + lowbit(i); parent <= old_size)
+          tree[parent] -= tree[i];
+      }
+      tree.resize(n + 1, T{0});
+      for (size_t i = 1; i <= n; ++i) {
+        if (const auto parent = i + lowbit(i); parent <= n)
+          tree[parent] += tree[i];
+      }
+    }
+
+    void add(const size_t idx, const T delta) {
+      for (auto i = idx + 1; i <= size(); i += lowbit(i))
+        tree[i] += delta;
+    }
+
+    // Sum of the first count values
+    [[nodiscard]] T prefix_sum(size_t count) const {
+      T sum{0};
+      for (; count > 0; count -= lowbit(count))
+        sum += tree[count];
+      return sum;
+    }
+
+    [[nodiscard]] T total() const { return prefix_sum(size()); }
+
+    // Largest count such that prefix_sum(count) < limit
+    [[nodiscard]] size_t count_below(const T limit) const { return search<true>(limit); }
+
+    // Largest count such that prefix_sum(count) <= limit
+    [[nodiscard]] size_t count_at_most(const T limit) const { return search<false>(limit); }
+
+  private:
+    // Binary lifting: descends from the largest power of two, each tree[] entry
+    // taken covers the next block of values, so this is O(log n) rather than
+    // a binary search over prefix_sum()
+    template<bool Strict>
+    [[nodiscard]] size_t search(T limit) const {
+      size_t count = 0;
+      for (auto step = std::bit_floor(size()); step > 0; step >>= 1) {
+        const auto next = count + step;
+        if (next <= size() && (Strict ? tree[next] < limit : tree[next] <= limit)) {
+          count = next;
+          limit -= tree[next];
+        }
+      }
+      return count;
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // FENWICK_IMPL_H
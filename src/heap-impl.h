@@ -1,7 +1,10 @@
 #ifndef HEAP_IMPL_H
 #define HEAP_IMPL_H
 
+#include <algorithm>
+#include <functional>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace PoC::OrderBook {
@@ -72,5 +75,161 @@ namespace PoC::OrderBook {
 
         [[nodiscard]] size_t size() const { return m_data.size(); }
     };
+
+    /* Binary heap of (key, value) entries that tracks the position of every
+     * entry, so that an entry can be re-keyed or erased in O(log n) through the
+     * handle push() returned. Compare(a, b) == true means a goes above b, i.e.,
+     * std::less gives a min-heap. Values never move once pushed, the heap only
+     * shuffles (key, handle) pairs.
+     */
+    template<typename Key, typename Value, typename Compare = std::less<Key> >
+    class IndexedHeap {
+    public:
+        using Handle = size_t;
+
+    private:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        std::vector<std::pair<Key, Handle> > m_data;
+        // Per handle: position in m_data (npos once erased) and value
+        std::vector<size_t> m_pos;
+        std::vector<Value> m_values;
+        std::vector<Handle> m_free_handles;
+        // Scratch space of for_each_in_order()
+        mutable std::vector<size_t> m_frontier;
+        [[no_unique_address]] Compare m_compare;
+
+        void place(const size_t idx, std::pair<Key, Handle> entry) {
+            m_pos[entry.second] = idx;
+            m_data[idx] = std::move(entry);
+        }
+
+        void sift_up(size_t idx) {
+            auto entry = std::move(m_data[idx]);
+            while (idx > 0) {
+                const size_t parent = (idx - 1) / 2;
+                if (!m_compare(entry.first, m_data[parent].first))
+                    break;
+                place(idx, std::move(m_data[parent]));
+                idx = parent;
+            }
+            place(idx, std::move(entry));
+        }
+
+        void sift_down(size_t idx) {
+            auto entry = std::move(m_data[idx]);
+            while (true) {
+                auto child = (2 * idx) + 1;
+                if (child >= m_data.size())
+                    break;
+                if (child + 1 < m_data.size() && m_compare(m_data[child + 1].first, m_data[child].first))
+                    ++child;
+                if (!m_compare(m_data[child].first, entry.first))
+                    break;
+                place(idx, std::move(m_data[child]));
+                idx = child;
+            }
+            place(idx, std::move(entry));
+        }
+
+        void check(const Handle handle) const {
+            if (handle >= m_pos.size() || m_pos[handle] == npos)
+                throw std::out_of_range("Invalid heap handle");
+        }
+
+    public:
+        Handle push(const Key &key, Value value) {
+            Handle handle;
+            if (!m_free_handles.empty()) {
+                handle = m_free_handles.back();
+                m_free_handles.pop_back();
+                m_values[handle] = std::move(value);
+            } else {
+                handle = m_pos.size();
+                m_pos.push_back(npos);
+                m_values.push_back(std::move(value));
+            }
+            m_data.emplace_back(key, handle);
+            m_pos[handle] = m_data.size() - 1;
+            sift_up(m_data.size() - 1);
+            return handle;
+        }
+
+        [[nodiscard]] Handle top() const {
+            if (m_data.empty()) {
+                throw std::out_of_range("Heap is empty");
+            }
+            return m_data[0].second;
+        }
+
+        void pop() { erase(top()); }
+
+        void erase(const Handle handle) {
+            check(handle);
+            const auto idx = m_pos[handle];
+            m_pos[handle] = npos;
+            m_values[handle] = Value{};
+            m_free_handles.push_back(handle);
+            auto last = std::move(m_data.back());
+            m_data.pop_back();
+            if (idx == m_data.size())
+                return;
+            const auto moved = last.second;
+            place(idx, std::move(last));
+            sift_up(idx);
+            sift_down(m_pos[moved]);
+        }
+
+        // Moves the entry up or down, i.e., both decrease-key and increase-key
+        void update_key(const Handle handle, const Key &key) {
+            check(handle);
+            const auto idx = m_pos[handle];
+            m_data[idx].first = key;
+            sift_up(idx);
+            sift_down(m_pos[handle]);
+        }
+
+        [[nodiscard]] const Key &key(const Handle handle) const {
+            check(handle);
+            return m_data[m_pos[handle]].first;
+        }
+
+        Value &value(const Handle handle) {
+            check(handle);
+            return m_values[handle];
+        }
+
+        /* Calls f(key, handle) for the entries from the top downwards in
+         * Compare order until f returns false. Only the entries handed out
+         * plus their children are looked at, so visiting the best k entries
+         * takes O(k log k) however large the heap is.
+         */
+        template<typename F>
+        void for_each_in_order(F &&f) const {
+            if (m_data.empty())
+                return;
+            const auto worse = [&](const size_t a, const size_t b) {
+                return m_compare(m_data[b].first, m_data[a].first);
+            };
+            m_frontier.clear();
+            m_frontier.push_back(0);
+            while (!m_frontier.empty()) {
+                std::ranges::pop_heap(m_frontier, worse);
+                const auto idx = m_frontier.back();
+                m_frontier.pop_back();
+                if (!f(m_data[idx].first, m_data[idx].second))
+                    return;
+                for (const auto child: {(2 * idx) + 1, (2 * idx) + 2}) {
+                    if (child < m_data.size()) {
+                        m_frontier.push_back(child);
+                        std::ranges::push_heap(m_frontier, worse);
+                    }
+                }
+            }
+        }
+
+        [[nodiscard]] size_t size() const { return m_data.size(); }
+        [[nodiscard]] bool empty() const { return m_data.empty(); }
+    };
 } // namespace PoC::OrderBook
 #endif // HEAP_IMPL_H
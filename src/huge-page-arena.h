@@ -0,0 +1,163 @@
+#ifndef HUGE_PAGE_ARENA_H
+#define HUGE_PAGE_ARENA_H
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace OrderBookProgrammingProblem {
+  // Fixed-size memory arena backed by 2 MiB pages, every page faulted in up
+  // front so that neither TLB misses on 4 KiB pages nor page faults hit the
+  // hot path as the book grows. Explicit huge pages (MAP_HUGETLB) are used
+  // when the system reserved enough of them, transparent huge pages otherwise.
+  //
+  // Blocks are power-of-two sized, from 16 B up to the whole arena: small
+  // blocks are carved out of 64 KiB chunks dedicated to their size, larger
+  // ones take whole chunks, and freed blocks go to a free list per size. A
+  // block starts at a multiple of its size from the huge page aligned base,
+  // so any alignment up to the block size, or the huge page size if that is
+  // smaller, is met. Not thread-safe.
+  class HugePageArena {
+  public:
+    static constexpr size_t huge_page_size = size_t{2} << 20;
+
+  private:
+    static constexpr unsigned min_size_class = 4;
+    static constexpr unsigned chunk_size_class = 16;
+    static constexpr size_t chunk_size = size_t{1} << chunk_size_class;
+
+    std::byte *base = nullptr;
+    size_t length = 0;
+    bool explicit_huge_pages = false;
+    // Next chunk never handed out
+    std::byte *top = nullptr;
+    // Size class of every chunk, for a large block only its first chunk's
+    std::vector<uint8_t> chunk_classes;
+    std::array<void *, 64> free_lists{};
+    // Unused part of the current chunk of each small size class
+    std::array<std::byte *, chunk_size_class> chunk_next{};
+    std::array<std::byte *, chunk_size_class> chunk_end{};
+
+    [[nodiscard]] static unsigned size_class(const size_t size, const size_t alignment) {
+      const auto needed = std::max({size, alignment, size_t{1} << min_size_class});
+      return static_cast<unsigned>(std::bit_width(needed - 1));
+    }
+
+    void push_free(std::byte *block, const unsigned cls) {
+      chunk_classes[static_cast<size_t>(block - base) / chunk_size] = static_cast<uint8_t>(cls);
+      *reinterpret_cast<void **>(block) = free_lists[cls];
+      free_lists[cls] = block;
+    }
+
+    // The chunks skipped to reach a multiple of the block size go to the
+    // free lists, as the largest blocks that still start at a multiple of
+    // their own size
+    std::byte *take_chunks(const size_t count, const unsigned cls) {
+      const auto block_size = count * chunk_size;
+      auto offset = static_cast<size_t>(top - base);
+      const auto start = (offset + block_size - 1) / block_size * block_size;
+      if (start > length || length - start < block_size)
+        return nullptr;
+      while (offset < start) {
+        const auto piece_cls = std::min(static_cast<unsigned>(std::countr_zero(offset)),
+                                        static_cast<unsigned>(std::bit_width(start - offset)) - 1);
+        push_free(base + offset, piece_cls);
+        offset += size_t{1} << piece_cls;
+      }
+      top = base + start + block_size;
+      chunk_classes[start / chunk_size] = static_cast<uint8_t>(cls);
+      return base + start;
+    }
+
+  public:
+    // bytes is rounded up to a whole number of huge pages
+    explicit HugePageArena(const size_t bytes) {
+      length = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+      if (length == 0)
+        throw std::invalid_argument("Empty huge page arena");
+      void *addr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+      explicit_huge_pages = addr != MAP_FAILED;
+      if (!explicit_huge_pages) {
+        // Over-map so the arena can start on a huge page boundary, which
+        // transparent huge pages need
+        addr = mmap(nullptr, length + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED)
+          throw std::system_error(errno, std::generic_category(), "mmap(huge page arena)");
+        const auto addr_int = reinterpret_cast<uintptr_t>(addr);
+        const auto aligned = (addr_int + huge_page_size - 1) / huge_page_size * huge_page_size;
+        if (aligned > addr_int)
+          munmap(addr, aligned - addr_int);
+        munmap(reinterpret_cast<void *>(aligned + length), addr_int + huge_page_size - aligned);
+        addr = reinterpret_cast<void *>(aligned);
+        madvise(addr, length, MADV_HUGEPAGE);
+        // Fault the arena in now rather than on first use
+        std::memset(addr, 0, length);
+      }
+      base = top = static_cast<std::byte *>(addr);
+      chunk_classes.resize(length / chunk_size);
+    }
+
+    HugePageArena(const HugePageArena &) = delete;
+
+    HugePageArena &operator=(const HugePageArena &) = delete;
+
+    ~HugePageArena() { munmap(base, length); }
+
+    [[nodiscard]] size_t size() const { return length; }
+
+    [[nodiscard]] size_t used() const { return static_cast<size_t>(top - base); }
+
+    [[nodiscard]] std::string_view backing() const {
+      return explicit_huge_pages ? "hugetlb" : "transparent huge pages";
+    }
+
+    [[nodiscard]] bool contains(const void *p) const {
+      return p >= base && p < base + length;
+    }
+
+    // Returns nullptr once the arena cannot fit the block, or for an
+    // alignment beyond the huge page size
+    [[nodiscard]] void *allocate(const size_t size, const size_t alignment = alignof(std::max_align_t)) {
+      if (alignment > huge_page_size)
+        return nullptr;
+      const auto cls = size_class(size, alignment);
+      if (cls >= free_lists.size())
+        return nullptr;
+      if (void *block = free_lists[cls]; block != nullptr) {
+        free_lists[cls] = *static_cast<void **>(block);
+        return block;
+      }
+      if (cls >= chunk_size_class)
+        return take_chunks(size_t{1} << (cls - chunk_size_class), cls);
+      if (chunk_next[cls] == chunk_end[cls]) {
+        auto *chunk = take_chunks(1, cls);
+        if (chunk == nullptr)
+          return nullptr;
+        chunk_next[cls] = chunk;
+        chunk_end[cls] = chunk + chunk_size;
+      }
+      auto *block = chunk_next[cls];
+      chunk_next[cls] += size_t{1} << cls;
+      return block;
+    }
+
+    // p must come from allocate()
+    void deallocate(void *p) {
+      auto *block = static_cast<std::byte *>(p);
+      push_free(block, chunk_classes[static_cast<size_t>(block - base) / chunk_size]);
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // HUGE_PAGE_ARENA_H
@@ -0,0 +1,229 @@
+#ifndef DECOMPRESSING_BLOCK_READER_H
+#define DECOMPRESSING_BLOCK_READER_H
+
+#include "../aligned-allocator.h"
+
+#include <unistd.h>
+#include <zlib.h>
+
+#if defined(HAS_ZSTD) && (HAS_ZSTD == 1)
+#include <zstd.h>
+#endif
+
+#include <cerrno>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace OrderBookProgrammingProblem {
+  // Inflates gzip (and zlib) streams, concatenated members included, as
+  // written by gzip(1) and friends
+  class GzipDecoder {
+    z_stream stream{};
+    bool in_member = false;
+
+  public:
+    GzipDecoder() {
+      // 15 + 32: largest window, detect the gzip or zlib header
+      if (inflateInit2(&stream, 15 + 32) != Z_OK)
+        throw std::runtime_error("inflateInit2() failed");
+    }
+
+    GzipDecoder(const GzipDecoder &) = delete;
+
+    GzipDecoder &operator=(const GzipDecoder &) = delete;
+
+    ~GzipDecoder() { inflateEnd(&stream); }
+
+    // True if the input ended now, it would be truncated
+    [[nodiscard]] bool mid_stream() const { return in_member; }
+
+    // Consumes a prefix of input and returns the number of bytes written to
+    // output
+    size_t decode(std::span<const char> &input, const std::span<char> output) {
+      stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+      stream.avail_in = static_cast<uInt>(input.size());
+      stream.next_out = reinterpret_cast<Bytef *>(output.data());
+      stream.avail_out = static_cast<uInt>(output.size());
+      const auto ret = inflate(&stream, Z_NO_FLUSH);
+      if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+        throw std::runtime_error(std::string("inflate() failed: ") + (stream.msg ? stream.msg : "unknown error"));
+      if (stream.avail_in < input.size())
+        in_member = true;
+      input = input.subspan(input.size() - stream.avail_in);
+      if (ret == Z_STREAM_END) {
+        inflateReset(&stream);
+        in_member = false;
+      }
+      return output.size() - stream.avail_out;
+    }
+  };
+
+#if defined(HAS_ZSTD) && (HAS_ZSTD == 1)
+  class ZstdDecoder {
+    ZSTD_DCtx *context = ZSTD_createDCtx();
+    bool in_frame = false;
+
+  public:
+    ZstdDecoder() {
+      if (context == nullptr)
+        throw std::runtime_error("ZSTD_createDCtx() failed");
+    }
+
+    ZstdDecoder(const ZstdDecoder &) = delete;
+
+    ZstdDecoder &operator=(const ZstdDecoder &) = delete;
+
+    ~ZstdDecoder() { ZSTD_freeDCtx(context); }
+
+    [[nodiscard]] bool mid_stream() const { return in_frame; }
+
+    size_t decode(std::span<const char> &input, const std::span<char> output) {
+      ZSTD_inBuffer in{input.data(), input.size(), 0};
+      ZSTD_outBuffer out{output.data(), output.size(), 0};
+      const auto ret = ZSTD_decompressStream(context, &out, &in);
+      if (ZSTD_isError(ret))
+        throw std::runtime_error(std::string("ZSTD_decompressStream() failed: ") + ZSTD_getErrorName(ret));
+      input = input.subspan(in.pos);
+      // 0 means a frame was completely decoded and flushed
+      in_frame = ret != 0;
+      return out.pos;
+    }
+  };
+#endif
+
+  // Decompresses fd on a dedicated thread into a ring of block_count blocks,
+  // so that decompression overlaps with the book updates of the consumer.
+  // Decoder provides size_t decode(std::span<const char> &input,
+  // std::span<char> output) and bool mid_stream(), see GzipDecoder.
+  template<typename Decoder>
+  class DecompressingBlockReader {
+    struct Block {
+      std::vector<char, AlignedAllocator<char> > data;
+      size_t size = 0;
+    };
+
+    int fd;
+    std::vector<Block> blocks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    // Blocks filled by the decompression thread and blocks given back by the
+    // consumer so far, block i lives in blocks[i % blocks.size()]
+    size_t filled = 0;
+    size_t released = 0;
+    // Set by the decompression thread once filled stops growing
+    bool finished = false;
+    bool stopping = false;
+    std::exception_ptr error;
+    bool handed_out = false;
+    std::jthread worker;
+
+    void run() {
+      try {
+        Decoder decoder;
+        std::vector<char> compressed(1 << 16);
+        std::span<const char> input;
+        bool end_of_input = false;
+        while (true) {
+          {
+            std::unique_lock lock(mutex);
+            cv.wait(lock, [&] { return stopping || filled - released < blocks.size(); });
+            if (stopping)
+              return;
+          }
+          // The slot is free until filled is bumped, no lock needed meanwhile
+          auto &block = blocks[filled % blocks.size()];
+          block.size = 0;
+          while (block.size < block.data.size()) {
+            if (input.empty()) {
+              if (end_of_input) {
+                if (decoder.mid_stream())
+                  throw std::runtime_error("Truncated compressed input");
+                break;
+              }
+              const auto n = read(fd, compressed.data(), compressed.size());
+              if (n < 0) {
+                if (errno == EINTR)
+                  continue;
+                throw std::system_error(errno, std::generic_category(), "read()");
+              }
+              end_of_input = n == 0;
+              input = {compressed.data(), static_cast<size_t>(n)};
+              continue;
+            }
+            const auto input_size = input.size();
+            const auto produced = decoder.decode(
+              input, std::span(block.data).subspan(block.size));
+            if (produced == 0 && input.size() == input_size)
+              throw std::runtime_error("Corrupt compressed input");
+            block.size += produced;
+          }
+          std::lock_guard lock(mutex);
+          if (block.size == 0) {
+            finished = true;
+            cv.notify_all();
+            return;
+          }
+          ++filled;
+          cv.notify_all();
+        }
+      } catch (...) {
+        std::lock_guard lock(mutex);
+        error = std::current_exception();
+        finished = true;
+        cv.notify_all();
+      }
+    }
+
+  public:
+    static constexpr size_t default_block_size = 1 << 20;
+    static constexpr size_t default_block_count = 4;
+
+    explicit DecompressingBlockReader(const int input_fd, const size_t block_size = default_block_size,
+                                      const size_t block_count = default_block_count)
+      : fd(input_fd), blocks(block_count) {
+      for (auto &block: blocks)
+        block.data.resize(block_size);
+      worker = std::jthread([this] { run(); });
+    }
+
+    DecompressingBlockReader(const DecompressingBlockReader &) = delete;
+
+    DecompressingBlockReader &operator=(const DecompressingBlockReader &) = delete;
+
+    ~DecompressingBlockReader() {
+      {
+        std::lock_guard lock(mutex);
+        stopping = true;
+      }
+      cv.notify_all();
+    }
+
+    // The returned block stays valid until the next call
+    std::span<const char> next_block() {
+      std::unique_lock lock(mutex);
+      if (handed_out) {
+        handed_out = false;
+        ++released;
+        cv.notify_all();
+      }
+      cv.wait(lock, [&] { return filled > released || finished; });
+      if (filled > released) {
+        handed_out = true;
+        const auto &block = blocks[released % blocks.size()];
+        return {block.data.data(), block.size};
+      }
+      if (error)
+        std::rethrow_exception(error);
+      return {};
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // DECOMPRESSING_BLOCK_READER_H
@@ -0,0 +1,76 @@
+#ifndef INPUT_SOURCE_REGISTRY_H
+#define INPUT_SOURCE_REGISTRY_H
+
+#include "decompressing-block-reader.h"
+#include "input-source.h"
+#include "io-uring-block-reader.h"
+
+#include <array>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace OrderBookProgrammingProblem {
+#if defined(HAS_ZSTD) && (HAS_ZSTD == 1)
+  inline constexpr std::array<std::string_view, 5> input_source_names = {
+    "io-uring", "read", "stream", "gzip", "zstd"
+  };
+#else
+  inline constexpr std::array<std::string_view, 4> input_source_names = {
+    "io-uring", "read", "stream", "gzip"
+  };
+#endif
+
+  // Input source matching the extension of a file name, e.g., "gzip" for
+  // "pricer.in.gz"
+  inline std::string_view input_source_for_path(const std::string_view path) {
+    if (path.ends_with(".gz"))
+      return "gzip";
+    if (path.ends_with(".zst"))
+      return "zstd";
+    return "io-uring";
+  }
+
+  // Calls f(source) with the input source registered under name reading fd,
+  // "stream" always reads std::cin. "io-uring" falls back to "read" if io_uring
+  // can't be used for fd (e.g., fd is a pipe). "gzip" and "zstd" decompress fd
+  // on a separate thread
+  template<typename F>
+  decltype(auto) visit_input_source(std::string_view name, const int fd, F &&f) {
+    if (name == "io-uring") {
+      std::optional<BlockInputSource<IoUringBlockReader> > source;
+      try {
+        source.emplace(fd);
+      } catch (const std::system_error &) {
+      }
+      if (source.has_value())
+        return f(source.value());
+      name = "read";
+    }
+    if (name == "read") {
+      BlockInputSource<ReadBlockReader> source(fd);
+      return f(source);
+    }
+    if (name == "stream") {
+      StreamInputSource source;
+      return f(source);
+    }
+    if (name == "gzip") {
+      BlockInputSource<DecompressingBlockReader<GzipDecoder> > source(fd);
+      return f(source);
+    }
+    if (name == "zstd") {
+#if defined(HAS_ZSTD) && (HAS_ZSTD == 1)
+      BlockInputSource<DecompressingBlockReader<ZstdDecoder> > source(fd);
+      return f(source);
+#else
+      throw std::invalid_argument("Built without zstd support");
+#endif
+    }
+    throw std::invalid_argument("Unknown input source: " + std::string(name));
+  }
+} // namespace OrderBookProgrammingProblem
+
+#endif // INPUT_SOURCE_REGISTRY_H
@@ -0,0 +1,109 @@
+#ifndef INPUT_SOURCE_H
+#define INPUT_SOURCE_H
+
+#include "../aligned-allocator.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace OrderBookProgrammingProblem {
+  // Where pricer reads its feed from, one message per line
+  template<typename T>
+  class IInputSource {
+  public:
+    // The next line without its trailing '\n', or std::nullopt once the input
+    // is exhausted. The view is only valid until the next call.
+    std::optional<std::string_view> next_line() {
+      return static_cast<T *>(this)->next_line_impl();
+    }
+
+    virtual ~IInputSource() = default;
+  };
+
+  // std::getline() over an std::istream, i.e., the behaviour pricer always had
+  class StreamInputSource final : public IInputSource<StreamInputSource> {
+    std::istream &stream;
+    std::string line;
+
+  public:
+    explicit StreamInputSource(std::istream &in = std::cin) : stream(in) {
+    }
+
+    std::optional<std::string_view> next_line_impl() {
+      if (!std::getline(stream, line))
+        return std::nullopt;
+      return line;
+    }
+  };
+
+  // Splits the blocks handed out by a BlockReader into lines. A BlockReader
+  // provides std::span<const char> next_block(), which may invalidate the block
+  // returned by the previous call and returns an empty span at (and after) the
+  // end of the input. Lines are returned as views into the current block, only
+  // lines spanning two blocks are copied.
+  template<typename BlockReader>
+  class BlockInputSource final : public IInputSource<BlockInputSource<BlockReader> > {
+    BlockReader reader;
+    std::span<const char> block;
+    size_t pos = 0;
+    // The part of a line that started in an earlier block
+    std::string carry;
+
+  public:
+    template<typename... Args>
+    explicit BlockInputSource(Args &&... args) : reader(std::forward<Args>(args)...) {
+    }
+
+    std::optional<std::string_view> next_line_impl() {
+      carry.clear();
+      while (true) {
+        const std::string_view rest(block.data() + pos, block.size() - pos);
+        if (const auto newline = rest.find('\n'); newline != std::string_view::npos) {
+          pos += newline + 1;
+          if (carry.empty())
+            return rest.substr(0, newline);
+          carry.append(rest.substr(0, newline));
+          return carry;
+        }
+        carry.append(rest);
+        block = reader.next_block();
+        pos = 0;
+        if (block.empty())
+          return carry.empty() ? std::nullopt : std::optional<std::string_view>(carry);
+      }
+    }
+  };
+
+  // Blocking read(2) into a single buffer
+  class ReadBlockReader {
+    int fd;
+    std::vector<char, AlignedAllocator<char> > buffer;
+
+  public:
+    static constexpr size_t default_block_size = 1 << 20;
+
+    explicit ReadBlockReader(const int input_fd, const size_t block_size = default_block_size)
+      : fd(input_fd), buffer(block_size) {
+    }
+
+    std::span<const char> next_block() {
+      while (true) {
+        const auto n = read(fd, buffer.data(), buffer.size());
+        if (n >= 0)
+          return {buffer.data(), static_cast<size_t>(n)};
+        if (errno != EINTR)
+          throw std::system_error(errno, std::generic_category(), "read()");
+      }
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // INPUT_SOURCE_H
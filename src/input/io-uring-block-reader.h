@@ -0,0 +1,237 @@
+#ifndef IO_URING_BLOCK_READER_H
+#define IO_URING_BLOCK_READER_H
+
+#include "../aligned-allocator.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <span>
+#include <system_error>
+#include <vector>
+
+namespace OrderBookProgrammingProblem {
+  // Reads a regular file through io_uring with queue_depth block reads in
+  // flight, so that by the time the parser is done with one block the next ones
+  // are already in memory. Talks to the kernel with raw syscalls to avoid a
+  // liburing dependency. The constructor throws std::system_error if io_uring
+  // is unavailable (old kernel, seccomp), cannot read (IORING_OP_READ needs
+  // Linux 5.6) or fd is not a regular file, callers are expected to fall back
+  // to ReadBlockReader.
+  class IoUringBlockReader {
+    struct Slot {
+      std::vector<char, AlignedAllocator<char, 4096> > buffer;
+      uint64_t offset = 0;
+      unsigned length = 0;
+      int result = 0;
+      bool done = false;
+    };
+
+    int fd;
+    int ring_fd = -1;
+    size_t block_size;
+    // Next file offset not yet assigned to a slot
+    uint64_t next_offset = 0;
+    std::vector<Slot> slots;
+    // Slot holding the next block in file order
+    size_t head = 0;
+    bool handed_out = false;
+    size_t in_flight = 0;
+
+    void *sq_ring = MAP_FAILED;
+    void *cq_ring = MAP_FAILED;
+    size_t sq_ring_size = 0;
+    size_t cq_ring_size = 0;
+    io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    size_t sqes_size = 0;
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_mask = nullptr;
+    unsigned *sq_array = nullptr;
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+    template<typename T>
+    static T *at(void *base, const unsigned offset) {
+      return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+    }
+
+    static void *map_ring(const int ring, const size_t size, const off_t offset) {
+      void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, offset);
+      if (addr == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "mmap(io_uring)");
+      return addr;
+    }
+
+    int enter(const unsigned to_submit, const unsigned min_complete, const unsigned flags) const {
+      while (true) {
+        const auto ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+                                                  flags, nullptr, 0));
+        if (ret >= 0)
+          return ret;
+        if (errno != EINTR)
+          throw std::system_error(errno, std::generic_category(), "io_uring_enter()");
+      }
+    }
+
+    // The probe came with Linux 5.6 along with IORING_OP_READ, so a kernel
+    // that rejects the probe cannot read either
+    void require_read_op() const {
+      constexpr size_t op_count = IORING_OP_LAST;
+      std::vector<uint64_t> buffer((sizeof(io_uring_probe) + op_count * sizeof(io_uring_probe_op) + 7) / 8);
+      auto *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+      if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, op_count) < 0)
+        throw std::system_error(errno, std::generic_category(), "io_uring_register(IORING_REGISTER_PROBE)");
+      if (probe->last_op < IORING_OP_READ || !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED))
+        throw std::system_error(EOPNOTSUPP, std::generic_category(), "io_uring without IORING_OP_READ");
+    }
+
+    void submit(const size_t slot_idx, const uint64_t offset, const unsigned length) {
+      auto &slot = slots[slot_idx];
+      slot.offset = offset;
+      slot.length = length;
+      slot.done = false;
+      const unsigned tail = *sq_tail;
+      const unsigned idx = tail & *sq_mask;
+      auto &sqe = sqes[idx];
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.opcode = IORING_OP_READ;
+      sqe.fd = fd;
+      sqe.addr = reinterpret_cast<uint64_t>(slot.buffer.data());
+      sqe.len = length;
+      sqe.off = offset;
+      sqe.user_data = slot_idx;
+      sq_array[idx] = idx;
+      std::atomic_ref(*sq_tail).store(tail + 1, std::memory_order_release);
+      enter(1, 0, 0);
+      ++in_flight;
+    }
+
+    // Records every available completion, waiting for at least one if wait
+    void reap(const bool wait) {
+      unsigned head_idx = *cq_head;
+      if (wait && head_idx == std::atomic_ref(*cq_tail).load(std::memory_order_acquire))
+        enter(0, 1, IORING_ENTER_GETEVENTS);
+      const unsigned tail = std::atomic_ref(*cq_tail).load(std::memory_order_acquire);
+      for (; head_idx != tail; ++head_idx) {
+        const auto &cqe = cqes[head_idx & *cq_mask];
+        auto &slot = slots[cqe.user_data];
+        slot.result = cqe.res;
+        slot.done = true;
+        --in_flight;
+      }
+      std::atomic_ref(*cq_head).store(head_idx, std::memory_order_release);
+    }
+
+    void release() noexcept {
+      // The kernel may still write into the buffers until the reads complete
+      try {
+        while (cq_head != nullptr && in_flight > 0)
+          reap(true);
+      } catch (const std::system_error &) {
+      }
+      if (sqes != MAP_FAILED)
+        munmap(sqes, sqes_size);
+      if (cq_ring != MAP_FAILED && cq_ring != sq_ring)
+        munmap(cq_ring, cq_ring_size);
+      if (sq_ring != MAP_FAILED)
+        munmap(sq_ring, sq_ring_size);
+      if (ring_fd >= 0)
+        close(ring_fd);
+    }
+
+  public:
+    static constexpr size_t default_block_size = 1 << 20;
+    static constexpr size_t default_queue_depth = 4;
+
+    explicit IoUringBlockReader(const int input_fd, const size_t block = default_block_size,
+                                const size_t queue_depth = default_queue_depth)
+      : fd(input_fd), block_size(block), slots(queue_depth) {
+      struct stat st{};
+      if (fstat(fd, &st) != 0)
+        throw std::system_error(errno, std::generic_category(), "fstat()");
+      // Reads of pipes and terminals with several requests in flight could
+      // complete out of order
+      if (!S_ISREG(st.st_mode))
+        throw std::system_error(ESPIPE, std::generic_category(), "io_uring input must be a regular file");
+      const auto position = lseek(fd, 0, SEEK_CUR);
+      next_offset = position < 0 ? 0 : static_cast<uint64_t>(position);
+
+      io_uring_params params{};
+      ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(queue_depth), &params));
+      if (ring_fd < 0)
+        throw std::system_error(errno, std::generic_category(), "io_uring_setup()");
+      try {
+        require_read_op();
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+          sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        sq_ring = map_ring(ring_fd, sq_ring_size, IORING_OFF_SQ_RING);
+        cq_ring = params.features & IORING_FEAT_SINGLE_MMAP
+                    ? sq_ring
+                    : map_ring(ring_fd, cq_ring_size, IORING_OFF_CQ_RING);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(map_ring(ring_fd, sqes_size, IORING_OFF_SQES));
+        sq_tail = at<unsigned>(sq_ring, params.sq_off.tail);
+        sq_mask = at<unsigned>(sq_ring, params.sq_off.ring_mask);
+        sq_array = at<unsigned>(sq_ring, params.sq_off.array);
+        cq_head = at<unsigned>(cq_ring, params.cq_off.head);
+        cq_tail = at<unsigned>(cq_ring, params.cq_off.tail);
+        cq_mask = at<unsigned>(cq_ring, params.cq_off.ring_mask);
+        cqes = at<io_uring_cqe>(cq_ring, params.cq_off.cqes);
+
+        for (size_t i = 0; i < slots.size(); ++i) {
+          slots[i].buffer.resize(block_size);
+          submit(i, next_offset, static_cast<unsigned>(block_size));
+          next_offset += block_size;
+        }
+      } catch (...) {
+        release();
+        throw;
+      }
+    }
+
+    IoUringBlockReader(const IoUringBlockReader &) = delete;
+
+    IoUringBlockReader &operator=(const IoUringBlockReader &) = delete;
+
+    ~IoUringBlockReader() { release(); }
+
+    // The returned block stays valid until the next call
+    std::span<const char> next_block() {
+      if (handed_out) {
+        handed_out = false;
+        // Hand the slot back to the kernel: the rest of a short read stays at
+        // the head, a full block is refilled with the next unassigned one
+        auto &slot = slots[head];
+        const auto result = static_cast<unsigned>(slot.result);
+        if (result < slot.length) {
+          submit(head, slot.offset + result, slot.length - result);
+        } else {
+          submit(head, next_offset, static_cast<unsigned>(block_size));
+          next_offset += block_size;
+          head = (head + 1) % slots.size();
+        }
+      }
+      auto &slot = slots[head];
+      while (!slot.done)
+        reap(true);
+      if (slot.result < 0)
+        throw std::system_error(-slot.result, std::generic_category(), "io_uring read");
+      if (slot.result == 0)
+        return {};
+      handed_out = true;
+      return {slot.buffer.data(), static_cast<size_t>(slot.result)};
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // IO_URING_BLOCK_READER_H
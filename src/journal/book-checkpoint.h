@@ -0,0 +1,189 @@
+#ifndef BOOK_CHECKPOINT_H
+#define BOOK_CHECKPOINT_H
+
+#include "../input/input-source.h"
+#include "../order.h"
+#include "../utils.h"
+#include "event-journal.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace OrderBookProgrammingProblem::Journal {
+  // A book checkpoint is an event journal holding one Add per live order,
+  // with its remaining size, so that loading it is a replay into an empty
+  // book. What it preserves is the aggregate state of every level and each
+  // live order's id, side and size. Orders are written by timestamp (the
+  // time they joined their level), then id, so orders that share a
+  // timestamp may come back in another order than they queued in.
+  template<typename Book>
+  void write_checkpoint(Book &book, const std::string &path) {
+    std::vector<Order::LimitOrder> orders;
+    book.for_each_order([&](const Order::LimitOrder &lo) { orders.push_back(lo); });
+    std::ranges::sort(orders, {}, [](const Order::LimitOrder &lo) { return std::tie(lo.timestamp, lo.id); });
+    // Written aside and renamed, so that a crash never leaves a partial
+    // checkpoint under path
+    const auto temp_path = path + ".tmp";
+    std::filesystem::remove(temp_path);
+    {
+      EventJournal checkpoint(temp_path, FileHeader::size + orders.size() * record_size(8), std::chrono::milliseconds(0));
+      uint64_t sequence = 0;
+      for (auto &lo: orders) {
+        lo.type = Order::Type::Add;
+        checkpoint.append(++sequence, lo);
+      }
+    }
+    std::filesystem::rename(temp_path, path);
+  }
+
+  // Adds the orders of the checkpoint at path to book, which should be
+  // empty. Orders the book rejects (e.g., prices out of its range) are
+  // skipped, as they would have been when the feed was first applied.
+  // Returns how many were added
+  template<typename Book>
+  size_t load_checkpoint(Book &book, const std::string &path) {
+    const EventJournal checkpoint(path, read_only);
+    size_t added = 0;
+    checkpoint.replay([&](uint64_t, const Order::LimitOrder &lo) { added += book.try_add_order(lo).has_value(); });
+    return added;
+  }
+
+  struct Checkpoint {
+    // The book holds every message up to and including this timestamp
+    uint64_t timestamp;
+    // Where the first message after it starts in the input, and how many
+    // lines come before it (for inputs that cannot seek, e.g., compressed)
+    uint64_t byte_offset;
+    uint64_t line_number;
+    std::string path;
+  };
+
+  // Text file of "timestamp byte-offset line-number checkpoint-file" lines in
+  // timestamp order, the checkpoint files are looked up next to it
+  class CheckpointIndex {
+    std::string index_path;
+    std::vector<Checkpoint> checkpoints;
+
+    [[nodiscard]] std::filesystem::path directory() const {
+      return std::filesystem::path(index_path).parent_path();
+    }
+
+  public:
+    // Loads path if it exists
+    explicit CheckpointIndex(std::string path) : index_path(std::move(path)) {
+      std::ifstream in(index_path);
+      if (!in)
+        return;
+      Checkpoint checkpoint;
+      while (in >> checkpoint.timestamp >> checkpoint.byte_offset >> checkpoint.line_number >> checkpoint.path) {
+        checkpoint.path = (directory() / checkpoint.path).string();
+        checkpoints.push_back(checkpoint);
+      }
+      if (!in.eof())
+        throw std::invalid_argument("Malformed checkpoint index: " + index_path);
+    }
+
+    // Drops every checkpoint, with its file
+    void clear() {
+      for (const auto &checkpoint: checkpoints)
+        std::filesystem::remove(checkpoint.path);
+      checkpoints.clear();
+      std::ofstream out(index_path, std::ios::trunc);
+      if (!out)
+        throw std::system_error(errno, std::generic_category(), "open(" + index_path + ")");
+    }
+
+    // Checkpoints book as of timestamp, whose next message starts at
+    // byte_offset after line_number lines
+    template<typename Book>
+    void add(Book &book, const uint64_t timestamp, const uint64_t byte_offset, const uint64_t line_number) {
+      if (!checkpoints.empty() && timestamp < checkpoints.back().timestamp)
+        throw std::invalid_argument("Checkpoints must be added in timestamp order");
+      const auto file_name = std::filesystem::path(index_path).filename().string() + "." +
+                             std::to_string(line_number);
+      const auto path = (directory() / file_name).string();
+      write_checkpoint(book, path);
+      std::ofstream out(index_path, std::ios::app);
+      if (!(out << timestamp << ' ' << byte_offset << ' ' << line_number << ' ' << file_name << '\n'))
+        throw std::system_error(errno, std::generic_category(), "write(" + index_path + ")");
+      checkpoints.push_back({timestamp, byte_offset, line_number, path});
+    }
+
+    // The latest checkpoint that does not go past timestamp
+    [[nodiscard]] std::optional<Checkpoint> latest_at(const uint64_t timestamp) const {
+      const auto it = std::ranges::upper_bound(checkpoints, timestamp, {}, &Checkpoint::timestamp);
+      if (it == checkpoints.begin())
+        return std::nullopt;
+      return *std::prev(it);
+    }
+
+    [[nodiscard]] const std::vector<Checkpoint> &entries() const { return checkpoints; }
+  };
+
+  // Replays the whole input into book, checkpointing it into index at the
+  // first timestamp boundary after every `every` lines. Unparsable lines,
+  // timestamps going backwards and orders the book rejects are skipped the
+  // way pricer skips them. Returns the number of lines read
+  template<typename Book, typename InputSource>
+  uint64_t build_checkpoint_index(Book &book, IInputSource<InputSource> &input, CheckpointIndex &index,
+                                  const uint64_t every) {
+    Utils utils;
+    uint64_t byte_offset = 0;
+    uint64_t line_number = 0;
+    uint64_t last_checkpoint_line = 0;
+    std::optional<uint64_t> prev_timestamp;
+    while (const auto line = input.next_line()) {
+      const auto parsed = utils.try_parse_limit_order(line.value());
+      if (parsed.has_value() && parsed->timestamp >= prev_timestamp.value_or(0)) {
+        if (prev_timestamp.has_value() && parsed->timestamp != prev_timestamp &&
+            line_number - last_checkpoint_line >= every) {
+          index.add(book, prev_timestamp.value(), byte_offset, line_number);
+          last_checkpoint_line = line_number;
+        }
+        prev_timestamp = parsed->timestamp;
+        [[maybe_unused]] const auto applied = book.try_add_order(parsed.value());
+      }
+      byte_offset += line->size() + 1;
+      ++line_number;
+    }
+    return line_number;
+  }
+
+  // Applies the messages of input up to and including timestamp to book,
+  // which holds everything up to from_timestamp, and stops at the first
+  // message past it. Skips what pricer would reject. Returns the number of
+  // lines read
+  template<typename Book, typename InputSource>
+  uint64_t replay_until(Book &book, IInputSource<InputSource> &input, const uint64_t from_timestamp,
+                        const uint64_t timestamp) {
+    Utils utils;
+    uint64_t prev_timestamp = from_timestamp;
+    uint64_t line_count = 0;
+    while (const auto line = input.next_line()) {
+      ++line_count;
+      const auto parsed = utils.try_parse_limit_order(line.value());
+      if (!parsed.has_value() || parsed->timestamp < prev_timestamp)
+        continue;
+      if (parsed->timestamp > timestamp)
+        break;
+      prev_timestamp = parsed->timestamp;
+      [[maybe_unused]] const auto applied = book.try_add_order(parsed.value());
+    }
+    return line_count;
+  }
+} // namespace OrderBookProgrammingProblem::Journal
+
+#endif // BOOK_CHECKPOINT_H
@@ -0,0 +1,343 @@
+#ifndef EVENT_JOURNAL_H
+#define EVENT_JOURNAL_H
+
+#include "../order.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace OrderBookProgrammingProblem::Journal {
+  // File layout: a FileHeader, then records packed back to back from
+  // FileHeader::size, each a RecordHeader followed by the order id padded to
+  // 8 bytes. The file is preallocated (zero-filled) and doubled when full.
+  // A record is published by writing its checksum last, so the first record
+  // that is all zeros or fails its checksum (a write torn by a crash) ends
+  // the journal.
+  inline constexpr uint64_t file_magic = 0x314e524a4b424f50; // "POBKJRN1"
+  inline constexpr uint32_t file_version = 1;
+
+  struct FileHeader {
+    static constexpr size_t size = 64;
+    uint64_t magic;
+    uint32_t version;
+    uint32_t header_size;
+  };
+
+  struct RecordHeader {
+    // Of the rest of the record, never 0
+    std::atomic<uint32_t> checksum;
+    uint16_t id_size;
+    char type;
+    char side;
+    // Position of the message in the input, so that a restart can skip
+    // what was already applied
+    uint64_t sequence;
+    uint64_t timestamp;
+    int32_t price_cent;
+    int32_t size;
+  };
+
+  static_assert(sizeof(RecordHeader) == 32);
+  static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+  // Tag of the EventJournal constructor that only reads an existing file
+  struct ReadOnly {
+  };
+
+  inline constexpr ReadOnly read_only{};
+
+  inline size_t record_size(const size_t id_size) { return (sizeof(RecordHeader) + id_size + 7) & ~size_t{7}; }
+
+  // FNV-1a over 8-byte words (the whole padded record but the checksum
+  // itself), a few multiplies rather than one per byte
+  inline uint32_t record_checksum(const std::byte *record, const size_t id_size) {
+    const auto word = [&](const size_t offset) {
+      uint64_t w;
+      std::memcpy(&w, record + offset, sizeof(w));
+      return w;
+    };
+    uint64_t hash = 14695981039346656037ull;
+    hash = (hash ^ (word(0) >> 32)) * 1099511628211ull;
+    for (size_t offset = sizeof(uint64_t); offset < record_size(id_size); offset += sizeof(uint64_t))
+      hash = (hash ^ word(offset)) * 1099511628211ull;
+    const auto folded = static_cast<uint32_t>(hash ^ (hash >> 32));
+    return folded == 0 ? 1 : folded;
+  }
+
+  // Appends the applied events of one writer thread to a memory-mapped file.
+  // append() is a copy into the mapping plus a checksum, no system call: the
+  // page cache keeps what was appended across a crash of the process, and
+  // with a commit interval a background thread msync()s the new records
+  // that often (group commit), so a crash of the machine loses at most that
+  // interval. commit() syncs at once.
+  class EventJournal {
+    std::string file_path;
+    bool writable = true;
+    int fd = -1;
+    std::byte *base = nullptr;
+    size_t capacity = 0;
+    // End of the last complete record, published to the flusher
+    std::atomic<size_t> written{FileHeader::size};
+    uint64_t last_sequence = 0;
+    size_t record_count = 0;
+
+    // Held by the flusher while it syncs and by the writer while it remaps
+    std::mutex mapping_mutex;
+    size_t synced = FileHeader::size;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+    std::thread flusher;
+
+    static constexpr size_t page_size = 4096;
+
+    void map(const size_t new_capacity) {
+      // Allocates the blocks up front rather than leaving a sparse file, so
+      // that the first write to a page does not allocate on the hot path
+      if (const int error = posix_fallocate(fd, 0, static_cast<off_t>(new_capacity)); error != 0)
+        throw std::system_error(error, std::generic_category(), "posix_fallocate(" + file_path + ")");
+      void *addr = base == nullptr
+                     ? mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0)
+                     : mremap(base, capacity, new_capacity, MREMAP_MAYMOVE);
+      if (addr == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "mmap(" + file_path + ")");
+      if (base != nullptr)
+        madvise(static_cast<std::byte *>(addr) + capacity, new_capacity - capacity, MADV_WILLNEED);
+      base = static_cast<std::byte *>(addr);
+      capacity = new_capacity;
+    }
+
+    // Finds the end of the valid records and, unless read-only, clears
+    // everything after it. Records reach the disk page by page in no
+    // particular order, so a crash of the machine can leave older valid
+    // records past a zeroed or torn one, which appending must not run into.
+    // Only pages that are not zero already are written, so a mostly empty
+    // file stays clean
+    void scan() {
+      size_t offset = FileHeader::size;
+      while (offset + sizeof(RecordHeader) <= capacity) {
+        const auto *record = reinterpret_cast<const RecordHeader *>(base + offset);
+        const auto checksum = record->checksum.load(std::memory_order_acquire);
+        if (checksum == 0 || offset + record_size(record->id_size) > capacity ||
+            checksum != record_checksum(base + offset, record->id_size))
+          break;
+        last_sequence = record->sequence;
+        ++record_count;
+        offset += record_size(record->id_size);
+      }
+      written.store(offset, std::memory_order_relaxed);
+      synced = offset;
+      if (!writable)
+        return;
+      bool cleared = false;
+      for (size_t from = offset; from < capacity;) {
+        const auto to = std::min(capacity, (from & ~(page_size - 1)) + page_size);
+        if (std::any_of(base + from, base + to, [](const std::byte b) { return b != std::byte{0}; })) {
+          std::memset(base + from, 0, to - from);
+          cleared = true;
+        }
+        from = to;
+      }
+      // Else the stale records could come back with the next crash
+      if (cleared)
+        sync_range(offset, capacity);
+    }
+
+    void check_header() const {
+      const auto *header = reinterpret_cast<const FileHeader *>(base);
+      if (capacity < FileHeader::size || header->magic != file_magic || header->version != file_version)
+        throw std::invalid_argument("Not an event journal: " + file_path);
+    }
+
+    void sync_range(const size_t from, const size_t to) const {
+      const auto first_page = from & ~(page_size - 1);
+      if (to > first_page && msync(base + first_page, to - first_page, MS_SYNC) != 0)
+        throw std::system_error(errno, std::generic_category(), "msync(" + file_path + ")");
+    }
+
+    void flush_loop(const std::chrono::milliseconds interval) {
+      std::unique_lock lock(mapping_mutex);
+      while (!stopping) {
+        stop_cv.wait_for(lock, interval);
+        const auto end = written.load(std::memory_order_acquire);
+        if (end > synced) {
+          // A failed msync is retried on the next round
+          try {
+            sync_range(synced, end);
+            synced = end;
+          } catch (const std::system_error &) {
+          }
+        }
+      }
+    }
+
+  public:
+    // Room for the file header and the largest record
+    static constexpr size_t min_capacity = size_t{1} << 17;
+
+    // Opens path, or creates it with initial_capacity bytes. A commit
+    // interval of 0 leaves syncing to commit() and the destructor
+    EventJournal(std::string path, const size_t initial_capacity,
+                 const std::chrono::milliseconds commit_interval) : file_path(std::move(path)) {
+      fd = open(file_path.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+      if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "open(" + file_path + ")");
+      try {
+        struct stat st{};
+        if (fstat(fd, &st) != 0)
+          throw std::system_error(errno, std::generic_category(), "fstat(" + file_path + ")");
+        const auto existing = static_cast<size_t>(st.st_size);
+        map(std::max({existing, initial_capacity, min_capacity}));
+        auto *header = reinterpret_cast<FileHeader *>(base);
+        if (existing == 0) {
+          header->version = file_version;
+          header->header_size = FileHeader::size;
+          header->magic = file_magic;
+          sync_range(0, FileHeader::size);
+        } else {
+          check_header();
+        }
+        scan();
+      } catch (...) {
+        if (base != nullptr)
+          munmap(base, capacity);
+        close(fd);
+        throw;
+      }
+      if (commit_interval.count() > 0)
+        flusher = std::thread([this, commit_interval] { flush_loop(commit_interval); });
+    }
+
+    // Opens path for replay() only: the file is mapped read-only as it is,
+    // nothing is cleared, grown or synced, so it may sit on read-only
+    // storage or be read while another process replaces it
+    EventJournal(std::string path, ReadOnly) : file_path(std::move(path)), writable(false) {
+      fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "open(" + file_path + ")");
+      try {
+        struct stat st{};
+        if (fstat(fd, &st) != 0)
+          throw std::system_error(errno, std::generic_category(), "fstat(" + file_path + ")");
+        if (static_cast<size_t>(st.st_size) < FileHeader::size)
+          throw std::invalid_argument("Not an event journal: " + file_path);
+        void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+        if (addr == MAP_FAILED)
+          throw std::system_error(errno, std::generic_category(), "mmap(" + file_path + ")");
+        base = static_cast<std::byte *>(addr);
+        capacity = static_cast<size_t>(st.st_size);
+        check_header();
+        scan();
+      } catch (...) {
+        if (base != nullptr)
+          munmap(base, capacity);
+        close(fd);
+        throw;
+      }
+    }
+
+    EventJournal(const EventJournal &) = delete;
+
+    EventJournal &operator=(const EventJournal &) = delete;
+
+    ~EventJournal() {
+      if (flusher.joinable()) {
+        {
+          std::lock_guard lock(mapping_mutex);
+          stopping = true;
+        }
+        stop_cv.notify_one();
+        flusher.join();
+      }
+      try {
+        if (writable)
+          commit();
+      } catch (const std::system_error &) {
+      }
+      munmap(base, capacity);
+      close(fd);
+    }
+
+    // Calls f(sequence, order) for every record, oldest first
+    template<typename F>
+    void replay(F &&f) const {
+      Order::LimitOrder order;
+      const auto end = written.load(std::memory_order_relaxed);
+      for (size_t offset = FileHeader::size; offset < end;) {
+        const auto *record = reinterpret_cast<const RecordHeader *>(base + offset);
+        order.timestamp = record->timestamp;
+        order.type = static_cast<Order::Type>(record->type);
+        order.side = static_cast<Order::Side>(record->side);
+        order.price_cent = record->price_cent;
+        order.size = record->size;
+        order.id.assign(reinterpret_cast<const char *>(record + 1), record->id_size);
+        f(record->sequence, static_cast<const Order::LimitOrder &>(order));
+        offset += record_size(record->id_size);
+      }
+    }
+
+    void append(const uint64_t sequence, const Order::LimitOrder &order) {
+      if (!writable) [[unlikely]]
+        throw std::logic_error("Journal opened read-only: " + file_path);
+      if (order.id.size() > UINT16_MAX) [[unlikely]]
+        throw std::invalid_argument("Order id too long for the journal: " + order.id.substr(0, 32) + "...");
+      const auto offset = written.load(std::memory_order_relaxed);
+      const auto size = record_size(order.id.size());
+      // Room is kept for a zeroed header after the record, which ends the
+      // journal
+      if (offset + size + sizeof(RecordHeader) > capacity) [[unlikely]] {
+        std::lock_guard lock(mapping_mutex);
+        map(std::max(capacity * 2, offset + size + sizeof(RecordHeader)));
+      }
+      auto *record = reinterpret_cast<RecordHeader *>(base + offset);
+      record->id_size = static_cast<uint16_t>(order.id.size());
+      record->type = static_cast<char>(order.type);
+      record->side = static_cast<char>(order.side);
+      record->sequence = sequence;
+      record->timestamp = order.timestamp;
+      record->price_cent = order.price_cent;
+      record->size = order.size;
+      std::memcpy(record + 1, order.id.data(), order.id.size());
+      record->checksum.store(record_checksum(base + offset, order.id.size()), std::memory_order_release);
+      written.store(offset + size, std::memory_order_release);
+      last_sequence = sequence;
+      ++record_count;
+    }
+
+    // Makes everything appended so far durable
+    void commit() {
+      if (!writable)
+        throw std::logic_error("Journal opened read-only: " + file_path);
+      std::lock_guard lock(mapping_mutex);
+      const auto end = written.load(std::memory_order_acquire);
+      sync_range(synced, end);
+      synced = end;
+    }
+
+    [[nodiscard]] size_t size() const { return record_count; }
+
+    // Sequence of the last record, 0 if there is none
+    [[nodiscard]] uint64_t last_sequence_number() const { return last_sequence; }
+
+    [[nodiscard]] size_t bytes_used() const { return written.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] const std::string &path() const { return file_path; }
+  };
+} // namespace OrderBookProgrammingProblem::Journal
+
+#endif // EVENT_JOURNAL_H
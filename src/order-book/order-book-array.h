@@ -1,6 +1,9 @@
 #ifndef ORDER_BOOK_ARRAY_H
 #define ORDER_BOOK_ARRAY_H
 
+#include "../aligned-allocator.h"
+#include "../depth-kernel.h"
+#include "../fenwick-impl.h"
 #include "../order.h"
 #include "../price-level/price-level-array.h"
 #include "../price-level/price-level-dict.h"
@@ -8,261 +11,412 @@
 #include "../price-level/price-level-interface.h"
 #include "../utils.h"
 #include "order-book-interface.h"
+#include "order-book-policy.h"
+#include "versioned-level-arrays.h"
 
+#include <algorithm>
+#include <expected>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 
 namespace OrderBookProgrammingProblem {
-  using PriceLevelImpl = PriceLevelArray;
+  // With Indexed set, each side also keeps Fenwick trees of the level sizes and
+  // notionals by cent slot, so that a cost query finds the slot where the fill
+  // ends and the cost up to it in O(log P) (P being the number of slots),
+  // however many levels the fill goes through, at the price of an O(log P)
+  // update on every order
+  template<OrderBookPolicyType Policy = DefaultOrderBookPolicy, bool Indexed = false>
+  class OrderBookArray : public IOrderBook<OrderBookArray<Policy, Indexed> > {
+    using PriceLevelImpl = typename Policy::PriceLevel;
+    using Price = typename Policy::Price;
+    using Quantity = typename Policy::Quantity;
+    using Cost = typename Policy::Cost;
 
+    struct DepthIndex {
+      FenwickTree<Cost> sizes;
+      FenwickTree<Cost> notionals;
+      Cost total_size = 0;
+      Cost total_notional = 0;
+    };
 
-  template<typename T>
-  concept AllowedPriceLevelImpl =
-      std::same_as<T, PriceLevelArray> || std::same_as<T, PriceLevelDict>;
+    struct NoDepthIndex {
+    };
 
-  class OrderBookArray : public IOrderBook<OrderBookArray> {
-    std::vector<PriceLevelImpl> ask_prices;
-    std::vector<PriceLevelImpl> bid_prices;
-    std::unordered_map<std::string, std::shared_ptr<Order::LimitOrder> >
-    order_by_id;
-    double bid_hit = 0, bid_miss = 0;
-    double ask_hit = 0, ask_miss = 0;
-    int lowest_bidding_cent = INT_MAX;
-    int lowest_asking_cent = INT_MAX;
-
-    template<AllowedView View1, AllowedView View2>
-    static std::string get_repr_of_one_side(std::vector<PriceLevelImpl> &price_levels,
-                                            View1 transform1, View2 transform2) {
-      std::vector<std::string> levels; // = label + ":\n";
-      int accu_volume = 0, accu_size = 0;
-
-      size_t level = 0;
-
-      for (PriceLevelImpl &price_level: transform1(price_levels)) {
-        auto level_price_cent = price_level.get_level_price();
-        if (level_price_cent.has_value()) {
-          levels.push_back(std::format("Level: {:>2}, Price: {:>5.02f}, ",
-                                       ++level,
-                                       level_price_cent.value() / 100.0));
-          int level_size = price_level.get_level_size().value();
-
-          std::string orders_detail = price_level.to_string();
-          accu_size += level_size;
-          accu_volume += level_size * level_price_cent.value();
-          levels[levels.size() - 1] += std::format(
-            "Size: {:>5}, AccuSize: {:>5}, AccuVolume: {:>8}, Orders: {}",
-            level_size, accu_size, accu_volume, orders_detail);
-        }
+    // One side of the book, levels[i] stores the orders at price
+    // (PricePolicy::min_cent + i) in cents. The side is trimmed from the top so
+    // that levels.back() is always the highest non-empty level
+    template<Order::Side S>
+    struct BookSide {
+      using Depth = VersionedLevelArrays<Price, Quantity, Policy::concurrent_readers>;
+      std::vector<PriceLevelImpl> levels;
+      // Structure-of-arrays copy of the level prices and aggregate sizes for the
+      // cost sweep, depth.sizes()[i] is 0 for an empty level
+      Depth depth;
+      // Only written and read by the thread applying the feed
+      [[no_unique_address]] std::conditional_t<Indexed, DepthIndex, NoDepthIndex> index;
+
+      static size_t to_index(const Price price_cent) {
+        return static_cast<size_t>(price_cent - Policy::PricePolicy::min_cent);
       }
 
-      return (levels | transform2 | std::views::join_with(std::string("\n")) |
-              std::ranges::to<std::string>()) +
-             "\n";
-    }
+      static Price to_price(const size_t idx) {
+        return static_cast<Price>(Policy::PricePolicy::min_cent + idx);
+      }
 
-    std::string get_string_repr_ask_side() {
-      return "Ask:\n" + get_repr_of_one_side<decltype(std::views::all),
-               decltype(std::views::reverse)>(
-               ask_prices, std::views::all, std::views::reverse);
-    }
+      void resize(const size_t new_size) {
+        levels.resize(new_size);
+        depth.resize(new_size, to_price);
+      }
 
-    std::string get_string_repr_bid_side() {
-      return "Bid:\n" + get_repr_of_one_side<decltype(std::views::reverse),
-               decltype(std::views::all)>(
-               bid_prices, std::views::reverse, std::views::all);
-    }
+      // Trimmed slots are 0 so the Fenwick trees only ever grow
+      void index_add_size(const size_t idx, const Quantity delta) requires Indexed {
+        if (index.sizes.size() <= idx) {
+          const auto new_size = std::max(idx + 1, 2 * index.sizes.size());
+          index.sizes.grow(new_size);
+          index.notionals.grow(new_size);
+        }
+        const auto notional = static_cast<Cost>(delta) * to_price(idx);
+        index.sizes.add(idx, delta);
+        index.notionals.add(idx, notional);
+        index.total_size += delta;
+        index.total_notional += notional;
+      }
 
-  public:
-    OrderBookArray() = default;
+      void FUNC_ATTRIBUTE add_order(const std::shared_ptr<Order::LimitOrder> &order_ptr) {
+        typename Depth::WriteSection section(depth);
+        const auto idx = to_index(order_ptr->price_cent);
+        if (levels.size() <= idx) {
+          resize(idx + 1);
+        }
+        if (idx < depth.lowest()) {
+          depth.set_lowest(idx);
+        }
+        levels[idx].add_order(order_ptr);
+        depth.add_size(idx, order_ptr->size);
+        if constexpr (Indexed)
+          index_add_size(idx, order_ptr->size);
+      }
 
-    std::optional<int>
-    FUNC_ATTRIBUTE get_pricer_sell_cost_cent_impl(int target_size) {
-      int cost_cent = 0;
-      if (bid_prices.empty())
-        return std::nullopt;
-      for (auto i = bid_prices.size() - 1; i >= lowest_bidding_cent; --i) {
-        auto price_level = bid_prices[i];
-        auto level_price_cent = price_level.get_level_price();
-        if (!level_price_cent.has_value()) {
-          if constexpr (!benchmark_performance) {
-            ++bid_miss;
-            std::cerr << "[bid_miss] lowest_bidding_cent: " << lowest_bidding_cent
-                << ", i: " << i << ", hit: " << bid_hit
-                << ", miss: " << bid_miss
-                << ", hit rate: " << bid_hit / (bid_hit + bid_miss) << "\n";
+      // Returns the remaining size of the reduced order
+      int FUNC_ATTRIBUTE reduce_order(const Order::LimitOrder &existing_order,
+                                      const std::shared_ptr<Order::LimitOrder> &order_ptr) {
+        typename Depth::WriteSection section(depth);
+        const auto idx = to_index(existing_order.price_cent);
+        const auto previous_size = existing_order.size;
+        const auto remaining_size = levels[idx].update_order(order_ptr);
+        if (remaining_size < 0)
+          throw std::logic_error("Order is not found in its price level");
+        depth.add_size(idx, -(previous_size - remaining_size));
+        if constexpr (Indexed)
+          index_add_size(idx, -(previous_size - remaining_size));
+        const Quantity *sizes = depth.sizes();
+        if (sizes[idx] > 0)
+          return remaining_size;
+
+        if (idx == depth.lowest()) {
+          for (auto i = idx + 1; i < depth.size(); ++i) {
+            if (sizes[i] > 0) {
+              depth.set_lowest(i);
+              break;
+            }
           }
-          continue;
         }
-        auto level_size = price_level.get_level_size();
-        if (!level_size.has_value()) {
-          continue;
-        }
-        if constexpr (!benchmark_performance) {
-          ++bid_hit;
-          std::cerr << "[bid_hit] lowest_bidding_cent: " << lowest_bidding_cent
-              << ", i: " << i << ", hit: " << bid_hit
-              << ", miss: " << bid_miss
-              << ", hit rate: " << bid_hit / (bid_hit + bid_miss) << "\n";
+        auto top = depth.size();
+        while (top > 0 && sizes[top - 1] <= 0)
+          --top;
+        if (top < depth.size())
+          resize(top);
+        if (top == 0)
+          depth.set_lowest(SIZE_MAX);
+        return remaining_size;
+      }
+
+      // Walks the cent slots from the best price, empty slots have a size of 0
+      // so they fall through without a branch of their own
+      std::optional<Cost> FUNC_ATTRIBUTE get_cost_cent(Quantity target_size) const {
+        if (depth.empty())
+          return std::nullopt;
+        if constexpr (Indexed)
+          return search_cost_cent(target_size);
+        return fill_cost_cent(depth.prices(), depth.sizes(), depth.lowest(), depth.size(), target_size);
+      }
+
+      // Same as get_cost_cent(), but safe to call from a thread other than the
+      // one applying the feed
+      std::optional<Cost> get_cost_cent(const size_t reader, const Quantity target_size)
+        requires Policy::concurrent_readers {
+        return depth.read(reader, [&](const Price *prices, const Quantity *sizes,
+                                      const size_t lowest, const size_t count) {
+          return fill_cost_cent(prices, sizes, lowest, count, target_size,
+                                [](const auto &val) { return Depth::load(val); });
+        });
+      }
+
+      // Asks fill the lowest slots first, so the fill ends in the slot where the
+      // prefix size reaches target_size. Bids fill the highest slots first, so
+      // it ends in the slot where the prefix size drops to total - target_size
+      std::optional<Cost> FUNC_ATTRIBUTE search_cost_cent(const Quantity target_size) const requires Indexed {
+        if (target_size <= 0)
+          return 0;
+        if (index.total_size < target_size)
+          return std::nullopt;
+        if constexpr (is_descending_side<S>) {
+          const auto idx = index.sizes.count_at_most(index.total_size - target_size);
+          const auto filled_size = index.total_size - index.sizes.prefix_sum(idx + 1);
+          const auto filled_notional = index.total_notional - index.notionals.prefix_sum(idx + 1);
+          return filled_notional + (target_size - filled_size) * to_price(idx);
+        } else {
+          const auto idx = index.sizes.count_below(target_size);
+          return index.notionals.prefix_sum(idx) + (target_size - index.sizes.prefix_sum(idx)) * to_price(idx);
         }
+      }
 
-        if (target_size > level_size.value()) {
-          target_size -= level_size.value();
-          cost_cent += level_price_cent.value() * level_size.value();
+      // Total size of the slots at limit_price_cent or better, i.e., [lowest,
+      // limit] for asks and [limit, top] for bids
+      Cost FUNC_ATTRIBUTE get_size_within_price(const Price limit_price_cent) const {
+        const auto count = depth.size();
+        const auto lowest = depth.lowest();
+        if (lowest >= count)
+          return 0;
+        if constexpr (is_descending_side<S>) {
+          if (limit_price_cent > to_price(count - 1))
+            return 0;
+          const auto first = limit_price_cent <= to_price(lowest) ? lowest : to_index(limit_price_cent);
+          if constexpr (Indexed)
+            return index.total_size - index.sizes.prefix_sum(first);
+          return sum_sizes(first, count);
         } else {
-          cost_cent += target_size * level_price_cent.value();
-          target_size = 0;
-          return cost_cent;
+          if (limit_price_cent < to_price(lowest))
+            return 0;
+          const auto last = limit_price_cent >= to_price(count - 1) ? count : to_index(limit_price_cent) + 1;
+          if constexpr (Indexed)
+            return index.sizes.prefix_sum(last);
+          return sum_sizes(lowest, last);
         }
       }
-      return std::nullopt;
-    }
 
-    std::optional<int>
-    FUNC_ATTRIBUTE get_pricer_buy_cost_cent_impl(int target_size) {
-      /*
-      std::cerr << "get_pricer_buy_cost_cent_impl()\n";
-      return get_pricer_cost_cent(ask_prices, std::views::all, target_size);
-      */
-      int cost_cent = 0;
-      // This loop is hugely inefficient, say there is only one bid price at 40
-      // but size smaller than target_size, then it iterates from 4000 to 0 use
-      // ssize_t to have -1 support
-      for (ssize_t i = lowest_asking_cent; i < ask_prices.size(); ++i) {
-        auto price_level = ask_prices[i];
-        auto level_price_cent = price_level.get_level_price();
-        if (!level_price_cent.has_value()) {
-          ++ask_miss;
-          if constexpr (!benchmark_performance)
-            std::cerr << "[ask_miss] lowest_asking_cent: " << lowest_asking_cent
-                << ", i: " << i
-                << ", ask_prices.size(): " << ask_prices.size()
-                << ", hit: " << ask_hit << ", miss: " << ask_miss
-                << ", hit rate: " << ask_hit / (ask_hit + ask_miss) << "\n";
-
-          continue;
+      // The most shares whose fill costs at most budget_cent
+      Cost FUNC_ATTRIBUTE get_size_within_budget(const Cost budget_cent) const {
+        const auto count = depth.size();
+        const auto lowest = depth.lowest();
+        if (budget_cent < 0 || lowest >= count)
+          return 0;
+        if constexpr (Indexed)
+          return search_size_within_budget(budget_cent);
+        if constexpr (std::same_as<Price, int32_t> && std::same_as<Quantity, int32_t>) {
+          return DepthKernel::size_within_budget<is_descending_side<S> >(
+            depth.prices() + lowest, depth.sizes() + lowest, count - lowest, budget_cent);
         }
-        auto level_size = price_level.get_level_size();
-        if (!level_size.has_value()) {
-          continue;
+        Cost size = 0;
+        auto remaining = budget_cent;
+        for (size_t n = 0; n < count - lowest; ++n) {
+          const auto i = is_descending_side<S> ? count - 1 - n : lowest + n;
+          const auto notional = static_cast<Cost>(depth.prices()[i]) * depth.sizes()[i];
+          if (notional > remaining)
+            return size + remaining / depth.prices()[i];
+          remaining -= notional;
+          size += depth.sizes()[i];
         }
-        ++ask_hit;
-        if constexpr (!benchmark_performance)
-          std::cerr << "[ask_hit] lowest_asking_cent: " << lowest_asking_cent
-              << ", i: " << i
-              << ", ask_prices.size(): " << ask_prices.size()
-              << ", hit: " << ask_hit << ", miss: " << ask_miss
-              << ", hit rate: " << ask_hit / (ask_hit + ask_miss) << "\n";
-
-        if (target_size > level_size.value()) {
-          target_size -= level_size.value();
-          cost_cent += level_price_cent.value() * level_size.value();
+        return size;
+      }
+
+      Cost sum_sizes(const size_t first, const size_t last) const {
+        if constexpr (std::same_as<Quantity, int32_t>)
+          return DepthKernel::total_size(depth.sizes() + first, last - first);
+        Cost size = 0;
+        for (auto i = first; i < last; ++i)
+          size += depth.sizes()[i];
+        return size;
+      }
+
+      // The slots whose notional fits in the budget are a prefix in fill
+      // order, the slot after them is bought in part. For bids that prefix
+      // is the suffix of slots from the first one whose prefix notional
+      // reaches total - budget
+      Cost FUNC_ATTRIBUTE search_size_within_budget(const Cost budget_cent) const requires Indexed {
+        if (budget_cent >= index.total_notional)
+          return index.total_size;
+        if constexpr (is_descending_side<S>) {
+          const auto idx = index.notionals.count_below(index.total_notional - budget_cent);
+          const auto full_size = index.total_size - index.sizes.prefix_sum(idx + 1);
+          const auto full_notional = index.total_notional - index.notionals.prefix_sum(idx + 1);
+          return full_size + (budget_cent - full_notional) / to_price(idx);
         } else {
-          cost_cent += target_size * level_price_cent.value();
-          target_size = 0;
-          return cost_cent;
+          const auto idx = index.notionals.count_at_most(budget_cent);
+          return index.sizes.prefix_sum(idx) + (budget_cent - index.notionals.prefix_sum(idx)) / to_price(idx);
         }
       }
-      return std::nullopt;
-    }
 
-    void add_order_impl(const Order::LimitOrder &new_order) {
-      const auto order_ptr = std::make_shared<Order::LimitOrder>(new_order);
-      if (new_order.type == Order::Type::Add) {
-        auto &prices =
-            new_order.side == Order::Side::Ask ? ask_prices : bid_prices;
+      // The writer is the only thread that stores to the arrays, so it reads
+      // them plainly and keeps the SIMD kernel even with readers around
+      static std::optional<Cost> fill_cost_cent(const Price *prices, const Quantity *sizes,
+                                                const size_t lowest, const size_t count,
+                                                const Quantity target_size) {
+        if constexpr (std::same_as<Price, int32_t> && std::same_as<Quantity, int32_t>) {
+          if (lowest >= count)
+            return std::nullopt;
+          return DepthKernel::fill_cost_cent<is_descending_side<S> >(
+            prices + lowest, sizes + lowest, count - lowest, target_size);
+        }
+        return fill_cost_cent(prices, sizes, lowest, count, target_size, [](const auto &val) { return val; });
+      }
 
-        if (prices.size() <= new_order.price_cent) {
-          prices.resize(new_order.price_cent + 1);
+      // Readers on other threads load every element through load(), i.e.,
+      // take the scalar walk
+      template<typename Load>
+      static std::optional<Cost> fill_cost_cent(const Price *prices, const Quantity *sizes,
+                                                const size_t lowest, const size_t count,
+                                                Quantity target_size, Load &&load) {
+        if (lowest >= count)
+          return std::nullopt;
+        Cost cost_cent = 0;
+        for (size_t n = 0; n < count - lowest; ++n) {
+          const auto i = is_descending_side<S> ? count - 1 - n : lowest + n;
+          const Quantity level_size = load(sizes[i]);
+          if (target_size > level_size) {
+            target_size -= level_size;
+            cost_cent += static_cast<Cost>(load(prices[i])) * level_size;
+          } else {
+            return cost_cent + static_cast<Cost>(target_size) * load(prices[i]);
+          }
         }
+        return std::nullopt;
+      }
 
-        if (new_order.side == Order::Side::Bid &&
-            new_order.price_cent < lowest_bidding_cent) {
-          lowest_bidding_cent = new_order.price_cent;
+      template<typename F>
+      void for_each_level(F &&f) const {
+        const auto count = depth.size();
+        const auto lowest = depth.lowest();
+        for (size_t n = 0; lowest < count && n < count - lowest; ++n) {
+          const auto i = is_descending_side<S> ? count - 1 - n : lowest + n;
+          if (depth.sizes()[i] > 0 && !f(depth.prices()[i], depth.sizes()[i]))
+            return;
         }
-        if (new_order.side == Order::Side::Ask &&
-            new_order.price_cent < lowest_asking_cent) {
-          lowest_asking_cent = new_order.price_cent;
+      }
+
+      // Levels are listed from the best price, the ask side is then flipped so
+      // that the two sides meet in the middle of the printout
+      std::string to_string() {
+        std::vector<std::string> repr_levels;
+        Cost accu_volume = 0;
+        Quantity accu_size = 0;
+        size_t level = 0;
+
+        const auto lowest_idx = depth.lowest();
+        const auto level_count = levels.empty() ? 0 : levels.size() - lowest_idx;
+        for (size_t n = 0; n < level_count; ++n) {
+          const auto i = is_descending_side<S> ? levels.size() - 1 - n : lowest_idx + n;
+          auto &price_level = levels[i];
+          auto level_price_cent = price_level.get_level_price();
+          if (!level_price_cent.has_value())
+            continue;
+          const Quantity level_size = price_level.get_level_size().value();
+          accu_size += level_size;
+          accu_volume += static_cast<Cost>(level_size) * level_price_cent.value();
+          repr_levels.push_back(std::format(
+            "Level: {:>2}, Price: {:>5.02f}, Size: {:>5}, AccuSize: {:>5}, AccuVolume: {:>8}, Orders: {}",
+            ++level, level_price_cent.value() / 100.0, level_size, accu_size,
+            accu_volume, price_level.to_string()));
         }
+        if constexpr (S == Order::Side::Ask)
+          std::ranges::reverse(repr_levels);
 
-        prices[new_order.price_cent].add_order(order_ptr);
-        order_by_id[new_order.id] = order_ptr;
-        return;
+        return (repr_levels | std::views::join_with(std::string("\n")) |
+                std::ranges::to<std::string>()) +
+               "\n";
       }
+    };
+
+    BookSide<Order::Side::Ask> asks;
+    BookSide<Order::Side::Bid> bids;
+    std::unordered_map<typename Policy::Id, std::shared_ptr<Order::LimitOrder> >
+    order_by_id;
 
-      const auto existing_order = order_by_id[new_order.id];
-      if (!existing_order) {
-        throw std::invalid_argument("Order not found");
+  public:
+    // Prices the book from a thread other than the one applying the feed,
+    // without ever blocking that thread. Each reader thread needs its own
+    // Reader, at most EpochReclaimer::max_readers can exist at a time
+    class Reader {
+      OrderBookArray &order_book;
+      size_t ask_reader;
+      size_t bid_reader;
+
+    public:
+      explicit Reader(OrderBookArray &book) : order_book(book),
+                                              ask_reader(book.asks.depth.register_reader()),
+                                              bid_reader(book.bids.depth.register_reader()) {
       }
 
-      auto update_order = [&](auto &prices) {
-        auto new_price_level_size =
-            prices[existing_order->price_cent].update_order(order_ptr);
-        if (new_price_level_size <= 0) {
-          order_by_id.erase(new_order.id);
-          if (existing_order->side == Order::Side::Ask) {
-            if (order_ptr->price_cent <= lowest_asking_cent) {
-              for (int i = lowest_asking_cent; i < ask_prices.size(); ++i) {
-                if (ask_prices[i].get_level_size_impl().has_value()) {
-                  lowest_asking_cent = i;
-                  break;
-                }
-              }
-            }
-            while (!ask_prices.empty()) {
-              if (!ask_prices[ask_prices.size() - 1]
-                .get_level_size_impl()
-                .has_value())
-                ask_prices.pop_back();
-              else
-                break;
-            }
-          } else {
-            if (order_ptr->price_cent <= lowest_bidding_cent) {
-              for (int i = lowest_bidding_cent; i < bid_prices.size(); ++i) {
-                if (bid_prices[i].get_level_size_impl().has_value()) {
-                  lowest_bidding_cent = i;
-                  break;
-                }
-              }
-            }
-            while (!bid_prices.empty()) {
-              if (!bid_prices[bid_prices.size() - 1]
-                .get_level_size_impl()
-                .has_value())
-                bid_prices.pop_back();
-              else
-                break;
-            }
-          }
-        }
-        /*
-        for (auto const &order : prices[existing_order->price_cent]) {
-          if (order.second->id == new_order.id) {
-            order.second->size -= new_order.size;
-            if (order.second->size < 0) {
-              throw std::invalid_argument("new_order size is negative");
-            }
-            if (order.second->size == 0) {
-              prices[existing_order->price_cent].erase(order.first);
-              order_by_id.erase(new_order.id);
-            }
-            return;
-          }
-        }*/
-      };
+      Reader(const Reader &) = delete;
 
-      if (existing_order->side == Order::Side::Ask) {
-        update_order(ask_prices);
-      } else {
-        update_order(bid_prices);
+      Reader &operator=(const Reader &) = delete;
+
+      ~Reader() {
+        order_book.asks.depth.unregister_reader(ask_reader);
+        order_book.bids.depth.unregister_reader(bid_reader);
       }
+
+      std::optional<Cost> get_pricer_sell_cost_cent(const Quantity target_size) const {
+        return order_book.bids.get_cost_cent(bid_reader, target_size);
+      }
+
+      std::optional<Cost> get_pricer_buy_cost_cent(const Quantity target_size) const {
+        return order_book.asks.get_cost_cent(ask_reader, target_size);
+      }
+    };
+
+    OrderBookArray() = default;
+
+    Reader make_reader() requires Policy::concurrent_readers { return Reader(*this); }
+
+    std::optional<Cost>
+    FUNC_ATTRIBUTE get_pricer_sell_cost_cent_impl(const Quantity target_size) {
+      return bids.get_cost_cent(target_size);
+    }
+
+    std::optional<Cost>
+    FUNC_ATTRIBUTE get_pricer_buy_cost_cent_impl(const Quantity target_size) {
+      return asks.get_cost_cent(target_size);
+    }
+
+    Cost FUNC_ATTRIBUTE get_size_within_price_impl(const Order::Side side, const Price limit_price_cent) {
+      return side == Order::Side::Ask
+               ? asks.get_size_within_price(limit_price_cent)
+               : bids.get_size_within_price(limit_price_cent);
+    }
+
+    Cost FUNC_ATTRIBUTE get_size_within_budget_impl(const Order::Side side, const Cost budget_cent) {
+      return side == Order::Side::Ask
+               ? asks.get_size_within_budget(budget_cent)
+               : bids.get_size_within_budget(budget_cent);
+    }
+
+    std::expected<LevelChange, RejectReason> FUNC_ATTRIBUTE try_add_order_impl(const Order::LimitOrder &new_order) {
+      return apply_order<Policy>(new_order, order_by_id, asks, bids);
+    }
+
+    template<typename F>
+    void for_each_level_impl(const Order::Side side, F &&f) {
+      if (side == Order::Side::Ask)
+        asks.for_each_level(f);
+      else
+        bids.for_each_level(f);
+    }
+
+    template<typename F>
+    void for_each_order_impl(F &&f) const {
+      for (const auto &[id, order]: order_by_id)
+        f(static_cast<const Order::LimitOrder &>(*order));
     }
 
     std::string to_string_impl() {
-      return get_string_repr_ask_side() + get_string_repr_bid_side();
+      return "Ask:\n" + asks.to_string() + "Bid:\n" + bids.to_string();
     }
   };
+
+  template<OrderBookPolicyType Policy = DefaultOrderBookPolicy>
+  using OrderBookFenwickArray = OrderBookArray<Policy, true>;
 } // namespace OrderBookProgrammingProblem
 
 #endif // ORDER_BOOK_ARRAY_H
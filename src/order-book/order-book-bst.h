@@ -9,166 +9,294 @@
 #include "../price-level/price-level-interface.h"
 #include "../utils.h"
 #include "order-book-interface.h"
+#include "order-book-policy.h"
 
+#include <algorithm>
+#include <expected>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 #include <format>
 
 namespace OrderBookProgrammingProblem {
-  using PriceLevelImpl = PriceLevelArray;
-  using BST = BinarySearchTree<PriceLevelImpl>;
+  // With Augmented set, every tree node also keeps the total size and notional
+  // (price * size) of its subtree, so that a cost query of any target size is
+  // a single root-to-leaf descent instead of a walk over the filled levels, at
+  // the price of fixing up the totals on the path of every level update
+  template<OrderBookPolicyType Policy = DefaultOrderBookPolicy, bool Augmented = false>
+    requires std::totally_ordered<typename Policy::PriceLevel>
+  class OrderBookBst final : public IOrderBook<OrderBookBst<Policy, Augmented> > {
+    using PriceLevelImpl = typename Policy::PriceLevel;
+    using Quantity = typename Policy::Quantity;
+    using Cost = typename Policy::Cost;
+    static_assert(!Policy::concurrent_readers, "OrderBookBst does not support concurrent readers");
 
-  class OrderBookBst final : public IOrderBook<OrderBookBst> {
-    TreeNode<PriceLevelImpl> *ask_prices = nullptr;
-    TreeNode<PriceLevelImpl> *bid_prices = nullptr;
-    std::unordered_map<std::string, std::shared_ptr<Order::LimitOrder> >
-    order_by_id;
+    struct LevelTotals {
+      Cost size = 0;
+      Cost notional = 0;
+    };
 
-    template<TraversalOrder TOrder, AllowedView View2>
-    static std::string get_repr_of_one_side(TreeNode<PriceLevelImpl> *price_levels, View2 transform2) {
-      std::vector<std::string> levels; // = label + ":\n";
-      int accu_volume = 0, accu_size = 0;
-
-      size_t level = 0;
-      const BST::CallbackType on_new_price_level =
-          [&](void *, PriceLevelArray &price_level) {
-        auto level_price_cent = price_level.get_level_price();
-        if (!level_price_cent.has_value()) {
-          throw std::logic_error("!level_price_cent.has_value(), how come?");
-        }
-        levels.push_back(std::format("Level: {:>2}, Price: {:>5.02f}, ",
-                                     ++level,
-                                     level_price_cent.value() / 100.0));
-        int level_size = price_level.get_level_size().value();
-
-        std::string orders_detail = price_level.to_string();
-        accu_size += level_size;
-        accu_volume += level_size * level_price_cent.value();
-        levels[levels.size() - 1] += std::format(
-          "Size: {:>5}, AccuSize: {:>5}, AccuVolume: {:>8}, Orders: {}",
-          level_size, accu_size, accu_volume, orders_detail);
-
-        return true;
-      };
-      BST::inorder_traversal_cb<TOrder>(price_levels, on_new_price_level, nullptr);
-
-      return (levels | transform2 | std::views::join_with(std::string("\n")) |
-              std::ranges::to<std::string>()) +
-             "\n";
-    }
+    struct LevelTotalsAugment {
+      using Summary = LevelTotals;
 
-    std::string get_string_repr_ask_side() const {
-      return "Ask:\n" + get_repr_of_one_side<TraversalOrder::RightRootLeft, decltype(std::views::reverse)>(
-               ask_prices, std::views::reverse);
-    }
+      static Summary of(PriceLevelImpl &price_level) {
+        const Cost size = price_level.get_level_size().value_or(0);
+        return {size, size * price_level.get_level_price().value_or(0)};
+      }
 
-    std::string get_string_repr_bid_side() const {
-      return "Bid:\n" + get_repr_of_one_side<TraversalOrder::LeftRootRight, decltype(std::views::all)>(
-               bid_prices, std::views::all);
-    }
+      static Summary combine(const Summary &a, const Summary &b) {
+        return {a.size + b.size, a.notional + b.notional};
+      }
+    };
 
-  public:
-    OrderBookBst() = default;
+    using BST = ArenaBinarySearchTree<PriceLevelImpl, std::conditional_t<Augmented, LevelTotalsAugment,
+      NoAugment<PriceLevelImpl> > >;
+
+    // One side of the book, each tree node stores one price level. Nodes come
+    // from the tree's own arena, so levels are created and removed without
+    // going through malloc once the side reached its peak depth
+    template<Order::Side S>
+    struct BookSide {
+      // Fill order of the side, i.e., bids from the highest price down
+      static constexpr auto fill_order = is_descending_side<S>
+                                           ? TraversalOrder::RightRootLeft
+                                           : TraversalOrder::LeftRootRight;
+      BST tree;
 
-    template<TraversalOrder TOrder>
-    static std::optional<int>
-    FUNC_ATTRIBUTE get_pricer_cost_cent_impl(TreeNode<PriceLevelImpl> *price_levels, int target_size) {
-      int cost_cent = 0;
-      const BST::CallbackType on_new_price_level =
-          [&](void *, PriceLevelArray &price_level) {
-        if (target_size == 0)
-          throw std::logic_error(std::string("Unexpected target_size (0) for price_level: ") +
-                                 std::to_string(price_level.get_level_price().value()));
-
-        const auto level_price_cent = price_level.get_level_price();
-        const auto level_size = price_level.get_level_size();
-        if (!level_price_cent.has_value() || !level_size.has_value())
-          throw std::logic_error(
-            "!level_price_cent.has_value() || !level_size.has_value()");
-        if (target_size > level_size.value()) {
-          target_size -= level_size.value();
-          cost_cent += level_price_cent.value() * level_size.value();
+      void FUNC_ATTRIBUTE add_order(const std::shared_ptr<Order::LimitOrder> &order_ptr) {
+        if (const auto price_level = tree.search(order_ptr->price_cent); price_level != nullptr) {
+          price_level->add_order(order_ptr);
+          if constexpr (Augmented)
+            tree.refresh(order_ptr->price_cent);
         } else {
-          cost_cent += target_size * level_price_cent.value();
-          target_size = 0;
-          return false;
+          PriceLevelImpl temp_price_level;
+          temp_price_level.add_order(order_ptr);
+          tree.insert(std::move(temp_price_level));
         }
-        return true;
-      };
+      }
 
-      BST::inorder_traversal_cb<TOrder>(price_levels, on_new_price_level, nullptr);
-      if (target_size == 0) {
-        return cost_cent;
+      // Returns the remaining size of the reduced order
+      int FUNC_ATTRIBUTE reduce_order(const Order::LimitOrder &existing_order,
+                                      const std::shared_ptr<Order::LimitOrder> &order_ptr) {
+        auto price_level = tree.search(existing_order.price_cent);
+        if (price_level == nullptr)
+          throw std::logic_error("!price_level");
+        const auto remaining_size = price_level->update_order(order_ptr);
+        if (remaining_size < 0)
+          throw std::logic_error("Order is not found in its price level");
+        if (!price_level->get_level_size().has_value()) {
+          tree.delete_node(existing_order.price_cent);
+        } else if constexpr (Augmented) {
+          tree.refresh(existing_order.price_cent);
+        }
+        return remaining_size;
       }
-      return std::nullopt;
-    }
 
-    std::optional<int>
-    FUNC_ATTRIBUTE get_pricer_sell_cost_cent_impl(int target_size) const {
-      return get_pricer_cost_cent_impl<TraversalOrder::LeftRootRight>(bid_prices, target_size);
-    }
+      // A plain loop over the tree iterator, i.e., no recursion and no
+      // std::function call per level
+      std::optional<Cost> FUNC_ATTRIBUTE get_cost_cent(Quantity target_size) {
+        if constexpr (Augmented)
+          return descend_cost_cent(target_size);
+        Cost cost_cent = 0;
+        for (auto &price_level: tree.template inorder<fill_order>()) {
+          const auto level_price_cent = price_level.get_level_price();
+          const auto level_size = price_level.get_level_size();
+          if (!level_price_cent.has_value() || !level_size.has_value())
+            throw std::logic_error(
+              "!level_price_cent.has_value() || !level_size.has_value()");
+          if (target_size > level_size.value()) {
+            target_size -= level_size.value();
+            cost_cent += static_cast<Cost>(level_price_cent.value()) * level_size.value();
+          } else {
+            return cost_cent + static_cast<Cost>(target_size) * level_price_cent.value();
+          }
+        }
+        return std::nullopt;
+      }
 
-    std::optional<int>
-    FUNC_ATTRIBUTE get_pricer_buy_cost_cent_impl(int target_size) const {
-      return get_pricer_cost_cent_impl<TraversalOrder::RightRootLeft>(ask_prices, target_size);
-    }
+      // At each node either the whole fill fits in the subtree walked first
+      // (go there), or that subtree is taken whole, then the node's own level,
+      // and the rest of the fill continues in the other subtree
+      std::optional<Cost> FUNC_ATTRIBUTE descend_cost_cent(const Quantity target_size) requires Augmented {
+        Cost remaining = target_size;
+        if (remaining <= 0)
+          return tree.empty() ? std::nullopt : std::optional<Cost>(0);
+        if (tree.summary(tree.root()).size < remaining)
+          return std::nullopt;
+        Cost cost_cent = 0;
+        for (auto idx = tree.root(); idx != BST::null;) {
+          auto &node = tree.node(idx);
+          const auto near = fill_order == TraversalOrder::LeftRootRight ? node.left : node.right;
+          const auto far = fill_order == TraversalOrder::LeftRootRight ? node.right : node.left;
+          const auto near_totals = tree.summary(near);
+          if (remaining <= near_totals.size) {
+            idx = near;
+            continue;
+          }
+          remaining -= near_totals.size;
+          cost_cent += near_totals.notional;
+          if (remaining <= node.sums.own.size)
+            return cost_cent + remaining * node.val.get_level_price().value();
+          remaining -= node.sums.own.size;
+          cost_cent += node.sums.own.notional;
+          idx = far;
+        }
+        throw std::logic_error("Subtree totals do not add up");
+      }
 
-    void FUNC_ATTRIBUTE add_order_impl(const Order::LimitOrder &new_order) {
-      const auto order_ptr = std::make_shared<Order::LimitOrder>(new_order);
-      if (new_order.type == Order::Type::Add) {
-        auto &ba_prices =
-            new_order.side == Order::Side::Ask ? ask_prices : bid_prices;
+      Cost FUNC_ATTRIBUTE get_size_within_price(const int limit_price_cent) {
+        if constexpr (Augmented)
+          return descend_size_within_price(limit_price_cent);
+        else
+          return walk_size_within_price<Cost>(S, limit_price_cent, [&](auto &&f) { for_each_level(f); });
+      }
 
+      Cost FUNC_ATTRIBUTE get_size_within_budget(const Cost budget_cent) {
+        if constexpr (Augmented)
+          return descend_size_within_budget(budget_cent);
+        else
+          return walk_size_within_budget<Cost>(budget_cent, [&](auto &&f) { for_each_level(f); });
+      }
 
-        if (const auto price_level = BST::search(ba_prices, new_order.price_cent); price_level != nullptr)
-          price_level->val.add_order(order_ptr);
-        else {
-          PriceLevelImpl temp_price_level;
-          temp_price_level.add_order(order_ptr);
-          BST::insert(&ba_prices, temp_price_level);
+      // Subtrees entirely at the limit or better are taken whole on the way
+      // down to where the limit falls
+      Cost descend_size_within_price(const int limit_price_cent) requires Augmented {
+        Cost size = 0;
+        for (auto idx = tree.root(); idx != BST::null;) {
+          auto &node = tree.node(idx);
+          const auto near = fill_order == TraversalOrder::LeftRootRight ? node.left : node.right;
+          const auto far = fill_order == TraversalOrder::LeftRootRight ? node.right : node.left;
+          const auto price_cent = node.val.get_level_price().value();
+          if (is_descending_side<S> ? price_cent < limit_price_cent : price_cent > limit_price_cent) {
+            idx = near;
+            continue;
+          }
+          size += tree.summary(near).size + node.sums.own.size;
+          idx = far;
         }
+        return size;
+      }
 
-
-        order_by_id[new_order.id] = order_ptr;
-        return;
+      // Same descent as descend_cost_cent(), on the notionals
+      Cost descend_size_within_budget(Cost budget_cent) requires Augmented {
+        if (budget_cent < 0)
+          return 0;
+        Cost size = 0;
+        for (auto idx = tree.root(); idx != BST::null;) {
+          auto &node = tree.node(idx);
+          const auto near = fill_order == TraversalOrder::LeftRootRight ? node.left : node.right;
+          const auto far = fill_order == TraversalOrder::LeftRootRight ? node.right : node.left;
+          const auto near_totals = tree.summary(near);
+          if (budget_cent < near_totals.notional) {
+            idx = near;
+            continue;
+          }
+          budget_cent -= near_totals.notional;
+          size += near_totals.size;
+          if (budget_cent < node.sums.own.notional)
+            return size + budget_cent / node.val.get_level_price().value();
+          budget_cent -= node.sums.own.notional;
+          size += node.sums.own.size;
+          idx = far;
+        }
+        return size;
       }
 
-      const std::shared_ptr<Order::LimitOrder> existing_order =
-          order_by_id[new_order.id];
-      if (!existing_order) {
-        throw std::invalid_argument("Order not found");
+      template<typename F>
+      void for_each_level(F &&f) {
+        for (auto &price_level: tree.template inorder<fill_order>()) {
+          if (!f(price_level.get_level_price().value(), price_level.get_level_size().value()))
+            return;
+        }
       }
 
-      auto &ba_prices =
-          existing_order->side == Order::Side::Ask ? ask_prices : bid_prices;
-      // temp_price_level.add_order(existing_order);
-      auto price_level = BST::search(ba_prices, existing_order->price_cent);
-      if (price_level == nullptr)
-        throw std::logic_error("!price_level");
-      price_level->val.update_order(order_ptr);
-      if (price_level->val.get_level_size() <= 0) {
-        //PriceLevelImpl temp_price_level;
-        //temp_price_level.add_order(existing_order);
-        BST::delete_node(&ba_prices, existing_order->price_cent);
-        order_by_id.erase(new_order.id);
+      // Levels are listed from the best price, the ask side is then flipped so
+      // that the two sides meet in the middle of the printout
+      std::string to_string() {
+        std::vector<std::string> levels;
+        Cost accu_volume = 0;
+        Quantity accu_size = 0;
+
+        size_t level = 0;
+        for (auto &price_level: tree.template inorder<fill_order>()) {
+          auto level_price_cent = price_level.get_level_price();
+          if (!level_price_cent.has_value()) {
+            throw std::logic_error("!level_price_cent.has_value(), how come?");
+          }
+          const Quantity level_size = price_level.get_level_size().value();
+          accu_size += level_size;
+          accu_volume += static_cast<Cost>(level_size) * level_price_cent.value();
+          levels.push_back(std::format(
+            "Level: {:>2}, Price: {:>5.02f}, Size: {:>5}, AccuSize: {:>5}, AccuVolume: {:>8}, Orders: {}",
+            ++level, level_price_cent.value() / 100.0, level_size, accu_size,
+            accu_volume, price_level.to_string()));
+        }
+        if constexpr (S == Order::Side::Ask)
+          std::ranges::reverse(levels);
+
+        return (levels | std::views::join_with(std::string("\n")) |
+                std::ranges::to<std::string>()) +
+               "\n";
       }
+    };
+
+    BookSide<Order::Side::Ask> asks;
+    BookSide<Order::Side::Bid> bids;
+    std::unordered_map<typename Policy::Id, std::shared_ptr<Order::LimitOrder> >
+    order_by_id;
+
+  public:
+    OrderBookBst() = default;
+
+    std::optional<Cost>
+    FUNC_ATTRIBUTE get_pricer_sell_cost_cent_impl(const Quantity target_size) {
+      return bids.get_cost_cent(target_size);
     }
 
-    std::string to_string_impl() const {
-      return get_string_repr_ask_side() + get_string_repr_bid_side();
+    std::optional<Cost>
+    FUNC_ATTRIBUTE get_pricer_buy_cost_cent_impl(const Quantity target_size) {
+      return asks.get_cost_cent(target_size);
     }
 
+    Cost FUNC_ATTRIBUTE get_size_within_price_impl(const Order::Side side, const int limit_price_cent) {
+      return side == Order::Side::Ask
+               ? asks.get_size_within_price(limit_price_cent)
+               : bids.get_size_within_price(limit_price_cent);
+    }
 
-    ~OrderBookBst() override {
-      while (ask_prices != nullptr) {
-        BST::delete_node(&ask_prices, ask_prices->val);
-      }
-      while (bid_prices != nullptr) {
-        BST::delete_node(&bid_prices, bid_prices->val);
-      }
+    Cost FUNC_ATTRIBUTE get_size_within_budget_impl(const Order::Side side, const Cost budget_cent) {
+      return side == Order::Side::Ask
+               ? asks.get_size_within_budget(budget_cent)
+               : bids.get_size_within_budget(budget_cent);
+    }
+
+    std::expected<LevelChange, RejectReason> FUNC_ATTRIBUTE try_add_order_impl(const Order::LimitOrder &new_order) {
+      return apply_order<Policy>(new_order, order_by_id, asks, bids);
+    }
+
+    template<typename F>
+    void for_each_level_impl(const Order::Side side, F &&f) {
+      if (side == Order::Side::Ask)
+        asks.for_each_level(f);
+      else
+        bids.for_each_level(f);
     }
+
+    template<typename F>
+    void for_each_order_impl(F &&f) const {
+      for (const auto &[id, order]: order_by_id)
+        f(static_cast<const Order::LimitOrder &>(*order));
+    }
+
+    std::string to_string_impl() {
+      return "Ask:\n" + asks.to_string() + "Bid:\n" + bids.to_string();
+    }
+
+    ~OrderBookBst() override = default;
   };
+
+  template<OrderBookPolicyType Policy = DefaultOrderBookPolicy>
+  using OrderBookAugmentedBst = OrderBookBst<Policy, true>;
 } // namespace OrderBookProgrammingProblem
 
 #endif // ORDER_BOOK_BST_H
@@ -0,0 +1,166 @@
+#ifndef ORDER_BOOK_HEAP_H
+#define ORDER_BOOK_HEAP_H
+
+#include "../heap-impl.h"
+#include "../order.h"
+#include "../price-level/price-level-array.h"
+#include "../price-level/price-level-dict.h"
+#include "../price-level/price-level-doubly-linked-list.h"
+#include "../price-level/price-level-interface.h"
+#include "../utils.h"
+#include "order-book-interface.h"
+#include "order-book-policy.h"
+
+#include <algorithm>
+#include <expected>
+#include <format>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace OrderBookProgrammingProblem {
+  template<OrderBookPolicyType Policy = DefaultOrderBookPolicy>
+  class OrderBookHeap final : public IOrderBook<OrderBookHeap<Policy> > {
+    using PriceLevelImpl = typename Policy::PriceLevel;
+    using Price = typename Policy::Price;
+    using Quantity = typename Policy::Quantity;
+    using Cost = typename Policy::Cost;
+    static_assert(!Policy::concurrent_readers, "OrderBookHeap does not support concurrent readers");
+
+    // One side of the book: an indexed heap of price levels whose top is the
+    // best price (a max-heap for bids), plus the heap handle of every price so
+    // that a level can be found and removed without searching the heap
+    template<Order::Side S>
+    struct BookSide {
+      using Heap = PoC::OrderBook::IndexedHeap<
+        Price, PriceLevelImpl, std::conditional_t<is_descending_side<S>, std::greater<>, std::less<> > >;
+      Heap levels;
+      std::unordered_map<Price, typename Heap::Handle> handle_by_price;
+
+      void FUNC_ATTRIBUTE add_order(const std::shared_ptr<Order::LimitOrder> &order_ptr) {
+        if (const auto it = handle_by_price.find(order_ptr->price_cent); it != handle_by_price.end()) {
+          levels.value(it->second).add_order(order_ptr);
+          return;
+        }
+        PriceLevelImpl price_level;
+        price_level.add_order(order_ptr);
+        handle_by_price.emplace(order_ptr->price_cent, levels.push(order_ptr->price_cent, std::move(price_level)));
+      }
+
+      // Returns the remaining size of the reduced order
+      int FUNC_ATTRIBUTE reduce_order(const Order::LimitOrder &existing_order,
+                                      const std::shared_ptr<Order::LimitOrder> &order_ptr) {
+        const auto it = handle_by_price.find(existing_order.price_cent);
+        if (it == handle_by_price.end())
+          throw std::logic_error("!price_level");
+        auto &price_level = levels.value(it->second);
+        const auto remaining_size = price_level.update_order(order_ptr);
+        if (remaining_size < 0)
+          throw std::logic_error("Order is not found in its price level");
+        if (!price_level.get_level_size().has_value()) {
+          levels.erase(it->second);
+          handle_by_price.erase(it);
+        }
+        return remaining_size;
+      }
+
+      // Only the levels the fill reaches (and their heap children) are looked
+      // at, so a small target size costs O(1) whatever the depth of the book
+      std::optional<Cost> FUNC_ATTRIBUTE get_cost_cent(Quantity target_size) {
+        Cost cost_cent = 0;
+        bool filled = false;
+        for_each_level([&](const Price level_price_cent, const Quantity level_size) {
+          if (target_size > level_size) {
+            target_size -= level_size;
+            cost_cent += static_cast<Cost>(level_price_cent) * level_size;
+            return true;
+          }
+          cost_cent += static_cast<Cost>(target_size) * level_price_cent;
+          filled = true;
+          return false;
+        });
+        if (filled)
+          return cost_cent;
+        return std::nullopt;
+      }
+
+      template<typename F>
+      void for_each_level(F &&f) {
+        levels.for_each_in_order([&](const Price level_price_cent, const typename Heap::Handle handle) {
+          const auto level_size = levels.value(handle).get_level_size();
+          if (!level_size.has_value())
+            throw std::logic_error("!level_size.has_value()");
+          return static_cast<bool>(f(level_price_cent, level_size.value()));
+        });
+      }
+
+      // Levels are listed from the best price, the ask side is then flipped so
+      // that the two sides meet in the middle of the printout
+      std::string to_string() {
+        std::vector<std::string> lines;
+        Cost accu_volume = 0;
+        Quantity accu_size = 0;
+        size_t level = 0;
+        levels.for_each_in_order([&](const Price level_price_cent, const typename Heap::Handle handle) {
+          auto &price_level = levels.value(handle);
+          const Quantity level_size = price_level.get_level_size().value();
+          accu_size += level_size;
+          accu_volume += static_cast<Cost>(level_size) * level_price_cent;
+          lines.push_back(std::format(
+            "Level: {:>2}, Price: {:>5.02f}, Size: {:>5}, AccuSize: {:>5}, AccuVolume: {:>8}, Orders: {}",
+            ++level, level_price_cent / 100.0, level_size, accu_size, accu_volume, price_level.to_string()));
+          return true;
+        });
+        if constexpr (S == Order::Side::Ask)
+          std::ranges::reverse(lines);
+
+        return (lines | std::views::join_with(std::string("\n")) |
+                std::ranges::to<std::string>()) +
+               "\n";
+      }
+    };
+
+    BookSide<Order::Side::Ask> asks;
+    BookSide<Order::Side::Bid> bids;
+    std::unordered_map<typename Policy::Id, std::shared_ptr<Order::LimitOrder> >
+    order_by_id;
+
+  public:
+    OrderBookHeap() = default;
+
+    std::optional<Cost> FUNC_ATTRIBUTE get_pricer_sell_cost_cent_impl(const Quantity target_size) {
+      return bids.get_cost_cent(target_size);
+    }
+
+    std::optional<Cost> FUNC_ATTRIBUTE get_pricer_buy_cost_cent_impl(const Quantity target_size) {
+      return asks.get_cost_cent(target_size);
+    }
+
+    std::expected<LevelChange, RejectReason> FUNC_ATTRIBUTE try_add_order_impl(const Order::LimitOrder &new_order) {
+      return apply_order<Policy>(new_order, order_by_id, asks, bids);
+    }
+
+    template<typename F>
+    void for_each_level_impl(const Order::Side side, F &&f) {
+      if (side == Order::Side::Ask)
+        asks.for_each_level(f);
+      else
+        bids.for_each_level(f);
+    }
+
+    template<typename F>
+    void for_each_order_impl(F &&f) const {
+      for (const auto &[id, order]: order_by_id)
+        f(static_cast<const Order::LimitOrder &>(*order));
+    }
+
+    std::string to_string_impl() {
+      return "Ask:\n" + asks.to_string() + "Bid:\n" + bids.to_string();
+    }
+
+    ~OrderBookHeap() override = default;
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // ORDER_BOOK_HEAP_H
@@ -2,15 +2,55 @@
 #define ORDER_BOOK_INTERFACE_H
 
 #include "../order.h"
+#include "../reject-reason.h"
+#include "order-book-policy.h"
 
+#include <cstdint>
+#include <expected>
 #include <memory>
 #include <ranges>
+#include <span>
 
 
 namespace OrderBookProgrammingProblem {
+    // Inverse depth queries by a walk from the best price, for the books that
+    // also price by walking their levels. for_each_level(f) calls
+    // f(price_cent, level_size) for the levels of side until f returns false
+    template<typename Cost, typename ForEachLevel>
+    Cost walk_size_within_price(const Order::Side side, const int limit_price_cent, ForEachLevel &&for_each_level) {
+        Cost size = 0;
+        for_each_level([&](const auto price_cent, const auto level_size) {
+            if (side == Order::Side::Bid ? price_cent < limit_price_cent : price_cent > limit_price_cent)
+                return false;
+            size += level_size;
+            return true;
+        });
+        return size;
+    }
+
+    // Levels are taken whole while their notional fits, then the level where
+    // the budget runs out gives what it can afford
+    template<typename Cost, typename ForEachLevel>
+    Cost walk_size_within_budget(Cost budget_cent, ForEachLevel &&for_each_level) {
+        Cost size = 0;
+        if (budget_cent < 0)
+            return size;
+        for_each_level([&](const auto price_cent, const auto level_size) {
+            const auto notional = static_cast<Cost>(price_cent) * level_size;
+            if (notional > budget_cent) {
+                size += budget_cent / price_cent;
+                return false;
+            }
+            budget_cent -= notional;
+            size += level_size;
+            return true;
+        });
+        return size;
+    }
+
     template<typename T>
     class IOrderBook {
-        static void add_order_impl(const Order::LimitOrder &new_order) {
+        static std::expected<LevelChange, RejectReason> try_add_order_impl(const Order::LimitOrder &) {
             throw std::logic_error("Not implemented");
         }
 
@@ -27,24 +67,116 @@ namespace OrderBookProgrammingProblem {
             throw std::logic_error("Not implemented");
         }
 
+        template<typename F>
+        static void for_each_level_impl(Order::Side, F &&) {
+            throw std::logic_error("Not implemented");
+        }
+
+        template<typename F>
+        static void for_each_order_impl(F &&) {
+            throw std::logic_error("Not implemented");
+        }
+
+        // Books that price by walking their levels answer the inverse queries
+        // the same way, books with an index override these
+        auto get_size_within_price_impl(const Order::Side side, const int limit_price_cent) {
+            using Cost = typename decltype(static_cast<T *>(this)->get_pricer_sell_cost_cent_impl(0))::value_type;
+            return walk_size_within_price<Cost>(side, limit_price_cent, [&](auto &&f) {
+                static_cast<T *>(this)->for_each_level_impl(side, f);
+            });
+        }
+
+        auto get_size_within_budget_impl(const Order::Side side, const int64_t budget_cent) {
+            using Cost = typename decltype(static_cast<T *>(this)->get_pricer_sell_cost_cent_impl(0))::value_type;
+            return walk_size_within_budget<Cost>(budget_cent, [&](auto &&f) {
+                static_cast<T *>(this)->for_each_level_impl(side, f);
+            });
+        }
+
+        // Default batch application, implementations may override it to amortize
+        // per-batch work (e.g., repricing) over all orders sharing a timestamp
+        template<typename F>
+        void try_add_orders_impl(const std::span<const Order::LimitOrder> new_orders, F &&on_reject) {
+            for (size_t i = 0; i < new_orders.size(); ++i) {
+                if (const auto applied = static_cast<T *>(this)->try_add_order_impl(new_orders[i]); !applied)
+                    [[unlikely]] on_reject(i, applied.error());
+            }
+        }
+
     public:
-        std::optional<int> get_pricer_sell_cost_cent(const int target_size) {
+        // Return std::optional<Policy::Cost> of the implementation
+        auto get_pricer_sell_cost_cent(const int target_size) {
             return static_cast<T *>(this)->get_pricer_sell_cost_cent_impl(target_size);
         }
 
-        std::optional<int> get_pricer_buy_cost_cent(const int target_size) {
+        auto get_pricer_buy_cost_cent(const int target_size) {
             return static_cast<T *>(this)->get_pricer_buy_cost_cent_impl(target_size);
         }
 
 
+        // Inverse queries, in shares: the most that can be sold to the bids at
+        // limit_price_cent or higher (bought from the asks at limit_price_cent
+        // or lower), and the most whose fill costs at most budget_cent
+        auto get_pricer_sell_size_within_price(const int limit_price_cent) {
+            return static_cast<T *>(this)->get_size_within_price_impl(Order::Side::Bid, limit_price_cent);
+        }
+
+        auto get_pricer_buy_size_within_price(const int limit_price_cent) {
+            return static_cast<T *>(this)->get_size_within_price_impl(Order::Side::Ask, limit_price_cent);
+        }
+
+        auto get_pricer_sell_size_within_budget(const int64_t budget_cent) {
+            return static_cast<T *>(this)->get_size_within_budget_impl(Order::Side::Bid, budget_cent);
+        }
+
+        auto get_pricer_buy_size_within_budget(const int64_t budget_cent) {
+            return static_cast<T *>(this)->get_size_within_budget_impl(Order::Side::Ask, budget_cent);
+        }
+
+        // Applies new_order and returns the levels it changed, or returns why it
+        // was rejected and leaves the book as it was. Reducing an order by more
+        // than its size removes it
+        std::expected<LevelChange, RejectReason> try_add_order(const Order::LimitOrder &new_order) {
+            return static_cast<T *>(this)->try_add_order_impl(new_order);
+        }
+
+        // Same as try_add_order(), but throws std::invalid_argument on reject
         void add_order(const Order::LimitOrder &new_order) {
-            return static_cast<T *>(this)->add_order_impl(new_order);
+            if (const auto applied = try_add_order(new_order); !applied) [[unlikely]]
+                throw std::invalid_argument(std::string(OrderBookProgrammingProblem::to_string(applied.error())));
+        }
+
+        // Applies all of new_orders, calling on_reject(index, reason) for each
+        // one rejected
+        template<typename F>
+        void try_add_orders(const std::span<const Order::LimitOrder> new_orders, F &&on_reject) {
+            return static_cast<T *>(this)->try_add_orders_impl(new_orders, std::forward<F>(on_reject));
+        }
+
+        void add_orders(const std::span<const Order::LimitOrder> new_orders) {
+            try_add_orders(new_orders, [](size_t, const RejectReason reason) {
+                throw std::invalid_argument(std::string(OrderBookProgrammingProblem::to_string(reason)));
+            });
         }
 
         std::string to_string() {
             return static_cast<T *>(this)->to_string_impl();
         }
 
+        // Calls f(price_cent, level_size) for the non-empty levels of one side
+        // from the best price outwards, until f returns false
+        template<typename F>
+        void for_each_level(const Order::Side side, F &&f) {
+            return static_cast<T *>(this)->for_each_level_impl(side, std::forward<F>(f));
+        }
+
+        // Calls f(order) for every live order, with its remaining size, in no
+        // particular order
+        template<typename F>
+        void for_each_order(F &&f) {
+            return static_cast<T *>(this)->for_each_order_impl(std::forward<F>(f));
+        }
+
         virtual ~IOrderBook() = default;
     };
 } // namespace OrderBookProgrammingProblem
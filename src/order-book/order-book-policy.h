@@ -0,0 +1,233 @@
+#ifndef ORDER_BOOK_POLICY_H
+#define ORDER_BOOK_POLICY_H
+
+#include "../order.h"
+#include "../price-level/price-level-array.h"
+#include "../price-level/price-level-interface.h"
+#include "../reject-reason.h"
+
+#include <algorithm>
+#include <climits>
+#include <concepts>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace OrderBookProgrammingProblem {
+  // Keys order_by_id with the feed's order id as is
+  struct StringIdPolicy {
+    using Type = std::string;
+
+    static bool is_valid(const std::string &) { return true; }
+
+    static const Type &to_key(const std::string &id) { return id; }
+  };
+
+  // Packs ids of up to 8 characters into an integer, which hashes and compares
+  // faster than std::string for feeds with short ids (e.g., "pghe")
+  struct PackedIdPolicy {
+    using Type = uint64_t;
+
+    static bool is_valid(const std::string &id) { return id.size() <= sizeof(Type); }
+
+    static Type to_key(const std::string &id) {
+      if (id.size() > sizeof(Type))
+        throw std::invalid_argument("Order id longer than 8 characters: " + id);
+      Type key = 0;
+      for (const auto c: id)
+        key = (key << 8) | static_cast<unsigned char>(c);
+      return key;
+    }
+  };
+
+  // Price type and the range of cent prices an instrument can trade at,
+  // orders outside [min_cent, max_cent] are rejected
+  template<std::integral T = int, T MinCent = 0,
+    T MaxCent = std::numeric_limits<T>::max()>
+  struct PricePolicy {
+    static_assert(MinCent <= MaxCent);
+    using Type = T;
+    static constexpr Type min_cent = MinCent;
+    static constexpr Type max_cent = MaxCent;
+
+    static constexpr bool in_range(const Type price_cent) {
+      return price_cent >= min_cent && price_cent <= max_cent;
+    }
+  };
+
+  template<std::integral T = int>
+  struct QuantityPolicy {
+    using Type = T;
+  };
+
+  template<typename T>
+  concept PriceLevelType = std::derived_from<T, IPriceLevel<T> > &&
+                           std::default_initializable<T>;
+
+  template<typename T>
+  concept IdPolicyType = requires(const std::string &id) {
+    typename T::Type;
+    { T::is_valid(id) } -> std::same_as<bool>;
+    { T::to_key(id) } -> std::convertible_to<typename T::Type>;
+  };
+
+  template<typename T>
+  concept PricePolicyType = requires(typename T::Type price_cent) {
+    requires std::integral<typename T::Type>;
+    { T::in_range(price_cent) } -> std::same_as<bool>;
+  };
+
+  template<typename T>
+  concept QuantityPolicyType = std::integral<typename T::Type>;
+
+  // Compile-time configuration of an order book, so that each instrument can
+  // get its own combination of data structures in the same binary, e.g.:
+  //   OrderBookArray<OrderBookPolicy<PriceLevelDict, PackedIdPolicy,
+  //                                  PricePolicy<int, 1000, 9000> > >
+  // ConcurrentReaders lets other threads price the book through a Reader
+  // handle while one thread applies the feed, only books that provide
+  // make_reader() support it
+  template<PriceLevelType TPriceLevel = PriceLevelArray,
+    IdPolicyType TIdPolicy = StringIdPolicy,
+    PricePolicyType TPricePolicy = PricePolicy<>,
+    QuantityPolicyType TQuantityPolicy = QuantityPolicy<>,
+    bool ConcurrentReaders = false>
+  struct OrderBookPolicy {
+    using PriceLevel = TPriceLevel;
+    using IdPolicy = TIdPolicy;
+    using Id = typename TIdPolicy::Type;
+    using PricePolicy = TPricePolicy;
+    using Price = typename TPricePolicy::Type;
+    using Quantity = typename TQuantityPolicy::Type;
+    // Accumulator of price * size, i.e., the value returned by the pricer. It
+    // is at least 64-bit, a deep fill easily exceeds INT_MAX cents
+    using Cost = std::common_type_t<int64_t, Price, Quantity>;
+    static constexpr bool concurrent_readers = ConcurrentReaders;
+  };
+
+  using DefaultOrderBookPolicy = OrderBookPolicy<>;
+
+  template<typename T>
+  concept OrderBookPolicyType = requires {
+    typename T::PriceLevel;
+    typename T::IdPolicy;
+    typename T::Id;
+    typename T::PricePolicy;
+    typename T::Price;
+    typename T::Quantity;
+    typename T::Cost;
+    { T::concurrent_readers } -> std::convertible_to<bool>;
+  };
+
+  // Walking direction of one side of the book when filling an order: bids
+  // from the highest price down, asks from the lowest price up
+  template<Order::Side S>
+  constexpr bool is_descending_side = S == Order::Side::Bid;
+
+  // What applying a message changed: the levels of one side at price_cent
+  // and possibly worse (in fill order), so fills reaching less deep than
+  // price_cent are not affected. A Replace moving an order between levels
+  // reports the better of the two prices.
+  struct LevelChange {
+    Order::Side side = Order::Side::Bid;
+    int price_cent = 0;
+  };
+
+  // The checks of an order that do not depend on the state of the book, so
+  // that the books only look up ids before changing anything
+  template<OrderBookPolicyType Policy>
+  std::expected<void, RejectReason> validate_order(const Order::LimitOrder &order) {
+    // A cancel carries no size, it removes whatever is left of the order
+    if (order.type != Order::Type::Cancel && order.size <= 0) [[unlikely]]
+      return std::unexpected(RejectReason::non_positive_size);
+    if (!Policy::IdPolicy::is_valid(order.id)) [[unlikely]]
+      return std::unexpected(RejectReason::invalid_id);
+    if ((order.type == Order::Type::Add || order.type == Order::Type::Replace) &&
+        !Policy::PricePolicy::in_range(order.price_cent)) [[unlikely]]
+      return std::unexpected(RejectReason::price_out_of_range);
+    return {};
+  }
+
+  // Applies one message to a book made of order_by_id and its two sides,
+  // which all the books share. Reduce, Cancel and a Replace at the same
+  // price change the stored order in place through reduce_order() (a
+  // negative size grows it) and keep its timestamp, the time it joined its
+  // level; a Replace at another price takes the order out of its level and
+  // adds the same object at the new one with the Replace's timestamp, so
+  // order_by_id is left alone.
+  template<OrderBookPolicyType Policy, typename OrderById, typename AskSide, typename BidSide>
+  std::expected<LevelChange, RejectReason> apply_order(const Order::LimitOrder &new_order, OrderById &order_by_id,
+                                                AskSide &asks, BidSide &bids) {
+    if (const auto valid = validate_order<Policy>(new_order); !valid) [[unlikely]]
+      return std::unexpected(valid.error());
+    if (new_order.type == Order::Type::Add) {
+      const auto [it, inserted] = order_by_id.try_emplace(Policy::IdPolicy::to_key(new_order.id));
+      if (!inserted) [[unlikely]]
+        return std::unexpected(RejectReason::duplicate_id);
+      it->second = std::make_shared<Order::LimitOrder>(new_order);
+      if (new_order.side == Order::Side::Ask)
+        asks.add_order(it->second);
+      else
+        bids.add_order(it->second);
+      return LevelChange{new_order.side, new_order.price_cent};
+    }
+
+    const auto it = order_by_id.find(Policy::IdPolicy::to_key(new_order.id));
+    if (it == order_by_id.end()) [[unlikely]]
+      return std::unexpected(RejectReason::unknown_id);
+    auto &existing_order = *it->second;
+    LevelChange change{existing_order.side, existing_order.price_cent};
+    // Returns the remaining size of the order
+    const auto reduce_by = [&](const int size) {
+      const auto order_ptr = std::make_shared<Order::LimitOrder>(new_order);
+      order_ptr->size = size;
+      return existing_order.side == Order::Side::Ask
+               ? asks.reduce_order(existing_order, order_ptr)
+               : bids.reduce_order(existing_order, order_ptr);
+    };
+
+    int size = 0;
+    switch (new_order.type) {
+      case Order::Type::Reduce:
+        size = std::min(new_order.size, existing_order.size);
+        break;
+      case Order::Type::Cancel:
+        size = existing_order.size;
+        break;
+      case Order::Type::Replace:
+        if (new_order.price_cent == existing_order.price_cent) {
+          size = existing_order.size - new_order.size;
+          if (size == 0)
+            return change;
+          break;
+        }
+        if (existing_order.side == Order::Side::Bid
+              ? new_order.price_cent > change.price_cent
+              : new_order.price_cent < change.price_cent)
+          change.price_cent = new_order.price_cent;
+        reduce_by(existing_order.size);
+        existing_order.timestamp = new_order.timestamp;
+        existing_order.price_cent = new_order.price_cent;
+        existing_order.size = new_order.size;
+        if (existing_order.side == Order::Side::Ask)
+          asks.add_order(it->second);
+        else
+          bids.add_order(it->second);
+        return change;
+      case Order::Type::Add:
+        // Handled above
+        break;
+    }
+    if (reduce_by(size) == 0)
+      order_by_id.erase(it);
+    return change;
+  }
+
+  template<Order::Side S>
+  constexpr const char *side_name = S == Order::Side::Bid ? "bid" : "ask";
+} // namespace OrderBookProgrammingProblem
+
+#endif // ORDER_BOOK_POLICY_H
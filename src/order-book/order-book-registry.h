@@ -0,0 +1,46 @@
+#ifndef ORDER_BOOK_REGISTRY_H
+#define ORDER_BOOK_REGISTRY_H
+
+#include "order-book-array.h"
+#include "order-book-bst.h"
+#include "order-book-heap.h"
+#include "order-book-skip-list.h"
+#include "order-book-std-map.h"
+#include "order-book-veb.h"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace OrderBookProgrammingProblem {
+  inline constexpr std::array<std::string_view, 8> order_book_names = {
+    "array", "array-fenwick", "bst", "bst-augmented", "heap", "skip-list", "std-map", "veb"
+  };
+
+  // Calls f.template operator()<OrderBookImpl>() with the order book registered
+  // under name, so that a single binary can pick its book at runtime while the
+  // hot loop in f is still instantiated (and inlined) per book type
+  template<typename F>
+  decltype(auto) visit_order_book(const std::string_view name, F &&f) {
+    if (name == "array")
+      return f.template operator()<OrderBookArray<> >();
+    if (name == "array-fenwick")
+      return f.template operator()<OrderBookFenwickArray<> >();
+    if (name == "bst")
+      return f.template operator()<OrderBookBst<> >();
+    if (name == "bst-augmented")
+      return f.template operator()<OrderBookAugmentedBst<> >();
+    if (name == "heap")
+      return f.template operator()<OrderBookHeap<> >();
+    if (name == "skip-list")
+      return f.template operator()<OrderBookSkipList<> >();
+    if (name == "std-map")
+      return f.template operator()<OrderBookStdMap<> >();
+    if (name == "veb")
+      return f.template operator()<OrderBookVeb<> >();
+    throw std::invalid_argument("Unknown order book: " + std::string(name));
+  }
+} // namespace OrderBookProgrammingProblem
+
+#endif // ORDER_BOOK_REGISTRY_H
@@ -0,0 +1,207 @@
+#ifndef ORDER_BOOK_SKIP_LIST_H
+#define ORDER_BOOK_SKIP_LIST_H
+
+#include "../order.h"
+#include "../price-level/price-level-array.h"
+#include "../price-level/price-level-dict.h"
+#include "../price-level/price-level-doubly-linked-list.h"
+#include "../price-level/price-level-interface.h"
+#include "../skip-list-impl.h"
+#include "../utils.h"
+#include "order-book-interface.h"
+#include "order-book-policy.h"
+
+#include <algorithm>
+#include <expected>
+#include <format>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace OrderBookProgrammingProblem {
+  template<OrderBookPolicyType Policy = DefaultOrderBookPolicy>
+  class OrderBookSkipList final : public IOrderBook<OrderBookSkipList<Policy> > {
+    using PriceLevelImpl = typename Policy::PriceLevel;
+    using Price = typename Policy::Price;
+    using Quantity = typename Policy::Quantity;
+    using Cost = typename Policy::Cost;
+
+    // The orders of a level are only touched by the writer, size mirrors their
+    // total for readers
+    struct Level {
+      PriceLevelImpl orders;
+      Quantity size = 0;
+    };
+
+    // One side of the book, each skip-list node stores one price level. The
+    // list is sorted in fill order (i.e., bids from the highest price down) so
+    // that both sides are walked from first()
+    template<Order::Side S>
+    struct BookSide {
+      using List = SkipList<Price, Level, std::conditional_t<is_descending_side<S>, std::greater<>, std::less<> >,
+        Policy::concurrent_readers>;
+      List levels;
+
+      void FUNC_ATTRIBUTE add_order(const std::shared_ptr<Order::LimitOrder> &order_ptr) {
+        typename List::WriteSection section(levels);
+        auto *node = levels.find(order_ptr->price_cent);
+        if (node == nullptr)
+          node = levels.insert(order_ptr->price_cent);
+        node->value.orders.add_order(order_ptr);
+        List::store(node->value.size, static_cast<Quantity>(node->value.size + order_ptr->size));
+      }
+
+      // Returns the remaining size of the reduced order
+      int FUNC_ATTRIBUTE reduce_order(const Order::LimitOrder &existing_order,
+                                      const std::shared_ptr<Order::LimitOrder> &order_ptr) {
+        typename List::WriteSection section(levels);
+        auto *node = levels.find(existing_order.price_cent);
+        if (node == nullptr)
+          throw std::logic_error("!price_level");
+        const auto previous_size = existing_order.size;
+        const auto remaining_size = node->value.orders.update_order(order_ptr);
+        if (remaining_size < 0)
+          throw std::logic_error("Order is not found in its price level");
+        List::store(node->value.size, static_cast<Quantity>(node->value.size - (previous_size - remaining_size)));
+        if (!node->value.orders.get_level_size().has_value())
+          levels.erase(node);
+        return remaining_size;
+      }
+
+      std::optional<Cost> FUNC_ATTRIBUTE get_cost_cent(const Quantity target_size) const {
+        return fill_cost_cent(levels.first(), target_size);
+      }
+
+      // Same as get_cost_cent(), but safe to call from a thread other than the
+      // one applying the feed
+      std::optional<Cost> get_cost_cent(const size_t reader, const Quantity target_size)
+        requires Policy::concurrent_readers {
+        return levels.read(reader, [&] { return fill_cost_cent(levels.first(), target_size); });
+      }
+
+      static std::optional<Cost> fill_cost_cent(const typename List::Node *node, Quantity target_size) {
+        Cost cost_cent = 0;
+        for (; node != nullptr; node = node->next()) {
+          if (node->is_deleted())
+            continue;
+          const Quantity level_size = List::load(node->value.size);
+          if (target_size > level_size) {
+            target_size -= level_size;
+            cost_cent += static_cast<Cost>(node->key()) * level_size;
+          } else {
+            return cost_cent + static_cast<Cost>(target_size) * node->key();
+          }
+        }
+        return std::nullopt;
+      }
+
+      template<typename F>
+      void for_each_level(F &&f) {
+        for (const auto *node = levels.first(); node != nullptr; node = node->next()) {
+          if (!f(node->key(), node->value.size))
+            return;
+        }
+      }
+
+      // Levels are listed from the best price, the ask side is then flipped so
+      // that the two sides meet in the middle of the printout
+      std::string to_string() {
+        std::vector<std::string> lines;
+        Cost accu_volume = 0;
+        Quantity accu_size = 0;
+        size_t level = 0;
+        for (auto *node = levels.first(); node != nullptr; node = node->next()) {
+          const Quantity level_size = node->value.size;
+          accu_size += level_size;
+          accu_volume += static_cast<Cost>(level_size) * node->key();
+          lines.push_back(std::format(
+            "Level: {:>2}, Price: {:>5.02f}, Size: {:>5}, AccuSize: {:>5}, AccuVolume: {:>8}, Orders: {}",
+            ++level, node->key() / 100.0, level_size, accu_size, accu_volume, node->value.orders.to_string()));
+        }
+        if constexpr (S == Order::Side::Ask)
+          std::ranges::reverse(lines);
+
+        return (lines | std::views::join_with(std::string("\n")) |
+                std::ranges::to<std::string>()) +
+               "\n";
+      }
+    };
+
+    BookSide<Order::Side::Ask> asks;
+    BookSide<Order::Side::Bid> bids;
+    std::unordered_map<typename Policy::Id, std::shared_ptr<Order::LimitOrder> >
+    order_by_id;
+
+  public:
+    // Prices the book from a thread other than the one applying the feed,
+    // without ever blocking that thread. Each reader thread needs its own
+    // Reader, at most EpochReclaimer::max_readers can exist at a time
+    class Reader {
+      OrderBookSkipList &order_book;
+      size_t ask_reader;
+      size_t bid_reader;
+
+    public:
+      explicit Reader(OrderBookSkipList &book) : order_book(book),
+                                                 ask_reader(book.asks.levels.register_reader()),
+                                                 bid_reader(book.bids.levels.register_reader()) {
+      }
+
+      Reader(const Reader &) = delete;
+
+      Reader &operator=(const Reader &) = delete;
+
+      ~Reader() {
+        order_book.asks.levels.unregister_reader(ask_reader);
+        order_book.bids.levels.unregister_reader(bid_reader);
+      }
+
+      std::optional<Cost> get_pricer_sell_cost_cent(const Quantity target_size) const {
+        return order_book.bids.get_cost_cent(bid_reader, target_size);
+      }
+
+      std::optional<Cost> get_pricer_buy_cost_cent(const Quantity target_size) const {
+        return order_book.asks.get_cost_cent(ask_reader, target_size);
+      }
+    };
+
+    OrderBookSkipList() = default;
+
+    Reader make_reader() requires Policy::concurrent_readers { return Reader(*this); }
+
+    std::optional<Cost> FUNC_ATTRIBUTE get_pricer_sell_cost_cent_impl(const Quantity target_size) const {
+      return bids.get_cost_cent(target_size);
+    }
+
+    std::optional<Cost> FUNC_ATTRIBUTE get_pricer_buy_cost_cent_impl(const Quantity target_size) const {
+      return asks.get_cost_cent(target_size);
+    }
+
+    std::expected<LevelChange, RejectReason> FUNC_ATTRIBUTE try_add_order_impl(const Order::LimitOrder &new_order) {
+      return apply_order<Policy>(new_order, order_by_id, asks, bids);
+    }
+
+    template<typename F>
+    void for_each_level_impl(const Order::Side side, F &&f) {
+      if (side == Order::Side::Ask)
+        asks.for_each_level(f);
+      else
+        bids.for_each_level(f);
+    }
+
+    template<typename F>
+    void for_each_order_impl(F &&f) const {
+      for (const auto &[id, order]: order_by_id)
+        f(static_cast<const Order::LimitOrder &>(*order));
+    }
+
+    std::string to_string_impl() {
+      return "Ask:\n" + asks.to_string() + "Bid:\n" + bids.to_string();
+    }
+
+    ~OrderBookSkipList() override = default;
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // ORDER_BOOK_SKIP_LIST_H
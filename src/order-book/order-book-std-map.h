@@ -1,7 +1,6 @@
 #ifndef ORDER_BOOK_STD_MAP_H
 #define ORDER_BOOK_STD_MAP_H
 
-#include "../bst-impl.h"
 #include "../order.h"
 #include "../price-level/price-level-array.h"
 #include "../price-level/price-level-dict.h"
@@ -9,7 +8,9 @@
 #include "../price-level/price-level-interface.h"
 #include "../utils.h"
 #include "order-book-interface.h"
+#include "order-book-policy.h"
 
+#include <expected>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -17,94 +18,105 @@
 #include <map>
 
 namespace OrderBookProgrammingProblem {
-  using PriceLevelImpl = PriceLevelArray;
-  using BST = BinarySearchTree<PriceLevelImpl>;
+  template<OrderBookPolicyType Policy = DefaultOrderBookPolicy>
+  class OrderBookStdMap final : public IOrderBook<OrderBookStdMap<Policy> > {
+    using PriceLevelImpl = typename Policy::PriceLevel;
+    using Price = typename Policy::Price;
+    using Quantity = typename Policy::Quantity;
+    using Cost = typename Policy::Cost;
+    static_assert(!Policy::concurrent_readers, "OrderBookStdMap does not support concurrent readers");
+
+    // One side of the book, the map is sorted in fill order (i.e., bids from
+    // the highest price down) so that both sides are walked from begin()
+    template<Order::Side S>
+    struct BookSide {
+      std::map<Price, PriceLevelImpl,
+        std::conditional_t<is_descending_side<S>, std::greater<>, std::less<> > > levels;
+
+      void FUNC_ATTRIBUTE add_order(const std::shared_ptr<Order::LimitOrder> &order_ptr) {
+        levels[order_ptr->price_cent].add_order(order_ptr);
+      }
 
-  class OrderBookStdMap final : public IOrderBook<OrderBookStdMap> {
-    std::map<int, PriceLevelImpl> ask_prices;
-    std::map<int, PriceLevelImpl> bid_prices;
-    std::unordered_map<std::string, std::shared_ptr<Order::LimitOrder> >
-    order_by_id;
+      // Returns the remaining size of the reduced order
+      int FUNC_ATTRIBUTE reduce_order(const Order::LimitOrder &existing_order,
+                                      const std::shared_ptr<Order::LimitOrder> &order_ptr) {
+        const auto it = levels.find(existing_order.price_cent);
+        if (it == levels.end())
+          throw std::logic_error("!price_level");
+        const auto remaining_size = it->second.update_order(order_ptr);
+        if (remaining_size < 0)
+          throw std::logic_error("Order is not found in its price level");
+        if (!it->second.get_level_size().has_value()) {
+          levels.erase(it);
+        }
+        return remaining_size;
+      }
 
-    std::string get_string_repr_ask_side() const {
-      return "Ask:\n<NotImplemented>\n"
-          /* + get_repr_of_one_side<TraversalOrder::RightRootLeft, decltype(std::views::reverse)>(
-                         ask_prices, std::views::reverse)*/;
-    }
+      std::optional<Cost> FUNC_ATTRIBUTE get_cost_cent(Quantity target_size) {
+        Cost cost_cent = 0;
+
+        for (auto &[level_price_cent, price_level]: levels) {
+          const auto level_size = price_level.get_level_size();
+          if (!level_size.has_value())
+            throw std::logic_error("!level_size.has_value()");
+          if (target_size > level_size.value()) {
+            target_size -= level_size.value();
+            cost_cent += static_cast<Cost>(level_price_cent) * level_size.value();
+          } else {
+            cost_cent += static_cast<Cost>(target_size) * level_price_cent;
+            return cost_cent;
+          }
+        }
+        return std::nullopt;
+      }
 
-    std::string get_string_repr_bid_side() const {
-      return "Bid:\nNotImplemented\n"
-          /* + get_repr_of_one_side<TraversalOrder::LeftRootRight, decltype(std::views::all)>(
-                         bid_prices, std::views::all)*/;
-    }
+      template<typename F>
+      void for_each_level(F &&f) {
+        for (auto &[level_price_cent, price_level]: levels) {
+          if (!f(level_price_cent, price_level.get_level_size().value()))
+            return;
+        }
+      }
+    };
+
+    BookSide<Order::Side::Ask> asks;
+    BookSide<Order::Side::Bid> bids;
+    std::unordered_map<typename Policy::Id, std::shared_ptr<Order::LimitOrder> >
+    order_by_id;
 
   public:
     OrderBookStdMap() = default;
 
-    template<AllowedView View1>
-    static std::optional<int> FUNC_ATTRIBUTE get_pricer_cost_cent_impl(std::map<int, PriceLevelImpl> &price_levels,
-                                                                       View1 transform, int target_size) {
-      int cost_cent = 0;
-
-      for (auto &price_level: transform(price_levels)) {
-        const auto level_price_cent = price_level.first;
-        const auto level_size = price_level.second.get_level_size();
-        if (!level_size.has_value())
-          throw std::logic_error("!level_size.has_value()");
-        if (target_size > level_size.value()) {
-          target_size -= level_size.value();
-          cost_cent += level_price_cent * level_size.value();
-        } else {
-          cost_cent += target_size * level_price_cent;
-          target_size = 0;
-          return cost_cent;
-        }
-      }
-      return std::nullopt;
+    std::optional<Cost> FUNC_ATTRIBUTE get_pricer_sell_cost_cent_impl(const Quantity target_size) {
+      return bids.get_cost_cent(target_size);
     }
 
-    std::optional<int> FUNC_ATTRIBUTE get_pricer_sell_cost_cent_impl(const int target_size) {
-      return get_pricer_cost_cent_impl<decltype(std::views::reverse)>(bid_prices, std::views::reverse, target_size);
+    std::optional<Cost> FUNC_ATTRIBUTE get_pricer_buy_cost_cent_impl(const Quantity target_size) {
+      return asks.get_cost_cent(target_size);
     }
 
-    std::optional<int> FUNC_ATTRIBUTE get_pricer_buy_cost_cent_impl(const int target_size) {
-      return get_pricer_cost_cent_impl<decltype(std::views::all)>(ask_prices, std::views::all, target_size);
+    std::expected<LevelChange, RejectReason> FUNC_ATTRIBUTE try_add_order_impl(const Order::LimitOrder &new_order) {
+      return apply_order<Policy>(new_order, order_by_id, asks, bids);
     }
 
-    void FUNC_ATTRIBUTE add_order_impl(const Order::LimitOrder &new_order) {
-      const auto order_ptr = std::make_shared<Order::LimitOrder>(new_order);
-      if (new_order.type == Order::Type::Add) {
-        auto &ba_prices = new_order.side == Order::Side::Ask ? ask_prices : bid_prices;
-        if (!ba_prices.contains(order_ptr->price_cent)) {
-          ba_prices.insert({order_ptr->price_cent, PriceLevelImpl()});
-        }
-        ba_prices[order_ptr->price_cent].add_order(order_ptr);
-        order_by_id[new_order.id] = order_ptr;
-        return;
-      }
-
-      const std::shared_ptr<Order::LimitOrder> existing_order = order_by_id[new_order.id];
-      if (!existing_order) {
-        throw std::invalid_argument("!existing_order");
-      }
+    template<typename F>
+    void for_each_level_impl(const Order::Side side, F &&f) {
+      if (side == Order::Side::Ask)
+        asks.for_each_level(f);
+      else
+        bids.for_each_level(f);
+    }
 
-      auto &ba_prices = existing_order->side == Order::Side::Ask ? ask_prices : bid_prices;
-      if (!ba_prices.contains(existing_order->price_cent))
-        throw std::logic_error("!price_level");
-      auto price_level = ba_prices[existing_order->price_cent];
-      price_level.update_order(order_ptr);
-      if (price_level.get_level_size() <= 0) {
-        // BST::delete_node(&ba_prices, existing_order->price_cent);
-        ba_prices.erase(existing_order->price_cent);
-        order_by_id.erase(new_order.id);
-      }
+    template<typename F>
+    void for_each_order_impl(F &&f) const {
+      for (const auto &[id, order]: order_by_id)
+        f(static_cast<const Order::LimitOrder &>(*order));
     }
 
     std::string to_string_impl() const {
-      return get_string_repr_ask_side() + get_string_repr_bid_side();
+      return "Ask:\n<NotImplemented>\nBid:\nNotImplemented\n";
     }
 
-
     ~OrderBookStdMap() override = default;
   };
 } // namespace OrderBookProgrammingProblem
@@ -0,0 +1,181 @@
+#ifndef ORDER_BOOK_VEB_H
+#define ORDER_BOOK_VEB_H
+
+#include "../order.h"
+#include "../price-level/price-level-array.h"
+#include "../price-level/price-level-dict.h"
+#include "../price-level/price-level-doubly-linked-list.h"
+#include "../price-level/price-level-interface.h"
+#include "../utils.h"
+#include "../veb-impl.h"
+#include "order-book-interface.h"
+#include "order-book-policy.h"
+
+#include <algorithm>
+#include <bit>
+#include <expected>
+#include <format>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace OrderBookProgrammingProblem {
+  template<OrderBookPolicyType Policy = DefaultOrderBookPolicy>
+  class OrderBookVeb final : public IOrderBook<OrderBookVeb<Policy> > {
+    using PriceLevelImpl = typename Policy::PriceLevel;
+    using Price = typename Policy::Price;
+    using Quantity = typename Policy::Quantity;
+    using Cost = typename Policy::Cost;
+    static_assert(!Policy::concurrent_readers, "OrderBookVeb does not support concurrent readers");
+
+    // One side of the book: the price levels in a hash map plus a vEB tree of
+    // the occupied prices (as offsets from PricePolicy::min_cent), which finds
+    // the next level in fill order in O(log log U) with memory proportional
+    // to the number of levels, however wide the price range is
+    template<Order::Side S>
+    struct BookSide {
+      static constexpr unsigned universe_bits = std::max(1U, static_cast<unsigned>(std::bit_width(
+        static_cast<uint64_t>(Policy::PricePolicy::max_cent) -
+        static_cast<uint64_t>(Policy::PricePolicy::min_cent))));
+      std::unordered_map<Price, PriceLevelImpl> levels;
+      VebTree index{universe_bits};
+
+      static VebTree::Key to_key(const Price price_cent) {
+        return static_cast<VebTree::Key>(price_cent) - static_cast<VebTree::Key>(Policy::PricePolicy::min_cent);
+      }
+
+      static Price to_price(const VebTree::Key key) {
+        return static_cast<Price>(key + static_cast<VebTree::Key>(Policy::PricePolicy::min_cent));
+      }
+
+      void FUNC_ATTRIBUTE add_order(const std::shared_ptr<Order::LimitOrder> &order_ptr) {
+        const auto [it, inserted] = levels.try_emplace(order_ptr->price_cent);
+        if (inserted)
+          index.insert(to_key(order_ptr->price_cent));
+        it->second.add_order(order_ptr);
+      }
+
+      // Returns the remaining size of the reduced order
+      int FUNC_ATTRIBUTE reduce_order(const Order::LimitOrder &existing_order,
+                                      const std::shared_ptr<Order::LimitOrder> &order_ptr) {
+        const auto it = levels.find(existing_order.price_cent);
+        if (it == levels.end())
+          throw std::logic_error("!price_level");
+        const auto remaining_size = it->second.update_order(order_ptr);
+        if (remaining_size < 0)
+          throw std::logic_error("Order is not found in its price level");
+        if (!it->second.get_level_size().has_value()) {
+          index.erase(to_key(existing_order.price_cent));
+          levels.erase(it);
+        }
+        return remaining_size;
+      }
+
+      std::optional<Cost> FUNC_ATTRIBUTE get_cost_cent(Quantity target_size) {
+        Cost cost_cent = 0;
+        bool filled = false;
+        for_each_level([&](const Price level_price_cent, const Quantity level_size) {
+          if (target_size > level_size) {
+            target_size -= level_size;
+            cost_cent += static_cast<Cost>(level_price_cent) * level_size;
+            return true;
+          }
+          cost_cent += static_cast<Cost>(target_size) * level_price_cent;
+          filled = true;
+          return false;
+        });
+        if (filled)
+          return cost_cent;
+        return std::nullopt;
+      }
+
+      // Calls f(price, level) from the best price on until f returns false
+      template<typename F>
+      void for_each_price_level(F &&f) {
+        auto key = is_descending_side<S> ? index.max() : index.min();
+        while (key.has_value()) {
+          const auto price_cent = to_price(*key);
+          if (!f(price_cent, levels.at(price_cent)))
+            return;
+          key = is_descending_side<S> ? index.predecessor(*key) : index.successor(*key);
+        }
+      }
+
+      template<typename F>
+      void for_each_level(F &&f) {
+        for_each_price_level([&](const Price level_price_cent, PriceLevelImpl &price_level) {
+          const auto level_size = price_level.get_level_size();
+          if (!level_size.has_value())
+            throw std::logic_error("!level_size.has_value()");
+          return static_cast<bool>(f(level_price_cent, level_size.value()));
+        });
+      }
+
+      // Levels are listed from the best price, the ask side is then flipped so
+      // that the two sides meet in the middle of the printout
+      std::string to_string() {
+        std::vector<std::string> lines;
+        Cost accu_volume = 0;
+        Quantity accu_size = 0;
+        size_t level = 0;
+        for_each_price_level([&](const Price level_price_cent, PriceLevelImpl &price_level) {
+          const Quantity level_size = price_level.get_level_size().value();
+          accu_size += level_size;
+          accu_volume += static_cast<Cost>(level_size) * level_price_cent;
+          lines.push_back(std::format(
+            "Level: {:>2}, Price: {:>5.02f}, Size: {:>5}, AccuSize: {:>5}, AccuVolume: {:>8}, Orders: {}",
+            ++level, level_price_cent / 100.0, level_size, accu_size, accu_volume, price_level.to_string()));
+          return true;
+        });
+        if constexpr (S == Order::Side::Ask)
+          std::ranges::reverse(lines);
+
+        return (lines | std::views::join_with(std::string("\n")) |
+                std::ranges::to<std::string>()) +
+               "\n";
+      }
+    };
+
+    BookSide<Order::Side::Ask> asks;
+    BookSide<Order::Side::Bid> bids;
+    std::unordered_map<typename Policy::Id, std::shared_ptr<Order::LimitOrder> >
+    order_by_id;
+
+  public:
+    OrderBookVeb() = default;
+
+    std::optional<Cost> FUNC_ATTRIBUTE get_pricer_sell_cost_cent_impl(const Quantity target_size) {
+      return bids.get_cost_cent(target_size);
+    }
+
+    std::optional<Cost> FUNC_ATTRIBUTE get_pricer_buy_cost_cent_impl(const Quantity target_size) {
+      return asks.get_cost_cent(target_size);
+    }
+
+    std::expected<LevelChange, RejectReason> FUNC_ATTRIBUTE try_add_order_impl(const Order::LimitOrder &new_order) {
+      return apply_order<Policy>(new_order, order_by_id, asks, bids);
+    }
+
+    template<typename F>
+    void for_each_level_impl(const Order::Side side, F &&f) {
+      if (side == Order::Side::Ask)
+        asks.for_each_level(f);
+      else
+        bids.for_each_level(f);
+    }
+
+    template<typename F>
+    void for_each_order_impl(F &&f) const {
+      for (const auto &[id, order]: order_by_id)
+        f(static_cast<const Order::LimitOrder &>(*order));
+    }
+
+    std::string to_string_impl() {
+      return "Ask:\n" + asks.to_string() + "Bid:\n" + bids.to_string();
+    }
+
+    ~OrderBookVeb() override = default;
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // ORDER_BOOK_VEB_H
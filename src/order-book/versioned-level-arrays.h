@@ -0,0 +1,168 @@
+#ifndef VERSIONED_LEVEL_ARRAYS_H
+#define VERSIONED_LEVEL_ARRAYS_H
+
+#include "../aligned-allocator.h"
+#include "../epoch-reclaimer.h"
+#include "../seqlock.h"
+
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+
+namespace OrderBookProgrammingProblem {
+  // Parallel arrays of level prices and aggregate level sizes of one side of
+  // OrderBookArray, plus the index of the lowest non-empty level.
+  //
+  // With Concurrent = true the owning (writer) thread brackets every update in
+  // a seqlock write section and buffers replaced on growth are retired through
+  // an EpochReclaimer, so that reader threads can walk the arrays with read()
+  // while the writer keeps applying the feed. With Concurrent = false all of
+  // that compiles away.
+  template<std::integral Price, std::integral Quantity, bool Concurrent>
+  class VersionedLevelArrays {
+    // Immutable once published except for the array contents, so a reader can
+    // never index past the capacity of the buffer it loaded
+    struct Buffer {
+      size_t capacity = 0;
+      Price *prices = nullptr;
+      Quantity *sizes = nullptr;
+
+      explicit Buffer(const size_t cap) : capacity(cap) {
+        prices = AlignedAllocator<Price>().allocate(cap);
+        sizes = AlignedAllocator<Quantity>().allocate(cap);
+      }
+
+      ~Buffer() {
+        AlignedAllocator<Price>().deallocate(prices, capacity);
+        AlignedAllocator<Quantity>().deallocate(sizes, capacity);
+      }
+    };
+
+    std::atomic<Buffer *> buffer{nullptr};
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> lowest_idx{SIZE_MAX};
+    SeqLock seqlock;
+    EpochReclaimer reclaimer;
+
+    template<typename T>
+    static void store(T &dst, const T val) {
+      if constexpr (Concurrent)
+        std::atomic_ref<T>(dst).store(val, std::memory_order_relaxed);
+      else
+        dst = val;
+    }
+
+  public:
+    // RAII write section, the writer must hold one while mutating
+    class WriteSection {
+      VersionedLevelArrays &arrays;
+
+    public:
+      explicit WriteSection(VersionedLevelArrays &a) : arrays(a) {
+        if constexpr (Concurrent)
+          arrays.seqlock.write_begin();
+      }
+
+      WriteSection(const WriteSection &) = delete;
+
+      WriteSection &operator=(const WriteSection &) = delete;
+
+      ~WriteSection() {
+        if constexpr (Concurrent)
+          arrays.seqlock.write_end();
+      }
+    };
+
+    VersionedLevelArrays() = default;
+
+    VersionedLevelArrays(const VersionedLevelArrays &) = delete;
+
+    VersionedLevelArrays &operator=(const VersionedLevelArrays &) = delete;
+
+    ~VersionedLevelArrays() { delete buffer.load(std::memory_order_relaxed); }
+
+    // Writer side accessors, the arrays stay valid until the next resize()
+    [[nodiscard]] size_t size() const { return count.load(std::memory_order_relaxed); }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] size_t lowest() const { return lowest_idx.load(std::memory_order_relaxed); }
+    [[nodiscard]] const Price *prices() const { return buffer.load(std::memory_order_relaxed)->prices; }
+    [[nodiscard]] const Quantity *sizes() const { return buffer.load(std::memory_order_relaxed)->sizes; }
+
+    void set_lowest(const size_t idx) { lowest_idx.store(idx, std::memory_order_relaxed); }
+
+    void add_size(const size_t idx, const Quantity delta) {
+      auto &size = buffer.load(std::memory_order_relaxed)->sizes[idx];
+      store(size, static_cast<Quantity>(size + delta));
+    }
+
+    // Grows or shrinks to new_count levels, level i of new slots is priced
+    // price_of(i) and empty
+    template<typename PriceOf>
+    void resize(const size_t new_count, PriceOf &&price_of) {
+      auto *current = buffer.load(std::memory_order_relaxed);
+      const auto old_count = size();
+      if (current == nullptr || new_count > current->capacity) {
+        const size_t old_capacity = current == nullptr ? 0 : current->capacity;
+        auto *grown = new Buffer(std::max(new_count, old_capacity * 2));
+        for (size_t i = 0; i < old_count; ++i) {
+          grown->prices[i] = current->prices[i];
+          grown->sizes[i] = current->sizes[i];
+        }
+        buffer.store(grown, std::memory_order_seq_cst);
+        if (current != nullptr) {
+          if constexpr (Concurrent)
+            reclaimer.retire([current] { delete current; });
+          else
+            delete current;
+        }
+        current = grown;
+      }
+      for (auto i = old_count; i < new_count; ++i) {
+        store(current->prices[i], static_cast<Price>(price_of(i)));
+        store(current->sizes[i], Quantity{0});
+      }
+      count.store(new_count, std::memory_order_relaxed);
+    }
+
+    // Reader side, may be called from any thread that registered a slot.
+    // f(prices, sizes, lowest, count) must only read the arrays through load()
+    // and is rerun until it saw a consistent version
+    size_t register_reader() requires Concurrent { return reclaimer.register_reader(); }
+
+    void unregister_reader(const size_t reader) requires Concurrent {
+      reclaimer.unregister_reader(reader);
+    }
+
+    template<typename T>
+    static T load(const T &src) {
+      if constexpr (Concurrent)
+        return std::atomic_ref<T>(const_cast<T &>(src)).load(std::memory_order_relaxed);
+      else
+        return src;
+    }
+
+    template<typename F>
+    auto read(const size_t reader, F &&f) requires Concurrent {
+      EpochReclaimer::Guard guard(reclaimer, reader);
+      while (true) {
+        const auto seq = seqlock.read_begin();
+        // seq_cst pairs with the writer publishing a new buffer before retiring
+        // the old one, see EpochReclaimer::Guard
+        const auto *current = buffer.load(std::memory_order_seq_cst);
+        const auto n = current == nullptr
+                         ? 0
+                         : std::min(count.load(std::memory_order_relaxed), current->capacity);
+        const Price *level_prices = current == nullptr ? nullptr : current->prices;
+        const Quantity *level_sizes = current == nullptr ? nullptr : current->sizes;
+        auto result = f(level_prices, level_sizes, lowest_idx.load(std::memory_order_relaxed), n);
+        if (!seqlock.read_retry(seq))
+          return result;
+      }
+    }
+
+    [[nodiscard]] size_t retired_buffer_count() const { return reclaimer.retired_count(); }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // VERSIONED_LEVEL_ARRAYS_H
@@ -9,7 +9,19 @@ namespace OrderBookProgrammingProblem {
   namespace Order {
     enum struct Side : char { Bid = 'B', Ask = 'A' };
 
-    enum struct Type : char { Add = 'A', Reduce = 'R' };
+    // Cancel removes what is left of an order, Replace gives it a new price
+    // and size (its side and id stay)
+    enum struct Type : char { Add = 'A', Reduce = 'R', Cancel = 'C', Replace = 'U' };
+
+    constexpr const char *type_name(const Type type) {
+      switch (type) {
+        case Type::Add: return "Add";
+        case Type::Reduce: return "Reduce";
+        case Type::Cancel: return "Cancel";
+        case Type::Replace: return "Replace";
+      }
+      return "Unknown";
+    }
 
     struct LimitOrder {
       uint64_t timestamp = 0;
@@ -36,14 +48,18 @@ namespace OrderBookProgrammingProblem {
 
       friend std::ostream &operator<<(std::ostream &os, const LimitOrder &order) {
         os << "LimitOrder { timestamp: " << order.timestamp
-            << ", type: " << (order.type == Type::Add ? "Add" : "Reduce")
+            << ", type: " << type_name(order.type)
             << ", id: " << order.id;
         if (order.type == Type::Add) {
           os << ", side: " << (order.side == Side::Ask ? "Ask" : "Bid")
               << ", price_cent: " << order.price_cent << ", size: " << order.size
               << " }";
-        } else {
+        } else if (order.type == Type::Replace) {
+          os << ", price_cent: " << order.price_cent << ", size: " << order.size << " }";
+        } else if (order.type == Type::Reduce) {
           os << ", size: " << order.size << " }";
+        } else {
+          os << " }";
         }
 
         return os;
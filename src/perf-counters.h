@@ -0,0 +1,179 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace OrderBookProgrammingProblem {
+  // Hardware counters of the calling thread, user space only (which works
+  // with the default perf_event_paranoid of 2), opened as one group so that
+  // every read covers the same interval for all of them. Counters the CPU or
+  // hypervisor does not offer read as 0 and are reported as unavailable.
+  class PerfCounters {
+  public:
+    enum Event : size_t { cycles, instructions, l1d_misses, llc_misses, branch_misses, event_count };
+
+    static constexpr std::array<std::string_view, event_count> event_names = {
+      "cycles", "instructions", "L1d misses", "LLC misses", "branch misses"
+    };
+
+    using Values = std::array<uint64_t, event_count>;
+
+  private:
+    std::array<int, event_count> fds{-1, -1, -1, -1, -1};
+    // Position of each event in a group read, event_count if not opened
+    std::array<size_t, event_count> slots{};
+    size_t opened = 0;
+
+    static perf_event_attr make_attr(const Event event) {
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      switch (event) {
+        case cycles:
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.config = PERF_COUNT_HW_CPU_CYCLES;
+          // The leader starts disabled and enables the whole group
+          attr.disabled = 1;
+          break;
+        case instructions:
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+          break;
+        case l1d_misses:
+          attr.type = PERF_TYPE_HW_CACHE;
+          attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+          break;
+        case llc_misses:
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.config = PERF_COUNT_HW_CACHE_MISSES;
+          break;
+        case branch_misses:
+          attr.type = PERF_TYPE_HARDWARE;
+          attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+          break;
+        case event_count:
+          break;
+      }
+      return attr;
+    }
+
+  public:
+    // Throws if not even the cycle counter can be opened, e.g., when
+    // perf_event_open() is blocked in a container
+    PerfCounters() {
+      slots.fill(event_count);
+      for (size_t e = 0; e < event_count; ++e) {
+        auto attr = make_attr(static_cast<Event>(e));
+        const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, fds[cycles], 0));
+        if (fd < 0) {
+          if (e == cycles)
+            throw std::system_error(errno, std::generic_category(), "perf_event_open(cycles)");
+          continue;
+        }
+        fds[e] = fd;
+        slots[e] = opened++;
+      }
+      ioctl(fds[cycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(fds[cycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    ~PerfCounters() {
+      for (const int fd: fds) {
+        if (fd >= 0)
+          close(fd);
+      }
+    }
+
+    [[nodiscard]] bool available(const Event event) const { return slots[event] != event_count; }
+
+    // One read() for the whole group
+    [[nodiscard]] Values read_values() const {
+      struct {
+        uint64_t nr;
+        std::array<uint64_t, event_count> values;
+      } group{};
+      Values values{};
+      if (read(fds[cycles], &group, sizeof(group)) <= 0)
+        return values;
+      for (size_t e = 0; e < event_count; ++e) {
+        if (slots[e] < group.nr)
+          values[e] = group.values[slots[e]];
+      }
+      return values;
+    }
+  };
+
+  // Splits the counters of a loop over messages into PhaseCount phases: each
+  // end_phase() charges what was counted since the previous one to a phase.
+  // Every boundary costs a read() system call, the user space part of which
+  // (a few hundred instructions) lands in the phases as well.
+  template<size_t PhaseCount>
+  class PerfPhaseProfile {
+    PerfCounters counters;
+    std::array<std::string_view, PhaseCount> phase_names;
+    std::array<PerfCounters::Values, PhaseCount> totals{};
+    PerfCounters::Values last{};
+    size_t message_count = 0;
+
+  public:
+    explicit PerfPhaseProfile(const std::array<std::string_view, PhaseCount> &names) : phase_names(names) {
+    }
+
+    void start_message() { last = counters.read_values(); }
+
+    void end_phase(const size_t phase) {
+      const auto now = counters.read_values();
+      for (size_t e = 0; e < PerfCounters::event_count; ++e)
+        totals[phase][e] += now[e] - last[e];
+      last = now;
+    }
+
+    void end_message() { ++message_count; }
+
+    // Per message averages, one row per phase
+    [[nodiscard]] std::string to_string() const {
+      std::string out = std::format("{:<8}", "phase");
+      for (const auto name: PerfCounters::event_names)
+        out += std::format(" {:>14}", name);
+      out += std::format(" {:>6}\n", "IPC");
+      const auto messages = static_cast<double>(std::max<size_t>(message_count, 1));
+      for (size_t phase = 0; phase < PhaseCount; ++phase) {
+        out += std::format("{:<8}", phase_names[phase]);
+        for (size_t e = 0; e < PerfCounters::event_count; ++e) {
+          if (counters.available(static_cast<PerfCounters::Event>(e)))
+            out += std::format(" {:>14.2f}", static_cast<double>(totals[phase][e]) / messages);
+          else
+            out += std::format(" {:>14}", "n/a");
+        }
+        const auto cycles = totals[phase][PerfCounters::cycles];
+        out += std::format(" {:>6.2f}\n", cycles == 0
+                                            ? 0.0
+                                            : static_cast<double>(totals[phase][PerfCounters::instructions]) /
+                                              static_cast<double>(cycles));
+      }
+      return out;
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // PERF_COUNTERS_H
@@ -14,6 +14,9 @@
 namespace OrderBookProgrammingProblem {
   class PriceLevelArray : public IPriceLevel<PriceLevelArray> {
     std::vector<std::shared_ptr<Order::LimitOrder> > orders;
+    // Kept after the last order leaves so that an emptied level can still be
+    // compared (e.g., located by BinarySearchTree::delete_node())
+    int level_price_cent = 0;
 
   public:
     void FUNC_ATTRIBUTE add_order_impl(const std::shared_ptr<Order::LimitOrder> &new_order) {
@@ -23,6 +26,7 @@ namespace OrderBookProgrammingProblem {
             "new_order does not belong to this price level");
       }
 
+      level_price_cent = new_order->price_cent;
       orders.push_back(new_order);
     }
 
@@ -36,6 +40,7 @@ namespace OrderBookProgrammingProblem {
           if (orders[i]->size == 0) {
             std::swap(orders[i], orders.back());
             orders.pop_back();
+            return 0;
           }
           return orders[i]->size;
         }
@@ -74,19 +79,19 @@ namespace OrderBookProgrammingProblem {
 
     // Custom three-way comparison
     auto operator<=>(const PriceLevelArray &other) const {
-      return orders.front()->price_cent <=> other.orders.front()->price_cent;
+      return level_price_cent <=> other.level_price_cent;
     }
 
     auto operator<=>(const int other) const {
-      return orders.front()->price_cent <=> other;
+      return level_price_cent <=> other;
     }
 
     bool operator==(const PriceLevelArray &other) const {
-      return orders.front()->price_cent == other.orders.front()->price_cent;
+      return level_price_cent == other.level_price_cent;
     }
 
     bool operator==(const int other) const {
-      return orders.front()->price_cent == other;
+      return level_price_cent == other;
     }
   };
 } // namespace OrderBookProgrammingProblem
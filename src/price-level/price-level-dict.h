@@ -5,12 +5,14 @@
 #include "../utils.h"
 #include "price-level-interface.h"
 
+#include <format>
 #include <memory>
 #include <unordered_map>
 
 namespace OrderBookProgrammingProblem {
 class PriceLevelDict : public IPriceLevel<PriceLevelDict> {
   std::unordered_map<std::string, std::shared_ptr<Order::LimitOrder>> orders;
+  int level_price_cent = 0;
 
 public:
   PriceLevelDict() = default;
@@ -23,24 +25,25 @@ public:
             "new_order does not belong to this price level");
     }
 
+    level_price_cent = new_order->price_cent;
     orders[new_order->id] = new_order;
   }
 
   int FUNC_ATTRIBUTE
   update_order_impl(const std::shared_ptr<Order::LimitOrder> &new_order) {
-    for (const auto &[k, val] : orders) {
-      if (k == new_order->id) {
-        val->size -= new_order->size;
-        if (val->size < 0) {
-          throw std::invalid_argument("new_order size is negative");
-        }
-        if (val->size == 0) {
-          orders.erase(k);
-        }
-        return val->size;
-      }
+    const auto it = orders.find(new_order->id);
+    if (it == orders.end())
+      return -1;
+    const auto &val = it->second;
+    val->size -= new_order->size;
+    if (val->size < 0) {
+      throw std::invalid_argument("new_order size is negative");
+    }
+    if (val->size == 0) {
+      orders.erase(it);
+      return 0;
     }
-    return -1;
+    return val->size;
   }
 
   [[nodiscard]] std::optional<int> FUNC_ATTRIBUTE get_level_size_impl() const {
@@ -60,6 +63,31 @@ public:
     }
     return orders.begin()->second->price_cent;
   }
+
+  [[nodiscard]] std::string to_string_impl() const {
+    if (orders.empty()) {
+      return "";
+    }
+    std::string repr = "{";
+    for (const auto &[k, val] : orders) {
+      repr += std::format(" {{ id: {:>5}, size: {:>4} }}, ", k, val->size);
+    }
+    repr.pop_back();
+    repr.pop_back();
+    return repr + " }";
+  }
+
+  auto operator<=>(const PriceLevelDict &other) const {
+    return level_price_cent <=> other.level_price_cent;
+  }
+
+  auto operator<=>(const int other) const { return level_price_cent <=> other; }
+
+  bool operator==(const PriceLevelDict &other) const {
+    return level_price_cent == other.level_price_cent;
+  }
+
+  bool operator==(const int other) const { return level_price_cent == other; }
 };
 } // namespace OrderBookProgrammingProblem
 #endif // PRICE_LEVEL_DICT_H
@@ -5,12 +5,14 @@
 #include "../utils.h"
 #include "price-level-interface.h"
 
+#include <format>
 #include <list>
 
 namespace OrderBookProgrammingProblem {
 class PriceLevelDoublyLinkedList
     : public IPriceLevel<PriceLevelDoublyLinkedList> {
   std::list<std::shared_ptr<Order::LimitOrder>> orders;
+  int level_price_cent = 0;
 
 public:
   PriceLevelDoublyLinkedList() = default;
@@ -23,19 +25,22 @@ public:
             "new_order does not belong to this price level");
     }
 
+    level_price_cent = new_order->price_cent;
     orders.push_back(new_order);
   }
 
   int FUNC_ATTRIBUTE
   update_order_impl(const std::shared_ptr<Order::LimitOrder> &new_order) {
-    for (auto const &order : orders) {
+    for (auto it = orders.begin(); it != orders.end(); ++it) {
+      const auto &order = *it;
       if (order->id == new_order->id) {
         order->size -= new_order->size;
         if (order->size < 0) {
           throw std::invalid_argument("new_order size is negative");
         }
         if (order->size == 0) {
-          orders.remove(order);
+          orders.erase(it);
+          return 0;
         }
         return order->size;
       }
@@ -60,6 +65,32 @@ public:
     }
     return orders.front()->price_cent;
   }
+
+  [[nodiscard]] std::string to_string_impl() const {
+    if (orders.empty()) {
+      return "";
+    }
+    std::string repr = "{";
+    for (const auto &order : orders) {
+      repr += std::format(" {{ id: {:>5}, size: {:>4} }}, ", order->id,
+                          order->size);
+    }
+    repr.pop_back();
+    repr.pop_back();
+    return repr + " }";
+  }
+
+  auto operator<=>(const PriceLevelDoublyLinkedList &other) const {
+    return level_price_cent <=> other.level_price_cent;
+  }
+
+  auto operator<=>(const int other) const { return level_price_cent <=> other; }
+
+  bool operator==(const PriceLevelDoublyLinkedList &other) const {
+    return level_price_cent == other.level_price_cent;
+  }
+
+  bool operator==(const int other) const { return level_price_cent == other; }
 };
 } // namespace OrderBookProgrammingProblem
 #endif // PRICE_LEVEL_DOUBLY_LINKED_LIST_H
@@ -33,6 +33,8 @@ namespace OrderBookProgrammingProblem {
       return static_cast<T *>(this)->add_order_impl(new_order);
     }
 
+    // Reduces the matching order by new_order->size, returns the remaining size
+    // of the order (0 if it left the level) or -1 if it is not in this level
     int update_order(const std::shared_ptr<Order::LimitOrder> &new_order) {
       return static_cast<T *>(this)->update_order_impl(new_order);
     }
@@ -0,0 +1,46 @@
+#ifndef PRICER_OUTPUT_H
+#define PRICER_OUTPUT_H
+
+#include "utils.h"
+
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <string>
+
+// Output format of pricer, shared with replay-bench so that both produce
+// byte-identical lines
+namespace OrderBookProgrammingProblem {
+  template<typename Cost>
+  bool FUNC_ATTRIBUTE
+  update_previous_cost_cent(const std::optional<Cost> new_cost_cent,
+                            std::optional<Cost> &previous_cost_cent) {
+    if (new_cost_cent != previous_cost_cent) {
+      previous_cost_cent = new_cost_cent;
+      return true;
+    }
+    return false;
+  }
+
+  // e.g., "28800744 S 8832.56" or "28800758 B NA", without the newline
+  template<typename Cost>
+  std::string format_cost_line(const uint64_t timestamp, const std::optional<Cost> cost_cent,
+                               const bool is_sell) {
+    std::string line = std::to_string(timestamp) + (is_sell ? " S " : " B ");
+    if (cost_cent.has_value())
+      line += std::format("{:.2f}", cost_cent.value() / 100.0);
+    else
+      line += "NA";
+    return line;
+  }
+
+  // e.g., "28800744 7 S 8832.56" for subscription 7
+  template<typename Cost>
+  std::string format_subscription_line(const uint64_t timestamp, const size_t id,
+                                       const std::optional<Cost> cost_cent, const bool is_sell) {
+    return std::to_string(timestamp) + " " + std::to_string(id) +
+           format_cost_line(timestamp, cost_cent, is_sell).substr(std::to_string(timestamp).size());
+  }
+} // namespace OrderBookProgrammingProblem
+
+#endif // PRICER_OUTPUT_H
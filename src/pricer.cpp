@@ -1,84 +1,316 @@
-#include "order-book/order-book-array.h"
-#include "order-book/order-book-bst.h"
-#include "order-book/order-book-std-map.h"
+#include "allocation-stats.h"
+#include "cpu-pinning.h"
+#include "huge-page-arena.h"
+#include "input/input-source-registry.h"
+#include "journal/book-checkpoint.h"
+#include "journal/event-journal.h"
+#include "order-book/order-book-registry.h"
+#include "perf-counters.h"
+#include "pricer-output.h"
+#include "pricing-subscriptions.h"
+#include "shm/shm-book-publisher.h"
 #include "utils.h"
 
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <fstream>
 #include <iostream>
+#include <new>
+#include <optional>
 #include <ranges>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace Problem = OrderBookProgrammingProblem;
 namespace Order = Problem::Order;
 
-
-#ifdef ORDER_BOOK_IMPL_ARRAY
-using OrderBookImpl = Problem::OrderBookArray;
-#elif ORDER_BOOK_IMPL_BST
-using OrderBookImpl = Problem::OrderBookBst;
-#elif ORDER_BOOK_IMPL_STD_MAP
-using OrderBookImpl = Problem::OrderBookStdMap;
+// Book used when --order-book is not given, each pricer-* target sets its own
+#ifndef DEFAULT_ORDER_BOOK_IMPL
+#define DEFAULT_ORDER_BOOK_IMPL "array"
 #endif
-//using OrderBookImpl = Problem::OrderBookStdMap;
 
+namespace {
+  // Set by --huge-page-arena=, from then on the allocations of the thread that
+  // set it (the one applying the feed) are served from it. Other threads, such
+  // as the decompressing reader, keep using malloc. Never destroyed, as
+  // static destructors still free arena blocks after main() returns
+  Problem::HugePageArena *arena = nullptr;
+  thread_local bool on_arena_thread = false;
+  // Allocations the arena could not fit, served by malloc instead
+  size_t arena_overflow_count = 0;
+
+  // With --count-allocations, set while the thread applying the feed
+  // processes a message
+  thread_local bool tracking_allocations = false;
+  thread_local size_t tracked_allocation_count = 0;
+  // With --abort-on-allocation, set while tracking in the steady state
+  thread_local bool abort_on_allocation = false;
 
-bool FUNC_ATTRIBUTE
-update_previous_cost_cent(const std::optional<int> new_cost_cent,
-                          std::optional<int> &previous_cost_cent) {
-  if (new_cost_cent != previous_cost_cent) {
-    previous_cost_cent = new_cost_cent;
-    return true;
+  [[noreturn]] void abort_on_tracked_allocation() {
+    constexpr std::string_view msg = "Heap allocation on the hot path in the steady state, aborting\n";
+    [[maybe_unused]] const auto written = write(STDERR_FILENO, msg.data(), msg.size());
+    std::abort();
   }
-  return false;
+
+  // Leaves the allocations of debug output, which BENCHMARK_PERFORMANCE
+  // compiles out, out of the counts
+  class UntrackedAllocations {
+    const bool was_tracking = tracking_allocations;
+
+  public:
+    UntrackedAllocations() { tracking_allocations = false; }
+
+    UntrackedAllocations(const UntrackedAllocations &) = delete;
+
+    UntrackedAllocations &operator=(const UntrackedAllocations &) = delete;
+
+    ~UntrackedAllocations() { tracking_allocations = was_tracking; }
+  };
+
+  void *allocate(const size_t size, const size_t alignment) {
+    if (tracking_allocations) {
+      ++tracked_allocation_count;
+      if (abort_on_allocation)
+        abort_on_tracked_allocation();
+    }
+    if (on_arena_thread) {
+      if (void *p = arena->allocate(size, alignment); p != nullptr)
+        return p;
+      ++arena_overflow_count;
+    }
+    void *p = alignment <= alignof(std::max_align_t)
+                ? std::malloc(size == 0 ? 1 : size)
+                : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (p == nullptr)
+      throw std::bad_alloc();
+    return p;
+  }
+
+  void deallocate(void *p) noexcept {
+    if (arena != nullptr && arena->contains(p)) {
+      // The free lists are not thread-safe, a block freed by another thread
+      // is given up
+      if (on_arena_thread)
+        arena->deallocate(p);
+      return;
+    }
+    std::free(p);
+  }
+} // namespace
+
+void *operator new(const size_t size) { return allocate(size, alignof(std::max_align_t)); }
+
+void *operator new(const size_t size, const std::align_val_t alignment) {
+  return allocate(size, static_cast<size_t>(alignment));
 }
 
+void operator delete(void *p) noexcept { deallocate(p); }
+
+void operator delete(void *p, size_t) noexcept { deallocate(p); }
+
+void operator delete(void *p, std::align_val_t) noexcept { deallocate(p); }
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept { deallocate(p); }
+
+template<typename Cost>
 void FUNC_ATTRIBUTE print_new_cost(const Order::LimitOrder &lo,
-                                   const std::optional<int> new_cost_cent,
+                                   const std::optional<Cost> new_cost_cent,
                                    const bool is_sell) {
-  std::string line = std::to_string(lo.timestamp) + (is_sell ? " S " : " B ");
-  if (new_cost_cent.has_value())
-    line += std::format("{:.2f}", new_cost_cent.value() / 100.0);
-  else
-    line += "NA";
+  const UntrackedAllocations untracked;
+  const auto line = Problem::format_cost_line(lo.timestamp, new_cost_cent, is_sell);
   std::cout << line << "\n";
   std::cerr << line << "\n\n";
 }
 
-int main(const int argc, char *argv[]) {
+struct PricerOptions {
   int target_size = 200;
-  if (argc == 2) {
-    target_size = std::stoi(argv[1]);
+  std::string order_book = DEFAULT_ORDER_BOOK_IMPL;
+  // Read instead of stdin if set
+  std::string input_file;
+  // One of input_source_names, by default picked from the extension of
+  // input_file, e.g., "gzip" for "pricer.in.gz"
+  std::string input_source;
+  // Apply all orders sharing a timestamp as one batch and price once per
+  // batch, so at most one line per side is emitted for each timestamp
+  bool price_per_timestamp = false;
+  // POSIX shared memory object (e.g. "/pricer") to publish the book into
+  // after every pricing, see src/shm/shm-book-layout.h
+  std::string shm_name;
+  // Low latency run mode, each setting is applied to the thread applying the
+  // feed (main) before the book is built: serve its allocations from a
+  // pre-faulted huge page arena of that many MiB, lock the process memory,
+  // pin it to a CPU and prefer allocating on a NUMA node
+  size_t huge_page_arena_mib = 0;
+  bool lock_memory = false;
+  std::optional<int> cpu;
+  std::optional<int> numa_node;
+  // Report the heap allocations of the thread applying the feed per message
+  // type at exit. From message allocation_free_after on, every message that
+  // still allocates is flagged, or aborts the run with abort_on_allocation
+  bool count_allocations = false;
+  std::optional<size_t> allocation_free_after;
+  bool abort_on_allocation = false;
+  // Records that cannot be parsed or applied are skipped and counted by
+  // reason, and also appended to this file (one "reason<TAB>line" per record)
+  // if set
+  std::string quarantine_file;
+  // One "S|B target-size threshold-cents" subscription per line. When set,
+  // stdout carries a "timestamp id S|B cost" line whenever the cost of a
+  // subscription moves by more than its threshold, instead of the lines for
+  // target_size
+  std::string subscriptions_file;
+  // Every applied message is appended to this journal (see
+  // src/journal/event-journal.h), synced every journal_commit_ms. A journal
+  // that already has records is replayed into the book first, and input
+  // lines up to the last one it recorded are skipped, so that rerunning on
+  // the same feed after a crash resumes where it stopped
+  std::string journal_file;
+  int journal_commit_ms = 10;
+  // Query mode: print the book and the costs of target_size as of this
+  // timestamp, then exit. With checkpoint_index (see checkpoint-index.cpp),
+  // the book is loaded from the latest checkpoint not past it and only the
+  // rest of the feed up to it is replayed
+  std::optional<uint64_t> at_timestamp;
+  std::string checkpoint_index;
+};
+
+PricerOptions parse_pricer_options(const int argc, char *argv[]) {
+  PricerOptions opts;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--price-per-timestamp")
+      opts.price_per_timestamp = true;
+    else if (arg.starts_with("--shm="))
+      opts.shm_name = arg.substr(std::string_view("--shm=").size());
+    else if (arg.starts_with("--input-file="))
+      opts.input_file = arg.substr(std::string_view("--input-file=").size());
+    else if (arg.starts_with("--input="))
+      opts.input_source = arg.substr(std::string_view("--input=").size());
+    else if (arg.starts_with("--order-book="))
+      opts.order_book = arg.substr(std::string_view("--order-book=").size());
+    else if (arg.starts_with("--huge-page-arena="))
+      opts.huge_page_arena_mib = std::stoul(std::string(arg.substr(std::string_view("--huge-page-arena=").size())));
+    else if (arg == "--mlock")
+      opts.lock_memory = true;
+    else if (arg.starts_with("--cpu="))
+      opts.cpu = std::stoi(std::string(arg.substr(std::string_view("--cpu=").size())));
+    else if (arg.starts_with("--numa-node="))
+      opts.numa_node = std::stoi(std::string(arg.substr(std::string_view("--numa-node=").size())));
+    else if (arg == "--count-allocations")
+      opts.count_allocations = true;
+    else if (arg.starts_with("--allocation-free-after="))
+      opts.allocation_free_after = std::stoul(
+        std::string(arg.substr(std::string_view("--allocation-free-after=").size())));
+    else if (arg == "--abort-on-allocation")
+      opts.abort_on_allocation = true;
+    else if (arg.starts_with("--quarantine="))
+      opts.quarantine_file = arg.substr(std::string_view("--quarantine=").size());
+    else if (arg.starts_with("--subscriptions="))
+      opts.subscriptions_file = arg.substr(std::string_view("--subscriptions=").size());
+    else if (arg.starts_with("--journal="))
+      opts.journal_file = arg.substr(std::string_view("--journal=").size());
+    else if (arg.starts_with("--journal-commit-ms="))
+      opts.journal_commit_ms = std::stoi(std::string(arg.substr(std::string_view("--journal-commit-ms=").size())));
+    else if (arg.starts_with("--at="))
+      opts.at_timestamp = std::stoull(std::string(arg.substr(std::string_view("--at=").size())));
+    else if (arg.starts_with("--checkpoint-index="))
+      opts.checkpoint_index = arg.substr(std::string_view("--checkpoint-index=").size());
+    else
+      opts.target_size = std::stoi(argv[i]);
+  }
+  if (opts.input_source.empty())
+    opts.input_source = Problem::input_source_for_path(opts.input_file);
+  if (opts.abort_on_allocation && !opts.allocation_free_after.has_value())
+    throw std::invalid_argument("--abort-on-allocation needs --allocation-free-after=");
+  opts.count_allocations = opts.count_allocations || opts.allocation_free_after.has_value();
+  return opts;
+}
+
+// The NUMA policy goes first so that the arena is faulted in on that node
+void apply_run_mode(const PricerOptions &opts, const char *prog_name) {
+  if (opts.numa_node.has_value())
+    Problem::prefer_numa_node(*opts.numa_node);
+  if (opts.cpu.has_value())
+    Problem::pin_current_thread(*opts.cpu);
+  if (opts.lock_memory)
+    Problem::lock_process_memory();
+  if (opts.huge_page_arena_mib > 0) {
+    arena = new Problem::HugePageArena(opts.huge_page_arena_mib << 20);
+    on_arena_thread = true;
+  }
+  if (opts.huge_page_arena_mib == 0 && !opts.lock_memory && !opts.cpu && !opts.numa_node)
+    return;
+  std::cerr << prog_name << " run mode: huge page arena: "
+      << (arena == nullptr ? "off" : std::format("{} MiB ({})", arena->size() >> 20, arena->backing()))
+      << ", memory locked: " << (opts.lock_memory ? "yes" : "no")
+      << ", cpu: " << (opts.cpu.has_value() ? std::to_string(*opts.cpu) : "any")
+      << ", numa node: " << (opts.numa_node.has_value() ? std::to_string(*opts.numa_node) : "any")
+      << std::endl;
+}
+
+// Subscribes to every line of path, ids are given in file order from 0
+template<typename Cost, typename OrderBookImpl>
+void load_subscriptions(const std::string &path, OrderBookImpl &order_book,
+                        Problem::PricingSubscriptions<Cost> &subscriptions) {
+  std::ifstream in(path);
+  if (!in)
+    throw std::system_error(errno, std::generic_category(), "open(" + path + ")");
+  std::string side;
+  int target_size = 0;
+  Cost threshold_cent = 0;
+  while (in >> side >> target_size >> threshold_cent) {
+    if (side != "S" && side != "B")
+      throw std::invalid_argument("Subscription side must be S or B: " + side);
+    subscriptions.subscribe(order_book, side == "S" ? Order::Side::Bid : Order::Side::Ask, target_size,
+                            threshold_cent);
   }
+  if (!in.eof())
+    throw std::invalid_argument("Malformed subscription in " + path);
+}
+
+template<typename OrderBookImpl, typename InputSource>
+int run_pricer(const PricerOptions &opts, const char *prog_name,
+               Problem::IInputSource<InputSource> &input) {
+  const int target_size = opts.target_size;
   if constexpr (!benchmark_performance)
-    std::cerr << argv[0] << " started with target size: " << target_size
+    std::cerr << prog_name << " started with target size: " << target_size
+        << ", order book: " << opts.order_book
+        << ", input: " << opts.input_source
+        << (opts.price_per_timestamp ? ", pricing once per timestamp" : "")
         << std::endl;
   auto order_book = OrderBookImpl();
+  using Cost = typename decltype(order_book.get_pricer_sell_cost_cent(
+    target_size))::value_type;
   Problem::Utils utils;
-  std::string in_line;
-  std::optional<Order::LimitOrder> prev_lo;
+  uint64_t prev_timestamp = 0;
+  // Orders sharing the timestamp of batch.back(), only used with
+  // --price-per-timestamp, and their lines if they may be quarantined
+  std::vector<Order::LimitOrder> batch;
+  std::vector<std::string> batch_lines;
+  std::optional<Problem::Shm::BookPublisher> publisher;
+  if (!opts.shm_name.empty())
+    publisher.emplace(opts.shm_name);
   size_t price_change_count = 0;
   // buy/sell here is from pricer's perspective
-  std::optional<int> sell_cost_cent = std::nullopt;
-  std::optional<int> buy_cost_cent = std::nullopt;
-  // Asked Microsoft Copilot and confirmed by checking source code,
-  // std::getline() reuses in_line, it wont allocate new std::string each time
-  while (std::getline(std::cin, in_line)) {
-    if constexpr (!benchmark_performance) {
-      std::cerr << "===== new order comes in =====\n";
-    }
-    const auto lo = utils.parse_limit_order(in_line);
-    if (prev_lo.has_value()) {
-      if (lo.timestamp < prev_lo->timestamp)
-        throw std::invalid_argument("timestamp not monotonically increasing");
-    }
-    prev_lo = lo;
-    order_book.add_order(lo);
+  std::optional<Cost> sell_cost_cent = std::nullopt;
+  std::optional<Cost> buy_cost_cent = std::nullopt;
+
+  auto price_both_sides = [&](const Order::LimitOrder &lo) {
     if constexpr (!benchmark_performance) {
-      std::cerr << "LimitOrder: " << lo << "\n";
+      const UntrackedAllocations untracked;
       std::cerr << "OrderBook:\n" << order_book.to_string() << std::endl;
     }
     const auto new_sell_cost_cent =
         order_book.get_pricer_sell_cost_cent(target_size);
-    if (update_previous_cost_cent(new_sell_cost_cent, sell_cost_cent)) {
+    if (Problem::update_previous_cost_cent(new_sell_cost_cent, sell_cost_cent)) {
       if constexpr (!benchmark_performance)
         print_new_cost(lo, new_sell_cost_cent, true);
       else
@@ -86,17 +318,297 @@ int main(const int argc, char *argv[]) {
     }
     const auto new_buy_cost_cent =
         order_book.get_pricer_buy_cost_cent(target_size);
-    if (update_previous_cost_cent(new_buy_cost_cent, buy_cost_cent)) {
+    if (Problem::update_previous_cost_cent(new_buy_cost_cent, buy_cost_cent)) {
       if constexpr (!benchmark_performance)
         print_new_cost(lo, new_buy_cost_cent, false);
       else
         ++price_change_count;
     }
+    if (publisher.has_value())
+      publisher->publish(lo.timestamp, order_book, target_size, sell_cost_cent, buy_cost_cent);
+  };
+
+  // Recovery restores the book and the last costs without printing, what
+  // was printed before the crash is not repeated
+  std::optional<Problem::Journal::EventJournal> journal;
+  // Input lines up to this one are already in the journal
+  uint64_t replayed_lines = 0;
+  if (!opts.journal_file.empty()) {
+    journal.emplace(opts.journal_file, size_t{64} << 20, std::chrono::milliseconds(opts.journal_commit_ms));
+    const auto start = std::chrono::steady_clock::now();
+    journal->replay([&](uint64_t, const Order::LimitOrder &lo) {
+      if (const auto applied = order_book.try_add_order(lo); !applied.has_value())
+        throw std::runtime_error(std::format("Journal {} does not replay: {} on {}", opts.journal_file,
+                                             Problem::to_string(applied.error()), lo.id));
+      prev_timestamp = lo.timestamp;
+    });
+    replayed_lines = journal->last_sequence_number();
+    sell_cost_cent = order_book.get_pricer_sell_cost_cent(target_size);
+    buy_cost_cent = order_book.get_pricer_buy_cost_cent(target_size);
+    std::cerr << prog_name << " recovered " << journal->size() << " message(s) from " << opts.journal_file << " in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()
+        << " ms, resuming after input line " << replayed_lines << std::endl;
+  }
+  uint64_t line_number = 0;
+  // Sequences of the batch entries, 0 once rejected
+  std::vector<uint64_t> batch_sequences;
+
+  std::optional<Problem::PricingSubscriptions<Cost> > subscriptions;
+  if (!opts.subscriptions_file.empty()) {
+    subscriptions.emplace();
+    load_subscriptions(opts.subscriptions_file, order_book, *subscriptions);
+    if constexpr (!benchmark_performance)
+      std::cerr << prog_name << " loaded " << subscriptions->size() << " subscription(s)" << std::endl;
+  }
+  auto notify_subscriber = [&](const Order::LimitOrder &lo) {
+    return [&](const size_t id, const Order::Side side, const std::optional<Cost> cost_cent) {
+      if constexpr (!benchmark_performance) {
+        const UntrackedAllocations untracked;
+        const auto line = Problem::format_subscription_line(lo.timestamp, id, cost_cent, side == Order::Side::Bid);
+        std::cout << line << "\n";
+        std::cerr << line << "\n\n";
+      } else {
+        ++price_change_count;
+      }
+    };
+  };
+
+  std::optional<Problem::AllocationStats> allocation_stats;
+  if (opts.count_allocations)
+    allocation_stats.emplace(opts.allocation_free_after.value_or(SIZE_MAX));
+  size_t message_count = 0;
+  size_t flagged_message_count = 0;
+  auto track_message = [&] {
+    if (!allocation_stats.has_value())
+      return;
+    tracked_allocation_count = 0;
+    tracking_allocations = true;
+    abort_on_allocation = opts.abort_on_allocation && allocation_stats->in_steady_state();
+  };
+  // The first few steady state messages that allocated are printed, the
+  // rest only counted
+  auto record_message = [&](const Order::LimitOrder &lo) {
+    ++message_count;
+    if (!allocation_stats.has_value())
+      return;
+    tracking_allocations = abort_on_allocation = false;
+    if (allocation_stats->record(lo.type, tracked_allocation_count) && ++flagged_message_count <= 10)
+      std::cerr << prog_name << " " << tracked_allocation_count << " allocation(s) in the steady state on message "
+          << message_count << ": " << lo << std::endl;
+  };
+
+  // With BENCHMARK_PERFORMANCE, hardware counters are split between the
+  // phases of each message. The line read is charged to parse, and in
+  // --price-per-timestamp mode the pricing of a batch to the message that
+  // closed it
+  enum Phase : size_t { parse_phase, apply_phase, price_phase };
+  std::optional<Problem::PerfPhaseProfile<3> > perf_profile;
+  if constexpr (benchmark_performance) {
+    try {
+      perf_profile.emplace(std::array<std::string_view, 3>{"parse", "apply", "price"});
+    } catch (const std::system_error &e) {
+      std::cerr << prog_name << " hardware counters unavailable: " << e.what() << std::endl;
+    }
+  }
+  auto end_phase = [&](const Phase phase) {
+    if constexpr (benchmark_performance) {
+      if (perf_profile.has_value())
+        perf_profile->end_phase(phase);
+    }
+  };
+
+  Problem::RejectCounts rejects;
+  std::ofstream quarantine;
+  if (!opts.quarantine_file.empty()) {
+    quarantine.open(opts.quarantine_file, std::ios::app);
+    if (!quarantine)
+      throw std::system_error(errno, std::generic_category(), "open(" + opts.quarantine_file + ")");
+  }
+  auto record_reject = [&](const std::string_view line, const Problem::RejectReason reason) {
+    const UntrackedAllocations untracked;
+    rejects.record(reason);
+    if constexpr (!benchmark_performance)
+      std::cerr << "Rejected (" << Problem::to_string(reason) << "): " << line << "\n";
+    if (quarantine.is_open())
+      quarantine << Problem::to_string(reason) << '\t' << line << '\n';
+  };
+  // A rejected message ends there, it is neither applied nor priced
+  auto reject_message = [&](const std::string_view line, const Problem::RejectReason reason) {
+    tracking_allocations = abort_on_allocation = false;
+    ++message_count;
+    if constexpr (benchmark_performance) {
+      if (perf_profile.has_value())
+        perf_profile->end_message();
+    }
+    record_reject(line, reason);
+  };
+
+  auto flush_batch = [&] {
+    if (batch.empty())
+      return;
+    order_book.try_add_orders(batch, [&](const size_t i, const Problem::RejectReason reason) {
+      record_reject(batch_lines.empty() ? "id " + batch[i].id : batch_lines[i], reason);
+      if (journal.has_value())
+        batch_sequences[i] = 0;
+    });
+    if (journal.has_value()) {
+      for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch_sequences[i] != 0)
+          journal->append(batch_sequences[i], batch[i]);
+      }
+      batch_sequences.clear();
+    }
+    end_phase(apply_phase);
+    // Which levels a batch changed is not tracked
+    if (subscriptions.has_value())
+      subscriptions->on_any_change(order_book, notify_subscriber(batch.back()));
+    else
+      price_both_sides(batch.back());
+    end_phase(price_phase);
+    batch.clear();
+    batch_lines.clear();
+  };
+
+  while (const auto in_line = input.next_line()) {
+    if (++line_number <= replayed_lines) [[unlikely]]
+      continue;
+    track_message();
+    if constexpr (benchmark_performance) {
+      if (perf_profile.has_value())
+        perf_profile->start_message();
+    }
+    if constexpr (!benchmark_performance) {
+      std::cerr << "===== new order comes in =====\n";
+    }
+    const auto parsed = utils.try_parse_limit_order(in_line.value());
+    end_phase(parse_phase);
+    if (!parsed.has_value()) [[unlikely]] {
+      reject_message(in_line.value(), parsed.error());
+      continue;
+    }
+    const auto &lo = parsed.value();
+    if (lo.timestamp < prev_timestamp) [[unlikely]] {
+      reject_message(in_line.value(), Problem::RejectReason::timestamp_out_of_order);
+      continue;
+    }
+    prev_timestamp = lo.timestamp;
+    if constexpr (!benchmark_performance) {
+      const UntrackedAllocations untracked;
+      std::cerr << "LimitOrder: " << lo << "\n";
+    }
+    if (opts.price_per_timestamp) {
+      if (!batch.empty() && batch.back().timestamp != lo.timestamp)
+        flush_batch();
+      batch.push_back(lo);
+      if (journal.has_value())
+        batch_sequences.push_back(line_number);
+      if (quarantine.is_open())
+        batch_lines.emplace_back(in_line.value());
+      end_phase(apply_phase);
+    } else {
+      const auto applied = order_book.try_add_order(lo);
+      if (journal.has_value() && applied.has_value())
+        journal->append(line_number, lo);
+      end_phase(apply_phase);
+      if (!applied.has_value()) [[unlikely]] {
+        reject_message(in_line.value(), applied.error());
+        continue;
+      }
+      if (subscriptions.has_value())
+        subscriptions->on_change(order_book, applied.value(), notify_subscriber(lo));
+      else
+        price_both_sides(lo);
+      end_phase(price_phase);
+    }
+    if constexpr (benchmark_performance) {
+      if (perf_profile.has_value())
+        perf_profile->end_message();
+    }
+    record_message(lo);
   }
+  flush_batch();
   // Even with benchmark_performance == true we'd better print something
   // meaningful at the end...just in case the compiler is super smart and
   // optimizes everything away
-  std::cerr << argv[0] << " exited gracefully, price changed "
+  std::cerr << prog_name << " exited gracefully, price changed "
       << price_change_count << " time(s)" << std::endl;
+  if (rejects.total() > 0)
+    std::cerr << prog_name << " rejected " << rejects.total() << " record(s): " << rejects.to_string() << std::endl;
+  if (arena != nullptr)
+    std::cerr << prog_name << " huge page arena: " << (arena->used() >> 10) << " KiB of "
+        << (arena->size() >> 10) << " KiB used, " << arena_overflow_count
+        << " allocation(s) overflowed to malloc" << std::endl;
+  if (perf_profile.has_value())
+    std::cerr << prog_name << " hardware counters per message:\n" << perf_profile->to_string() << std::flush;
+  if (allocation_stats.has_value())
+    std::cerr << prog_name << " heap allocations per message (steady state from message "
+        << (opts.allocation_free_after.has_value() ? std::to_string(*opts.allocation_free_after) : "-")
+        << "):\n" << allocation_stats->to_string() << std::flush;
   return 0;
 }
+
+// Query mode, input starts right after checkpoint (or at the beginning of
+// the feed without one) once skip_lines are skipped
+template<typename OrderBookImpl, typename InputSource>
+int query_book(const PricerOptions &opts, const char *prog_name, Problem::IInputSource<InputSource> &input,
+               const std::optional<Problem::Journal::Checkpoint> &checkpoint, const uint64_t skip_lines) {
+  const auto start = std::chrono::steady_clock::now();
+  auto order_book = OrderBookImpl();
+  const auto restored = checkpoint.has_value() ? Problem::Journal::load_checkpoint(order_book, checkpoint->path) : 0;
+  for (uint64_t i = 0; i < skip_lines; ++i) {
+    if (!input.next_line().has_value())
+      break;
+  }
+  const auto at = opts.at_timestamp.value();
+  const auto from = checkpoint.has_value() ? checkpoint->timestamp : 0;
+  const auto replayed = Problem::Journal::replay_until(order_book, input, from, at);
+  std::cerr << prog_name << " restored " << restored << " order(s) from "
+      << (checkpoint.has_value() ? checkpoint->path : "no checkpoint") << ", replayed " << replayed << " line(s) in "
+      << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()
+      << " ms" << std::endl;
+  std::cout << Problem::format_cost_line(at, order_book.get_pricer_sell_cost_cent(opts.target_size), true) << "\n"
+      << Problem::format_cost_line(at, order_book.get_pricer_buy_cost_cent(opts.target_size), false) << "\n";
+  for (const auto side: {Order::Side::Ask, Order::Side::Bid}) {
+    order_book.for_each_level(side, [&](const auto price_cent, const auto level_size) {
+      std::cout << std::format("{} {:.2f} {}\n", side == Order::Side::Ask ? "ask" : "bid", price_cent / 100.0,
+                               level_size);
+      return true;
+    });
+  }
+  return 0;
+}
+
+int main(const int argc, char *argv[]) {
+  const auto opts = parse_pricer_options(argc, argv);
+  // Every input source reads stdin
+  if (!opts.input_file.empty() && std::freopen(opts.input_file.c_str(), "rb", stdin) == nullptr) {
+    std::cerr << "Failed to open " << opts.input_file << ": " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+  if (opts.at_timestamp.has_value()) {
+    std::optional<Problem::Journal::Checkpoint> checkpoint;
+    if (!opts.checkpoint_index.empty())
+      checkpoint = Problem::Journal::CheckpointIndex(opts.checkpoint_index).latest_at(*opts.at_timestamp);
+    // Plain files seek to the checkpoint, compressed input and pipes read
+    // their way there
+    uint64_t skip_lines = 0;
+    if (checkpoint.has_value() && (opts.input_source == "gzip" || opts.input_source == "zstd" ||
+                                   lseek(STDIN_FILENO, static_cast<off_t>(checkpoint->byte_offset), SEEK_SET) < 0))
+      skip_lines = checkpoint->line_number;
+    return Problem::visit_order_book(
+      opts.order_book, [&]<typename OrderBookImpl>() {
+        return Problem::visit_input_source(
+          opts.input_source, STDIN_FILENO, [&](auto &input) {
+            return query_book<OrderBookImpl>(opts, argv[0], input, checkpoint, skip_lines);
+          });
+      });
+  }
+  apply_run_mode(opts, argv[0]);
+  return Problem::visit_order_book(
+    opts.order_book, [&]<typename OrderBookImpl>() {
+      return Problem::visit_input_source(
+        opts.input_source, STDIN_FILENO, [&](auto &input) {
+          return run_pricer<OrderBookImpl>(opts, argv[0], input);
+        });
+    });
+}
@@ -0,0 +1,160 @@
+#ifndef PRICING_SUBSCRIPTIONS_H
+#define PRICING_SUBSCRIPTIONS_H
+
+#include "order-book/order-book-policy.h"
+#include "order.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace OrderBookProgrammingProblem {
+  // Clients subscribe to the cost of filling a target size on one side, and
+  // are notified only when it moves by more than their threshold (or becomes
+  // available or unavailable) since they were last notified.
+  //
+  // The subscriptions of a side are kept sorted by target size. A change at
+  // price p cannot affect the fills that end before reaching p, i.e., those
+  // whose target size is at most the depth strictly better than p, so
+  // on_change() walks the levels from the best price once, skips that prefix
+  // of the subscriptions and prices the rest in the same walk: O(levels
+  // reached + subscriptions affected) per message.
+  template<typename Cost = int64_t>
+  class PricingSubscriptions {
+  public:
+    using Id = size_t;
+
+  private:
+    struct Subscription {
+      Id id;
+      int target_size;
+      Cost threshold_cent;
+      std::optional<Cost> cost_cent;
+    };
+
+    // Indexed by is_descending_side, i.e., asks then bids
+    std::array<std::vector<Subscription>, 2> subscriptions;
+    Id next_id = 0;
+
+    std::vector<Subscription> &side_of(const Order::Side side) { return subscriptions[side == Order::Side::Bid]; }
+
+    // Only moves of more than the threshold are reported
+    template<typename F>
+    static void update(Subscription &subscription, const Order::Side side, const std::optional<Cost> cost_cent,
+                       F &notify) {
+      const auto &previous = subscription.cost_cent;
+      if (previous.has_value() == cost_cent.has_value() &&
+          (!cost_cent.has_value() || (cost_cent.value() >= previous.value()
+                                        ? cost_cent.value() - previous.value()
+                                        : previous.value() - cost_cent.value()) <= subscription.threshold_cent))
+        return;
+      subscription.cost_cent = cost_cent;
+      notify(subscription.id, side, cost_cent);
+    }
+
+    // Prices the subscriptions of side whose target size is more than the
+    // depth strictly better than from_price_cent, or all of them without it
+    template<typename Book, typename F>
+    void reprice(Book &book, const Order::Side side, const std::optional<int> from_price_cent, F &notify) {
+      auto &subs = side_of(side);
+      if (subs.empty())
+        return;
+      const auto better = [&](const int price_cent) {
+        return side == Order::Side::Bid ? price_cent > from_price_cent.value() : price_cent < from_price_cent.value();
+      };
+      int64_t depth = 0;
+      Cost cost_cent = 0;
+      bool reached = !from_price_cent.has_value();
+      size_t next = 0;
+      const auto first_affected = [&] {
+        return static_cast<size_t>(std::ranges::upper_bound(subs, depth, {}, &Subscription::target_size) -
+                                   subs.begin());
+      };
+      book.for_each_level(side, [&](const auto level_price_cent, const auto level_size) {
+        if (!reached) {
+          if (better(level_price_cent)) {
+            depth += level_size;
+            cost_cent += static_cast<Cost>(level_price_cent) * level_size;
+            return true;
+          }
+          reached = true;
+          next = first_affected();
+        }
+        for (; next < subs.size() && subs[next].target_size <= depth + level_size; ++next)
+          update(subs[next], side, cost_cent + static_cast<Cost>(level_price_cent) * (subs[next].target_size - depth),
+                 notify);
+        depth += level_size;
+        cost_cent += static_cast<Cost>(level_price_cent) * level_size;
+        return next < subs.size();
+      });
+      // The change was beyond the last level, or the book ran out
+      if (!reached)
+        next = first_affected();
+      for (; next < subs.size(); ++next)
+        update(subs[next], side, std::nullopt, notify);
+    }
+
+  public:
+    // Subscribes to the cost of filling target_size from side, i.e., selling
+    // to the bids or buying from the asks, priced at once against book
+    template<typename Book>
+    Id subscribe(Book &book, const Order::Side side, const int target_size, const Cost threshold_cent) {
+      if (target_size <= 0)
+        throw std::invalid_argument("Subscription target size must be positive");
+      if (threshold_cent < 0)
+        throw std::invalid_argument("Subscription threshold must not be negative");
+      auto &subs = side_of(side);
+      const auto cost_cent = side == Order::Side::Bid
+                               ? book.get_pricer_sell_cost_cent(target_size)
+                               : book.get_pricer_buy_cost_cent(target_size);
+      const auto pos = std::ranges::upper_bound(subs, target_size, {}, &Subscription::target_size);
+      subs.insert(pos, Subscription{next_id, target_size, threshold_cent,
+                                    cost_cent.has_value() ? std::optional<Cost>(cost_cent.value()) : std::nullopt});
+      return next_id++;
+    }
+
+    bool unsubscribe(const Id id) {
+      for (auto &subs: subscriptions) {
+        if (const auto it = std::ranges::find(subs, id, &Subscription::id); it != subs.end()) {
+          subs.erase(it);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    [[nodiscard]] size_t size() const { return subscriptions[0].size() + subscriptions[1].size(); }
+
+    // The cost last notified (or priced at subscription time)
+    [[nodiscard]] std::optional<Cost> cost_cent(const Id id) const {
+      for (const auto &subs: subscriptions) {
+        if (const auto it = std::ranges::find(subs, id, &Subscription::id); it != subs.end())
+          return it->cost_cent;
+      }
+      throw std::invalid_argument("Unknown subscription id: " + std::to_string(id));
+    }
+
+    // After change was applied to book, reprices the subscriptions it can
+    // have affected and calls notify(id, side, cost_cent) for those whose
+    // cost moved by more than their threshold
+    template<typename Book, typename F>
+    void on_change(Book &book, const LevelChange &change, F &&notify) {
+      reprice(book, change.side, change.price_cent, notify);
+    }
+
+    // Reprices every subscription, for changes that were not tracked (e.g., a
+    // batch applied at once)
+    template<typename Book, typename F>
+    void on_any_change(Book &book, F &&notify) {
+      reprice(book, Order::Side::Ask, std::nullopt, notify);
+      reprice(book, Order::Side::Bid, std::nullopt, notify);
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // PRICING_SUBSCRIPTIONS_H
@@ -0,0 +1,70 @@
+#ifndef REJECT_REASON_H
+#define REJECT_REASON_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <string_view>
+
+namespace OrderBookProgrammingProblem {
+  // Why a feed record was not applied, returned (rather than thrown) by the
+  // try_* parse and apply functions
+  enum struct RejectReason : uint8_t {
+    // Parsing
+    malformed_line,
+    bad_timestamp,
+    bad_type,
+    bad_side,
+    bad_price,
+    bad_size,
+    // Feed order
+    timestamp_out_of_order,
+    // Applying to the book
+    invalid_id,
+    non_positive_size,
+    price_out_of_range,
+    duplicate_id,
+    unknown_id,
+  };
+
+  inline constexpr size_t reject_reason_count = static_cast<size_t>(RejectReason::unknown_id) + 1;
+
+  inline constexpr std::array<std::string_view, reject_reason_count> reject_reason_names = {
+    "malformed line", "bad timestamp", "bad type", "bad side", "bad price", "bad size",
+    "timestamp out of order", "invalid id", "non-positive size", "price out of range", "duplicate id", "unknown id"
+  };
+
+  constexpr std::string_view to_string(const RejectReason reason) {
+    return reject_reason_names[static_cast<size_t>(reason)];
+  }
+
+  class RejectCounts {
+    std::array<size_t, reject_reason_count> counts{};
+
+  public:
+    void record(const RejectReason reason) { ++counts[static_cast<size_t>(reason)]; }
+
+    [[nodiscard]] size_t count(const RejectReason reason) const { return counts[static_cast<size_t>(reason)]; }
+
+    [[nodiscard]] size_t total() const {
+      size_t sum = 0;
+      for (const auto count: counts)
+        sum += count;
+      return sum;
+    }
+
+    // One "reason: count" pair per reason seen, e.g., "unknown id: 3"
+    [[nodiscard]] std::string to_string() const {
+      std::string out;
+      for (size_t i = 0; i < reject_reason_count; ++i) {
+        if (counts[i] != 0)
+          out += std::format("{}{}: {}", out.empty() ? "" : ", ", reject_reason_names[i], counts[i]);
+      }
+      return out;
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // REJECT_REASON_H
@@ -0,0 +1,302 @@
+#include "feed-generator.h"
+#include "input/input-source-registry.h"
+#include "order-book/order-book-registry.h"
+#include "pricer-output.h"
+#include "utils.h"
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace Problem = OrderBookProgrammingProblem;
+namespace Order = Problem::Order;
+
+// Replays every order book over the fixtures and generated feeds, checks the
+// output against reference files and records throughput, per-message latency
+// percentiles and peak RSS to a CSV, e.g.:
+//   replay-bench --input=pricer.in.gz --reference-dir=assets/test-data
+// Exits with 1 if any output differs from its reference.
+namespace {
+  // Book whose output serves as the reference when there is no reference file
+  constexpr std::string_view reference_book = "std-map";
+
+  struct BenchOptions {
+    // Feeds in the format of pricer.in, may be compressed (see
+    // input_source_for_path())
+    std::vector<std::string> inputs;
+    // Where pricer.out.<target_size>[.gz] are looked up, the directory of
+    // each input by default
+    std::string reference_dir;
+    // Messages of the generated feed, 0 to skip it
+    size_t generated_messages = 200'000;
+    uint64_t seed = 9527;
+    // Price spread of a second generated feed whose adds all land within a
+    // few cents of the mid, i.e., a top-of-book-heavy workload, 0 to skip it
+    int top_of_book_spread = 3;
+    std::vector<int> target_sizes = {1, 200, 10000};
+    std::vector<std::string> books{Problem::order_book_names.begin(), Problem::order_book_names.end()};
+    std::string csv_path = "replay-bench.csv";
+  };
+
+  std::vector<std::string> split_list(const std::string_view list) {
+    std::vector<std::string> items;
+    for (const auto item: list | std::views::split(','))
+      items.emplace_back(item.begin(), item.end());
+    return items;
+  }
+
+  BenchOptions parse_bench_options(const int argc, char *argv[]) {
+    BenchOptions opts;
+    const auto value_of = [](const std::string_view arg) { return arg.substr(arg.find('=') + 1); };
+    for (int i = 1; i < argc; ++i) {
+      const std::string_view arg = argv[i];
+      if (arg.starts_with("--input="))
+        opts.inputs.emplace_back(value_of(arg));
+      else if (arg.starts_with("--reference-dir="))
+        opts.reference_dir = value_of(arg);
+      else if (arg.starts_with("--generated="))
+        opts.generated_messages = std::stoul(std::string(value_of(arg)));
+      else if (arg.starts_with("--seed="))
+        opts.seed = std::stoull(std::string(value_of(arg)));
+      else if (arg.starts_with("--top-of-book-spread="))
+        opts.top_of_book_spread = std::stoi(std::string(value_of(arg)));
+      else if (arg.starts_with("--target-sizes=")) {
+        opts.target_sizes.clear();
+        for (const auto &size: split_list(value_of(arg)))
+          opts.target_sizes.push_back(std::stoi(size));
+      } else if (arg.starts_with("--books="))
+        opts.books = split_list(value_of(arg));
+      else if (arg.starts_with("--csv="))
+        opts.csv_path = value_of(arg);
+      else
+        throw std::invalid_argument("Unknown argument: " + std::string(arg));
+    }
+    return opts;
+  }
+
+  std::vector<std::string> read_lines(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), "open(" + path + ")");
+    auto lines = Problem::visit_input_source(
+      Problem::input_source_for_path(path), fd, [](auto &source) {
+        std::vector<std::string> result;
+        while (const auto line = source.next_line())
+          result.emplace_back(line.value());
+        return result;
+      });
+    close(fd);
+    return lines;
+  }
+
+  struct Dataset {
+    std::string name;
+    std::vector<Order::LimitOrder> feed;
+    // Expected output per target size and where it comes from
+    std::map<int, std::vector<std::string> > expected;
+    std::map<int, std::string> reference;
+  };
+
+  // Sent from the child process running one replay back to the parent
+  struct RunResult {
+    uint64_t messages = 0;
+    double seconds = 0;
+    uint64_t p50_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+    uint64_t output_lines = 0;
+    uint64_t mismatched_lines = 0;
+    bool failed = false;
+  };
+
+  // Applies the feed and prices both sides after every message like pricer
+  // does, latencies[i] is the time taken by message i
+  template<typename OrderBookImpl>
+  std::vector<std::string> replay(const std::vector<Order::LimitOrder> &feed, const int target_size,
+                                  std::vector<uint32_t> *latencies) {
+    OrderBookImpl order_book;
+    using Cost = typename decltype(order_book.get_pricer_sell_cost_cent(target_size))::value_type;
+    std::optional<Cost> sell_cost_cent;
+    std::optional<Cost> buy_cost_cent;
+    std::vector<std::string> output;
+    for (const auto &lo: feed) {
+      const auto start = std::chrono::steady_clock::now();
+      order_book.add_order(lo);
+      const auto new_sell_cost_cent = order_book.get_pricer_sell_cost_cent(target_size);
+      const auto new_buy_cost_cent = order_book.get_pricer_buy_cost_cent(target_size);
+      const auto end = std::chrono::steady_clock::now();
+      if (latencies != nullptr)
+        latencies->push_back(static_cast<uint32_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+      if (Problem::update_previous_cost_cent(new_sell_cost_cent, sell_cost_cent))
+        output.push_back(Problem::format_cost_line(lo.timestamp, new_sell_cost_cent, true));
+      if (Problem::update_previous_cost_cent(new_buy_cost_cent, buy_cost_cent))
+        output.push_back(Problem::format_cost_line(lo.timestamp, new_buy_cost_cent, false));
+    }
+    return output;
+  }
+
+  uint64_t count_mismatches(const std::vector<std::string> &actual, const std::vector<std::string> &expected) {
+    uint64_t mismatches = std::max(actual.size(), expected.size()) - std::min(actual.size(), expected.size());
+    for (size_t i = 0; i < std::min(actual.size(), expected.size()); ++i)
+      mismatches += actual[i] != expected[i];
+    return mismatches;
+  }
+
+  template<typename OrderBookImpl>
+  RunResult run_in_child(const Dataset &dataset, const int target_size) {
+    RunResult result;
+    std::vector<uint32_t> latencies;
+    latencies.reserve(dataset.feed.size());
+    const auto start = std::chrono::steady_clock::now();
+    const auto output = replay<OrderBookImpl>(dataset.feed, target_size, &latencies);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.messages = dataset.feed.size();
+    result.output_lines = output.size();
+    result.mismatched_lines = count_mismatches(output, dataset.expected.at(target_size));
+    const auto percentile = [&](const double p) -> uint64_t {
+      if (latencies.empty())
+        return 0;
+      const auto nth = latencies.begin() + static_cast<ptrdiff_t>(p * static_cast<double>(latencies.size() - 1));
+      std::ranges::nth_element(latencies, nth);
+      return *nth;
+    };
+    result.p50_ns = percentile(0.5);
+    result.p99_ns = percentile(0.99);
+    result.p999_ns = percentile(0.999);
+    return result;
+  }
+
+  // Runs the replay in a forked child so that its peak RSS (in KiB) is not
+  // polluted by earlier runs
+  std::pair<RunResult, long> run_isolated(const std::string_view book, const Dataset &dataset,
+                                          const int target_size) {
+    int fds[2];
+    if (pipe(fds) != 0)
+      throw std::system_error(errno, std::generic_category(), "pipe()");
+    const pid_t pid = fork();
+    if (pid < 0)
+      throw std::system_error(errno, std::generic_category(), "fork()");
+    if (pid == 0) {
+      close(fds[0]);
+      RunResult result;
+      try {
+        result = Problem::visit_order_book(book, [&]<typename OrderBookImpl>() {
+          return run_in_child<OrderBookImpl>(dataset, target_size);
+        });
+      } catch (const std::exception &e) {
+        std::cerr << book << " failed on " << dataset.name << ": " << e.what() << std::endl;
+        result.failed = true;
+      }
+      const auto written = write(fds[1], &result, sizeof(result));
+      _exit(written == sizeof(result) ? 0 : 1);
+    }
+    close(fds[1]);
+    RunResult result;
+    const auto n = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    int status = 0;
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+    if (n != sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      result.failed = true;
+    return {result, usage.ru_maxrss};
+  }
+
+  Dataset load_fixture(const std::string &path, const BenchOptions &opts) {
+    Dataset dataset;
+    dataset.name = std::filesystem::path(path).filename().string();
+    Problem::Utils utils;
+    for (const auto &line: read_lines(path))
+      dataset.feed.push_back(utils.parse_limit_order(line));
+    const auto reference_dir = opts.reference_dir.empty()
+                                 ? std::filesystem::path(path).parent_path()
+                                 : std::filesystem::path(opts.reference_dir);
+    for (const auto target_size: opts.target_sizes) {
+      for (const auto *suffix: {"", ".gz", ".zst"}) {
+        const auto reference = reference_dir / ("pricer.out." + std::to_string(target_size) + suffix);
+        if (std::filesystem::exists(reference)) {
+          dataset.expected[target_size] = read_lines(reference.string());
+          dataset.reference[target_size] = reference.string();
+          break;
+        }
+      }
+    }
+    return dataset;
+  }
+
+  // Fills in the expected output of target sizes without a reference file
+  void add_book_references(Dataset &dataset, const BenchOptions &opts) {
+    for (const auto target_size: opts.target_sizes) {
+      if (dataset.expected.contains(target_size))
+        continue;
+      dataset.expected[target_size] = Problem::visit_order_book(
+        reference_book, [&]<typename OrderBookImpl>() {
+          return replay<OrderBookImpl>(dataset.feed, target_size, nullptr);
+        });
+      dataset.reference[target_size] = reference_book;
+    }
+  }
+} // namespace
+
+int main(const int argc, char *argv[]) {
+  const auto opts = parse_bench_options(argc, argv);
+  std::vector<Dataset> datasets;
+  for (const auto &input: opts.inputs)
+    datasets.push_back(load_fixture(input, opts));
+  if (opts.generated_messages > 0)
+    datasets.push_back({
+      .name = std::format("generated-{}-{}", opts.generated_messages, opts.seed),
+      .feed = Problem::generate_synthetic_feed(opts.generated_messages, opts.seed),
+    });
+  if (opts.generated_messages > 0 && opts.top_of_book_spread > 0)
+    datasets.push_back({
+      .name = std::format("top-of-book-{}-{}", opts.generated_messages, opts.seed),
+      .feed = Problem::generate_synthetic_feed(opts.generated_messages, opts.seed, 2'000,
+                                               opts.top_of_book_spread),
+    });
+  for (auto &dataset: datasets)
+    add_book_references(dataset, opts);
+
+  std::ofstream csv(opts.csv_path);
+  csv << "book,dataset,target_size,messages,seconds,messages_per_sec,p50_ns,p99_ns,p999_ns,"
+      "peak_rss_kib,output_lines,reference,mismatched_lines,failed\n";
+  std::cout << std::format("{:<13} {:<28} {:>6} {:>12} {:>8} {:>8} {:>8} {:>10} {:>10}\n", "book",
+                           "dataset", "target", "msgs/s", "p50 ns", "p99 ns", "p999 ns", "rss KiB",
+                           "mismatch");
+  bool all_match = true;
+  for (const auto &dataset: datasets) {
+    for (const auto target_size: opts.target_sizes) {
+      for (const auto &book: opts.books) {
+        const auto [result, peak_rss_kib] = run_isolated(book, dataset, target_size);
+        const auto messages_per_sec = result.seconds > 0 ? result.messages / result.seconds : 0;
+        all_match = all_match && !result.failed && result.mismatched_lines == 0;
+        csv << std::format("{},{},{},{},{:.6f},{:.0f},{},{},{},{},{},{},{},{}\n", book, dataset.name,
+                           target_size, result.messages, result.seconds, messages_per_sec, result.p50_ns,
+                           result.p99_ns, result.p999_ns, peak_rss_kib, result.output_lines,
+                           dataset.reference.at(target_size), result.mismatched_lines, result.failed);
+        std::cout << std::format("{:<13} {:<28} {:>6} {:>12.0f} {:>8} {:>8} {:>8} {:>10} {:>10}\n", book,
+                                 dataset.name, target_size, messages_per_sec, result.p50_ns, result.p99_ns,
+                                 result.p999_ns, peak_rss_kib,
+                                 result.failed ? std::string("FAILED") : std::to_string(result.mismatched_lines));
+      }
+    }
+  }
+  std::cout << (all_match ? "All outputs match their references" : "Some outputs differ from their references")
+      << ", results written to " << opts.csv_path << std::endl;
+  return all_match ? 0 : 1;
+}
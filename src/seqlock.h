@@ -0,0 +1,45 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include "aligned-allocator.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace OrderBookProgrammingProblem {
+  // Sequence lock for a single writer and any number of readers. The writer
+  // never waits, readers retry if the writer was active while they read. Data
+  // protected by it must be accessed with (relaxed) atomic loads and stores,
+  // following "Can Seqlocks Get Along With Programming Language Memory
+  // Models?" by Hans Boehm
+  class SeqLock {
+    alignas(cache_line_size) std::atomic<uint64_t> sequence{0};
+
+  public:
+    void write_begin() noexcept {
+      sequence.store(sequence.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void write_end() noexcept {
+      sequence.store(sequence.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_release);
+    }
+
+    [[nodiscard]] uint64_t read_begin() const noexcept {
+      uint64_t seq;
+      while ((seq = sequence.load(std::memory_order_acquire)) & 1) {
+      }
+      return seq;
+    }
+
+    // True if the data read since read_begin() returned seq may be torn
+    [[nodiscard]] bool read_retry(const uint64_t seq) const noexcept {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return sequence.load(std::memory_order_relaxed) != seq;
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // SEQLOCK_H
@@ -0,0 +1,48 @@
+#include "shm/shm-book-reader.h"
+
+#include <format>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace Shm = OrderBookProgrammingProblem::Shm;
+
+// Prints every snapshot published by `pricer --shm=<name>` that it gets to
+// see, i.e., snapshots published while the previous one was printed are
+// skipped. Exits once the publisher is gone.
+int main(const int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <shm-name> [depth]" << std::endl;
+    return 1;
+  }
+  const size_t depth = argc > 2 ? std::stoul(argv[2]) : 1;
+  const Shm::BookReader reader(argv[1]);
+  const auto format_cost = [](const std::optional<int64_t> cost_cent) {
+    return cost_cent.has_value() ? std::format("{:.2f}", cost_cent.value() / 100.0) : std::string("NA");
+  };
+  const auto format_levels = [&](const auto &levels, const uint64_t count) {
+    std::string line;
+    for (size_t i = 0; i < std::min<uint64_t>(count, depth); ++i)
+      line += std::format(" {}@{:.2f}", levels[i].size, levels[i].price_cent / 100.0);
+    return line;
+  };
+
+  uint64_t seen = 0;
+  while (true) {
+    const bool closed = reader.closed();
+    const auto count = reader.publish_count();
+    if (count != seen) {
+      seen = count;
+      if (const auto snapshot = reader.read(); snapshot.has_value())
+        std::cout << snapshot->timestamp << " S " << format_cost(snapshot->sell_cost())
+            << " B " << format_cost(snapshot->buy_cost())
+            << " |" << format_levels(snapshot->bids, snapshot->bid_count)
+            << " |" << format_levels(snapshot->asks, snapshot->ask_count) << "\n";
+    } else if (closed) {
+      break;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  return 0;
+}
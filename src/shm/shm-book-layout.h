@@ -0,0 +1,97 @@
+#ifndef SHM_BOOK_LAYOUT_H
+#define SHM_BOOK_LAYOUT_H
+
+#include "../aligned-allocator.h"
+#include "../seqlock.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+
+// Layout of the POSIX shared memory region pricer publishes the book into
+// (pricer --shm=<name>). One process writes, any number of processes map the
+// region read-only and copy snapshots out of it without locks or syscalls.
+namespace OrderBookProgrammingProblem::Shm {
+  // "OBPPBOOK", written last so readers never see a half initialised region
+  inline constexpr uint64_t layout_magic = 0x4b4f4f4250504f42;
+  // Bump on any change of the structs below
+  inline constexpr uint64_t layout_version = 1;
+  inline constexpr size_t max_depth = 16;
+  inline constexpr size_t slot_count = 2;
+
+  struct Level {
+    int64_t price_cent = 0;
+    int64_t size = 0;
+  };
+
+  // Every field is 8 bytes wide so that a snapshot can be copied word by word
+  // with atomic loads and stores, see copy_words()
+  struct BookSnapshot {
+    uint64_t timestamp = 0;
+    int64_t target_size = 0;
+    // Pricer's cost of target_size, only valid if has_*_cost is set
+    int64_t sell_cost_cent = 0;
+    int64_t buy_cost_cent = 0;
+    uint64_t has_sell_cost = 0;
+    uint64_t has_buy_cost = 0;
+    // Top levels of each side from the best price outwards
+    uint64_t bid_count = 0;
+    uint64_t ask_count = 0;
+    std::array<Level, max_depth> bids{};
+    std::array<Level, max_depth> asks{};
+
+    [[nodiscard]] std::optional<Level> best_bid() const {
+      return bid_count == 0 ? std::nullopt : std::optional(bids[0]);
+    }
+
+    [[nodiscard]] std::optional<Level> best_ask() const {
+      return ask_count == 0 ? std::nullopt : std::optional(asks[0]);
+    }
+
+    [[nodiscard]] std::optional<int64_t> sell_cost() const {
+      return has_sell_cost ? std::optional(sell_cost_cent) : std::nullopt;
+    }
+
+    [[nodiscard]] std::optional<int64_t> buy_cost() const {
+      return has_buy_cost ? std::optional(buy_cost_cent) : std::nullopt;
+    }
+  };
+
+  static_assert(std::is_trivially_copyable_v<BookSnapshot> && sizeof(BookSnapshot) % sizeof(uint64_t) == 0);
+
+  struct Slot {
+    SeqLock lock;
+    alignas(cache_line_size) BookSnapshot snapshot;
+  };
+
+  // The writer alternates between the slots, so a reader copying the latest
+  // snapshot only retries if the writer has published slot_count times since
+  struct Region {
+    std::atomic<uint64_t> magic;
+    uint64_t version;
+    // Set when the publisher goes away, the last snapshot stays readable
+    std::atomic<uint64_t> closed;
+    // Number of snapshots published so far, the latest one is in
+    // slots[(publish_count - 1) % slot_count]
+    alignas(cache_line_size) std::atomic<uint64_t> publish_count;
+    std::array<Slot, slot_count> slots;
+  };
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "Atomics in shared memory must not rely on process local locks");
+
+  // Both pointers must be 8 byte aligned, sizeof(BookSnapshot) / 8 words are
+  // copied with relaxed atomic accesses, ordering is left to the SeqLock
+  inline void copy_words(BookSnapshot &dst, const BookSnapshot &src) {
+    constexpr size_t words = sizeof(BookSnapshot) / sizeof(uint64_t);
+    auto *d = reinterpret_cast<uint64_t *>(&dst);
+    auto *s = reinterpret_cast<uint64_t *>(const_cast<BookSnapshot *>(&src));
+    for (size_t i = 0; i < words; ++i)
+      std::atomic_ref<uint64_t>(d[i]).store(std::atomic_ref<uint64_t>(s[i]).load(std::memory_order_relaxed),
+                                            std::memory_order_relaxed);
+  }
+} // namespace OrderBookProgrammingProblem::Shm
+
+#endif // SHM_BOOK_LAYOUT_H
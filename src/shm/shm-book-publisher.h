@@ -0,0 +1,92 @@
+#ifndef SHM_BOOK_PUBLISHER_H
+#define SHM_BOOK_PUBLISHER_H
+
+#include "../order.h"
+#include "shm-book-layout.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <new>
+#include <optional>
+#include <string>
+#include <system_error>
+
+namespace OrderBookProgrammingProblem::Shm {
+  // Creates (or takes over) the shared memory object name, e.g. "/pricer",
+  // and publishes book snapshots into it. Must only be used from one thread.
+  class BookPublisher {
+    std::string shm_name;
+    Region *region = nullptr;
+    BookSnapshot staging;
+
+  public:
+    explicit BookPublisher(std::string name) : shm_name(std::move(name)) {
+      const int fd = shm_open(shm_name.c_str(), O_CREAT | O_RDWR, 0644);
+      if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "shm_open(" + shm_name + ")");
+      if (ftruncate(fd, sizeof(Region)) != 0) {
+        const int err = errno;
+        close(fd);
+        throw std::system_error(err, std::generic_category(), "ftruncate(" + shm_name + ")");
+      }
+      void *addr = mmap(nullptr, sizeof(Region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      if (addr == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "mmap(" + shm_name + ")");
+      region = new(addr) Region{};
+      region->version = layout_version;
+      region->magic.store(layout_magic, std::memory_order_release);
+    }
+
+    BookPublisher(const BookPublisher &) = delete;
+
+    BookPublisher &operator=(const BookPublisher &) = delete;
+
+    // Readers that already mapped the region keep the last snapshot
+    ~BookPublisher() {
+      region->closed.store(1, std::memory_order_release);
+      munmap(region, sizeof(Region));
+      shm_unlink(shm_name.c_str());
+    }
+
+    template<typename OrderBookImpl, typename Cost>
+    void publish(const uint64_t timestamp, OrderBookImpl &order_book, const int target_size,
+                 const std::optional<Cost> sell_cost_cent, const std::optional<Cost> buy_cost_cent) {
+      staging.timestamp = timestamp;
+      staging.target_size = target_size;
+      staging.has_sell_cost = sell_cost_cent.has_value();
+      staging.sell_cost_cent = sell_cost_cent.value_or(0);
+      staging.has_buy_cost = buy_cost_cent.has_value();
+      staging.buy_cost_cent = buy_cost_cent.value_or(0);
+      staging.bid_count = collect_levels(order_book, Order::Side::Bid, staging.bids);
+      staging.ask_count = collect_levels(order_book, Order::Side::Ask, staging.asks);
+      publish(staging);
+    }
+
+    void publish(const BookSnapshot &snapshot) {
+      const auto count = region->publish_count.load(std::memory_order_relaxed);
+      auto &slot = region->slots[count % slot_count];
+      slot.lock.write_begin();
+      copy_words(slot.snapshot, snapshot);
+      slot.lock.write_end();
+      region->publish_count.store(count + 1, std::memory_order_release);
+    }
+
+  private:
+    template<typename OrderBookImpl>
+    static uint64_t collect_levels(OrderBookImpl &order_book, const Order::Side side,
+                                   std::array<Level, max_depth> &levels) {
+      uint64_t count = 0;
+      order_book.for_each_level(side, [&](const auto price_cent, const auto size) {
+        levels[count++] = {static_cast<int64_t>(price_cent), static_cast<int64_t>(size)};
+        return count < max_depth;
+      });
+      return count;
+    }
+  };
+} // namespace OrderBookProgrammingProblem::Shm
+
+#endif // SHM_BOOK_PUBLISHER_H
@@ -0,0 +1,70 @@
+#ifndef SHM_BOOK_READER_H
+#define SHM_BOOK_READER_H
+
+#include "shm-book-layout.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+namespace OrderBookProgrammingProblem::Shm {
+  // Maps a region created by BookPublisher read-only. Readers never write to
+  // the region, so any number of them (in any number of processes) can read
+  // without slowing the publisher down.
+  class BookReader {
+    const Region *region = nullptr;
+
+  public:
+    explicit BookReader(const std::string &name) {
+      const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+      if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "shm_open(" + name + ")");
+      void *addr = mmap(nullptr, sizeof(Region), PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+      if (addr == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "mmap(" + name + ")");
+      region = static_cast<const Region *>(addr);
+      if (region->magic.load(std::memory_order_acquire) != layout_magic ||
+          region->version != layout_version) {
+        munmap(addr, sizeof(Region));
+        throw std::runtime_error("Unexpected shared memory layout in " + name);
+      }
+    }
+
+    BookReader(const BookReader &) = delete;
+
+    BookReader &operator=(const BookReader &) = delete;
+
+    ~BookReader() { munmap(const_cast<Region *>(region), sizeof(Region)); }
+
+    // Changes whenever a new snapshot is published, cheap enough to poll
+    [[nodiscard]] uint64_t publish_count() const {
+      return region->publish_count.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] bool closed() const { return region->closed.load(std::memory_order_acquire) != 0; }
+
+    // Latest snapshot, or std::nullopt if nothing was published yet
+    [[nodiscard]] std::optional<BookSnapshot> read() const {
+      BookSnapshot snapshot;
+      while (true) {
+        const auto count = publish_count();
+        if (count == 0)
+          return std::nullopt;
+        const auto &slot = region->slots[(count - 1) % slot_count];
+        const auto seq = slot.lock.read_begin();
+        copy_words(snapshot, slot.snapshot);
+        if (!slot.lock.read_retry(seq))
+          return snapshot;
+      }
+    }
+  };
+} // namespace OrderBookProgrammingProblem::Shm
+
+#endif // SHM_BOOK_READER_H
@@ -0,0 +1,210 @@
+#ifndef SKIP_LIST_IMPL_H
+#define SKIP_LIST_IMPL_H
+
+#include "epoch-reclaimer.h"
+#include "seqlock.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace OrderBookProgrammingProblem {
+  // Skip list of unique keys, each node carrying a Value, for one writer and
+  // (with Concurrent = true) any number of reader threads.
+  //
+  // Nodes are linked bottom-up with one release store per level, so a reader
+  // that reaches a node through any level sees it fully built, and readers
+  // never block the writer. Erasing first marks the node deleted (readers
+  // skip it from then on), then unlinks it top-down and retires it through an
+  // EpochReclaimer, as a reader may still be standing on it. The writer
+  // brackets each logical update in a WriteSection and read() reruns the
+  // reader's walk until it saw no update in between, so that a walk over
+  // several nodes sees a state the writer actually produced. With
+  // Concurrent = false all of that compiles away.
+  template<typename Key, typename Value, typename Compare = std::less<>, bool Concurrent = false>
+  class SkipList {
+  public:
+    // A node reaches level i + 1 with probability 1/4, so 12 levels are
+    // plenty for the 16M nodes beyond which search degrades
+    static constexpr unsigned max_height = 12;
+
+    class Node {
+      friend class SkipList;
+      const Key node_key;
+      const unsigned height;
+      std::atomic<bool> deleted{false};
+      std::array<std::atomic<Node *>, max_height> links{};
+
+    public:
+      Value value{};
+
+      Node(const Key &key, const unsigned h) : node_key(key), height(h) {
+      }
+
+      [[nodiscard]] const Key &key() const { return node_key; }
+
+      [[nodiscard]] Node *next() const { return links[0].load(std::memory_order_acquire); }
+
+      [[nodiscard]] bool is_deleted() const { return deleted.load(std::memory_order_acquire); }
+    };
+
+  private:
+    using Links = std::array<std::atomic<Node *>, max_height>;
+
+    Links head{};
+    // Writer only
+    unsigned height = 1;
+    size_t count = 0;
+    uint64_t rng_state = 0x9e3779b97f4a7c15;
+    [[no_unique_address]] Compare compare;
+    SeqLock seqlock;
+    EpochReclaimer reclaimer;
+
+    unsigned random_height() {
+      // xorshift64, two bits per level
+      rng_state ^= rng_state << 13;
+      rng_state ^= rng_state >> 7;
+      rng_state ^= rng_state << 17;
+      unsigned h = 1;
+      for (auto bits = rng_state; h < max_height && (bits & 3) == 0; bits >>= 2)
+        ++h;
+      return h;
+    }
+
+    // preds[i] is the link at level i that points to the first node not
+    // ordered before key
+    void find_preds(const Key &key, std::array<std::atomic<Node *> *, max_height> &preds) {
+      Links *links = &head;
+      for (auto level = static_cast<int>(height) - 1; level >= 0; --level) {
+        while (true) {
+          Node *node = (*links)[level].load(std::memory_order_relaxed);
+          if (node == nullptr || !compare(node->node_key, key))
+            break;
+          links = &node->links;
+        }
+        preds[level] = &(*links)[level];
+      }
+    }
+
+  public:
+    // RAII write section, the writer must hold one while mutating the list or
+    // the values readers look at
+    class WriteSection {
+      SkipList &list;
+
+    public:
+      explicit WriteSection(SkipList &l) : list(l) {
+        if constexpr (Concurrent)
+          list.seqlock.write_begin();
+      }
+
+      WriteSection(const WriteSection &) = delete;
+
+      WriteSection &operator=(const WriteSection &) = delete;
+
+      ~WriteSection() {
+        if constexpr (Concurrent)
+          list.seqlock.write_end();
+      }
+    };
+
+    SkipList() = default;
+
+    SkipList(const SkipList &) = delete;
+
+    SkipList &operator=(const SkipList &) = delete;
+
+    ~SkipList() {
+      for (Node *node = head[0].load(std::memory_order_relaxed); node != nullptr;) {
+        Node *next = node->links[0].load(std::memory_order_relaxed);
+        delete node;
+        node = next;
+      }
+    }
+
+    // Writer side
+    [[nodiscard]] size_t size() const { return count; }
+
+    [[nodiscard]] Node *find(const Key &key) {
+      std::array<std::atomic<Node *> *, max_height> preds;
+      find_preds(key, preds);
+      Node *node = preds[0]->load(std::memory_order_relaxed);
+      return node != nullptr && !compare(key, node->node_key) ? node : nullptr;
+    }
+
+    // key must not be in the list yet, the value of the returned node is
+    // default constructed
+    Node *insert(const Key &key) {
+      std::array<std::atomic<Node *> *, max_height> preds;
+      find_preds(key, preds);
+      const auto node_height = random_height();
+      for (; height < node_height; ++height)
+        preds[height] = &head[height];
+      auto *node = new Node(key, node_height);
+      for (unsigned level = 0; level < node_height; ++level)
+        node->links[level].store(preds[level]->load(std::memory_order_relaxed), std::memory_order_relaxed);
+      for (unsigned level = 0; level < node_height; ++level)
+        preds[level]->store(node, std::memory_order_release);
+      ++count;
+      return node;
+    }
+
+    void erase(Node *node) {
+      node->deleted.store(true, std::memory_order_release);
+      std::array<std::atomic<Node *> *, max_height> preds;
+      find_preds(node->node_key, preds);
+      for (auto level = static_cast<int>(node->height) - 1; level >= 0; --level)
+        preds[level]->store(node->links[level].load(std::memory_order_relaxed), std::memory_order_release);
+      while (height > 1 && head[height - 1].load(std::memory_order_relaxed) == nullptr)
+        --height;
+      --count;
+      if constexpr (Concurrent)
+        reclaimer.retire([node] { delete node; });
+      else
+        delete node;
+    }
+
+    // Writer and (inside read()) reader side, walk with Node::next() and skip
+    // the nodes for which is_deleted() is true
+    [[nodiscard]] Node *first() const { return head[0].load(std::memory_order_acquire); }
+
+    template<typename T>
+    static void store(T &dst, const T val) {
+      if constexpr (Concurrent)
+        std::atomic_ref<T>(dst).store(val, std::memory_order_relaxed);
+      else
+        dst = val;
+    }
+
+    template<typename T>
+    static T load(const T &src) {
+      if constexpr (Concurrent)
+        return std::atomic_ref<T>(const_cast<T &>(src)).load(std::memory_order_relaxed);
+      else
+        return src;
+    }
+
+    // Reader side, may be called from any thread that registered a slot. f()
+    // must only read node values through load() and is rerun until it saw a
+    // consistent version
+    size_t register_reader() requires Concurrent { return reclaimer.register_reader(); }
+
+    void unregister_reader(const size_t reader) requires Concurrent { reclaimer.unregister_reader(reader); }
+
+    template<typename F>
+    auto read(const size_t reader, F &&f) requires Concurrent {
+      EpochReclaimer::Guard guard(reclaimer, reader);
+      while (true) {
+        const auto seq = seqlock.read_begin();
+        auto result = f();
+        if (!seqlock.read_retry(seq))
+          return result;
+      }
+    }
+
+    [[nodiscard]] size_t retired_node_count() const { return reclaimer.retired_count(); }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // SKIP_LIST_IMPL_H
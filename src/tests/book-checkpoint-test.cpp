@@ -0,0 +1,140 @@
+#include "../feed-generator.h"
+#include "../input/input-source.h"
+#include "../journal/book-checkpoint.h"
+#include "../order-book/order-book-registry.h"
+#include "test-utils.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Problem = OrderBookProgrammingProblem;
+namespace Order = Problem::Order;
+namespace Journal = Problem::Journal;
+using Problem::Testing::TempDir;
+using Problem::Testing::feed_text;
+using Problem::Testing::levels;
+
+namespace {
+  template<typename Book>
+  auto both_sides(Book &book) { return std::pair(levels(book, Order::Side::Ask), levels(book, Order::Side::Bid)); }
+} // namespace
+
+TEST(BookCheckpointTest, CheckpointShouldRestoreEveryBook) {
+  const TempDir dir("restore");
+  const auto feed = Problem::generate_synthetic_feed(20'000, 13, 500, 20);
+  const auto half = feed.begin() + static_cast<std::ptrdiff_t>(feed.size() / 2);
+  Problem::OrderBookStdMap<> original;
+  for (auto it = feed.begin(); it != half; ++it)
+    ASSERT_TRUE(original.try_add_order(*it).has_value());
+  const auto path = (dir.path / "checkpoint").string();
+  Journal::write_checkpoint(original, path);
+  for (auto it = half; it != feed.end(); ++it)
+    ASSERT_TRUE(original.try_add_order(*it).has_value());
+
+  for (const auto name: Problem::order_book_names) {
+    Problem::visit_order_book(name, [&]<typename OrderBookImpl>() {
+      OrderBookImpl restored;
+      EXPECT_GT(Journal::load_checkpoint(restored, path), 0) << name;
+      // Later reduces find their orders by id
+      for (auto it = half; it != feed.end(); ++it)
+        EXPECT_TRUE(restored.try_add_order(*it).has_value()) << name << " " << *it;
+      EXPECT_EQ(both_sides(restored), both_sides(original)) << name;
+    });
+  }
+}
+
+TEST(BookCheckpointTest, QueriesFromCheckpointsShouldMatchFullReplay) {
+  const TempDir dir("query");
+  const auto text = feed_text(30'000, 17);
+  const auto index_path = (dir.path / "feed.idx").string();
+  {
+    std::istringstream in(text);
+    Problem::StreamInputSource input(in);
+    Problem::OrderBookStdMap<> book;
+    Journal::CheckpointIndex index(index_path);
+    EXPECT_EQ(Journal::build_checkpoint_index(book, input, index, 2'000), 30'000);
+  }
+  const Journal::CheckpointIndex index(index_path);
+  ASSERT_GE(index.entries().size(), 10);
+  const uint64_t last_timestamp = std::stoull(text.substr(text.rfind('\n', text.size() - 2) + 1));
+  EXPECT_FALSE(index.latest_at(index.entries().front().timestamp - 1).has_value());
+
+  for (const auto at: {uint64_t{0}, index.entries().front().timestamp, index.entries()[3].timestamp + 1,
+                       index.entries().back().timestamp, last_timestamp / 2, last_timestamp}) {
+    std::istringstream full_in(text);
+    Problem::StreamInputSource full_input(full_in);
+    Problem::OrderBookStdMap<> expected;
+    Journal::replay_until(expected, full_input, 0, at);
+
+    const auto checkpoint = index.latest_at(at);
+    ASSERT_TRUE(at < index.entries().front().timestamp || checkpoint.has_value()) << at;
+    const auto from = checkpoint.has_value() ? checkpoint->timestamp : 0;
+    // Seeking to the byte offset
+    std::istringstream seek_in(text.substr(checkpoint.has_value() ? checkpoint->byte_offset : 0));
+    Problem::StreamInputSource seek_input(seek_in);
+    Problem::OrderBookArray<> from_offset;
+    if (checkpoint.has_value())
+      Journal::load_checkpoint(from_offset, checkpoint->path);
+    Journal::replay_until(from_offset, seek_input, from, at);
+    EXPECT_EQ(both_sides(from_offset), both_sides(expected)) << at;
+
+    // Skipping the lines before it
+    std::istringstream skip_in(text);
+    Problem::StreamInputSource skip_input(skip_in);
+    Problem::OrderBookVeb<> from_line;
+    if (checkpoint.has_value()) {
+      Journal::load_checkpoint(from_line, checkpoint->path);
+      for (uint64_t i = 0; i < checkpoint->line_number; ++i)
+        ASSERT_TRUE(skip_input.next_line().has_value());
+    }
+    Journal::replay_until(from_line, skip_input, from, at);
+    EXPECT_EQ(both_sides(from_line), both_sides(expected)) << at;
+  }
+}
+
+TEST(BookCheckpointTest, LoadingShouldLeaveTheCheckpointUntouched) {
+  const TempDir dir("load");
+  Problem::OrderBookStdMap<> original;
+  for (const auto &lo: Problem::generate_synthetic_feed(1'000, 23, 100, 10))
+    ASSERT_TRUE(original.try_add_order(lo).has_value());
+  const auto path = (dir.path / "checkpoint").string();
+  Journal::write_checkpoint(original, path);
+  // Cut down to its records, which a writable open would grow back
+  size_t used = 0;
+  {
+    const Journal::EventJournal checkpoint(path, Journal::read_only);
+    used = checkpoint.bytes_used();
+  }
+  std::filesystem::resize_file(path, used);
+  const auto modified = std::filesystem::last_write_time(path);
+
+  Problem::OrderBookArray<> restored;
+  EXPECT_GT(Journal::load_checkpoint(restored, path), 0);
+  EXPECT_EQ(both_sides(restored), both_sides(original));
+  EXPECT_EQ(std::filesystem::file_size(path), used);
+  EXPECT_EQ(std::filesystem::last_write_time(path), modified);
+  EXPECT_THROW(Journal::load_checkpoint(restored, (dir.path / "missing").string()), std::system_error);
+}
+
+TEST(BookCheckpointTest, ReplaceAtTheSamePriceShouldKeepTheOrderTimestamp) {
+  const TempDir dir("replace");
+  Problem::Utils utils;
+  Problem::OrderBookStdMap<> book;
+  for (const auto *line: {"1 A z S 44.26 100", "2 A a S 44.26 100", "3 U z 44.26 50", "4 U a 44.30 70"})
+    ASSERT_TRUE(book.try_add_order(utils.parse_limit_order(line)).has_value());
+  const auto path = (dir.path / "checkpoint").string();
+  Journal::write_checkpoint(book, path);
+
+  std::vector<std::pair<std::string, uint64_t> > orders;
+  const Journal::EventJournal checkpoint(path, Journal::read_only);
+  checkpoint.replay([&](uint64_t, const Order::LimitOrder &lo) { orders.emplace_back(lo.id, lo.timestamp); });
+  // z stays ahead of a, which only moved to 44.30 at 4
+  EXPECT_EQ(orders, (std::vector<std::pair<std::string, uint64_t> >{{"z", 1}, {"a", 4}}));
+}
@@ -4,7 +4,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <numeric>
 #include <random>
+#include <ranges>
+#include <set>
 #include <thread>
 
 using namespace OrderBookProgrammingProblem;
@@ -181,3 +184,144 @@ TEST(Bst, MultipleRoundsOfInsertAndDeleteShouldWork) {
   }
   EXPECT_EQ(root, nullptr);
 }
+
+TEST(ArenaBst, RandomInsertAndDeleteShouldMatchStdSet) {
+  ArenaBinarySearchTree<int> tree;
+  std::set<int> expected;
+  std::mt19937 generator(9527);
+  std::uniform_int_distribution dist(-5'000, 5'000);
+
+  for (int i = 0; i < 200'000; ++i) {
+    const auto ele = dist(generator);
+    if (generator() % 2) {
+      EXPECT_EQ(tree.insert(ele), expected.insert(ele).second);
+    } else {
+      EXPECT_EQ(tree.delete_node(ele), expected.erase(ele) == 1);
+    }
+    ASSERT_EQ(tree.size(), expected.size());
+    if (i % 10'000 == 0) {
+      EXPECT_TRUE(tree.is_valid_bst());
+      EXPECT_TRUE(std::ranges::equal(tree.inorder_traversal(), expected));
+    }
+  }
+  EXPECT_TRUE(tree.is_valid_bst());
+  EXPECT_TRUE(std::ranges::equal(tree.inorder_traversal(), expected));
+  // Freed nodes are reused, the arena never outgrows the peak size
+  EXPECT_LE(tree.capacity(), 10'001);
+}
+
+TEST(ArenaBst, DeletingANodeWithTwoChildrenShouldRelinkItsSuccessor) {
+  ArenaBinarySearchTree<int> tree;
+  for (const auto ele: {50, 30, 70, 60, 80, 65})
+    tree.insert(ele);
+  const auto *successor = tree.search(60);
+  ASSERT_NE(successor, nullptr);
+  EXPECT_TRUE(tree.delete_node(50));
+  // The successor moved up without being copied
+  EXPECT_EQ(&tree.node(tree.root()).val, successor);
+  EXPECT_EQ(tree.node(tree.root()).val, 60);
+  EXPECT_EQ(tree.inorder_traversal(), (std::vector{30, 60, 65, 70, 80}));
+  EXPECT_TRUE(tree.is_valid_bst());
+  EXPECT_FALSE(tree.delete_node(50));
+  const auto capacity = tree.capacity();
+  tree.insert(55);
+  EXPECT_EQ(tree.capacity(), capacity);
+}
+
+TEST(BstIterator, ShouldWalkBothOrdersInBothDirections) {
+  TreeNode<int> *root = nullptr;
+  ArenaBinarySearchTree<int> tree;
+  std::set<int> expected;
+  std::mt19937 generator(9527);
+  std::uniform_int_distribution dist(-1'000, 1'000);
+  for (int i = 0; i < 500; ++i) {
+    const auto ele = dist(generator);
+    BST::insert(&root, ele);
+    tree.insert(ele);
+    expected.insert(ele);
+  }
+
+  const auto ascending = BST::inorder<TraversalOrder::LeftRootRight>(root);
+  const auto descending = BST::inorder<TraversalOrder::RightRootLeft>(root);
+  static_assert(std::ranges::bidirectional_range<decltype(ascending)>);
+  EXPECT_TRUE(std::ranges::equal(ascending, expected));
+  EXPECT_TRUE(std::ranges::equal(descending, expected | std::views::reverse));
+  EXPECT_TRUE(std::ranges::equal(ascending | std::views::reverse, expected | std::views::reverse));
+  EXPECT_TRUE(std::ranges::equal(tree.inorder<TraversalOrder::LeftRootRight>(), expected));
+  EXPECT_TRUE(std::ranges::equal(tree.inorder<TraversalOrder::RightRootLeft>(), expected | std::views::reverse));
+  EXPECT_TRUE(std::ranges::equal(tree.inorder<TraversalOrder::RightRootLeft>() | std::views::reverse, expected));
+
+  // Stepping back and forth from the middle
+  auto it = std::ranges::next(tree.inorder<TraversalOrder::LeftRootRight>().begin(), 100);
+  auto expected_it = std::ranges::next(expected.begin(), 100);
+  EXPECT_EQ(*std::prev(it), *std::prev(expected_it));
+  EXPECT_EQ(*std::next(it, 3), *std::next(expected_it, 3));
+  EXPECT_EQ(*it, *expected_it);
+
+  EXPECT_TRUE(std::ranges::empty(BST::inorder<TraversalOrder::LeftRootRight>(nullptr)));
+  while (root != nullptr)
+    BST::delete_node(&root, root->val);
+}
+
+// Degenerate (list-shaped) trees are deeper than the inline part of the path
+TEST(BstIterator, ShouldHandleDeepTrees) {
+  ArenaBinarySearchTree<int> tree;
+  for (int i = 0; i < 1'000; ++i)
+    tree.insert(i);
+  EXPECT_TRUE(std::ranges::equal(tree.inorder<TraversalOrder::LeftRootRight>(), std::views::iota(0, 1'000)));
+  EXPECT_TRUE(std::ranges::equal(tree.inorder<TraversalOrder::RightRootLeft>(),
+                                 std::views::iota(0, 1'000) | std::views::reverse));
+  EXPECT_TRUE(std::ranges::equal(tree.inorder<TraversalOrder::LeftRootRight>() | std::views::reverse,
+                                 std::views::iota(0, 1'000) | std::views::reverse));
+}
+
+namespace {
+  struct SumAugment {
+    struct Summary {
+      int64_t count = 0;
+      int64_t sum = 0;
+    };
+
+    static Summary of(const int &val) { return {1, val}; }
+    static Summary combine(const Summary &a, const Summary &b) { return {a.count + b.count, a.sum + b.sum}; }
+  };
+
+  using SumTree = ArenaBinarySearchTree<int, SumAugment>;
+
+  // Recomputes every subtree summary from scratch and compares it with the
+  // stored one, returns the recomputed summary of idx
+  SumAugment::Summary check_summaries(const SumTree &tree, const SumTree::Index idx) {
+    if (idx == SumTree::null)
+      return {};
+    const auto &node = tree.node(idx);
+    const auto left = check_summaries(tree, node.left);
+    const auto right = check_summaries(tree, node.right);
+    const SumAugment::Summary expected{left.count + right.count + 1, left.sum + right.sum + node.val};
+    EXPECT_EQ(tree.summary(idx).count, expected.count);
+    EXPECT_EQ(tree.summary(idx).sum, expected.sum);
+    return expected;
+  }
+} // namespace
+
+TEST(ArenaBst, SubtreeSummariesShouldFollowInsertDeleteAndRefresh) {
+  SumTree tree;
+  std::set<int> expected;
+  std::mt19937 generator(9527);
+  std::uniform_int_distribution dist(-2'000, 2'000);
+  for (int i = 0; i < 20'000; ++i) {
+    const auto ele = dist(generator);
+    if (generator() % 3 == 0) {
+      EXPECT_EQ(tree.delete_node(ele), expected.erase(ele) == 1);
+    } else {
+      EXPECT_EQ(tree.insert(ele), expected.insert(ele).second);
+    }
+    if (i % 1'000 == 0)
+      check_summaries(tree, tree.root());
+  }
+  check_summaries(tree, tree.root());
+  EXPECT_EQ(tree.summary(tree.root()).count, expected.size());
+  EXPECT_EQ(tree.summary(tree.root()).sum, std::accumulate(expected.begin(), expected.end(), int64_t{0}));
+  EXPECT_FALSE(tree.refresh(dist.max() + 1));
+  EXPECT_TRUE(tree.refresh(*expected.begin()));
+  check_summaries(tree, tree.root());
+}
@@ -0,0 +1,146 @@
+#include "../order-book/order-book-array.h"
+#include "../order-book/order-book-skip-list.h"
+#include "../order-book/versioned-level-arrays.h"
+#include "../order.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace Problem = OrderBookProgrammingProblem;
+namespace Order = Problem::Order;
+
+namespace {
+  using ConcurrentPolicy = Problem::OrderBookPolicy<Problem::PriceLevelArray, Problem::StringIdPolicy,
+    Problem::PricePolicy<>, Problem::QuantityPolicy<>, true>;
+
+  constexpr int base_price_cent = 1000;
+  constexpr int price_step_cent = 3;
+  constexpr int level_count = 300;
+  constexpr int order_size = 10;
+  constexpr int target_size = 25;
+
+  Order::LimitOrder make_bid(const int k) {
+    Order::LimitOrder lo;
+    lo.type = Order::Type::Add;
+    lo.id = std::to_string(k);
+    lo.side = Order::Side::Bid;
+    lo.price_cent = base_price_cent + k * price_step_cent;
+    lo.size = order_size;
+    return lo;
+  }
+
+  Order::LimitOrder make_reduce(const int k) {
+    Order::LimitOrder lo;
+    lo.type = Order::Type::Reduce;
+    lo.id = std::to_string(k);
+    lo.size = order_size;
+    return lo;
+  }
+
+  template<typename OrderBookImpl>
+  class ConcurrentOrderBookTest : public testing::Test {
+  };
+
+  using ConcurrentOrderBookTypes = testing::Types<
+    Problem::OrderBookArray<ConcurrentPolicy>, Problem::OrderBookSkipList<ConcurrentPolicy> >;
+  TYPED_TEST_SUITE(ConcurrentOrderBookTest, ConcurrentOrderBookTypes);
+} // namespace
+
+// The writer only ever grows the bid side from the bottom and shrinks it from
+// the top, so any consistent snapshot holds levels 0..m and selling 25 costs
+// 10 * p(m) + 10 * p(m - 1) + 5 * p(m - 2). A torn read would show up as any
+// other cost.
+TYPED_TEST(ConcurrentOrderBookTest, ReadersShouldOnlySeeConsistentSnapshots) {
+  TypeParam order_book;
+  std::atomic<bool> done{false};
+  std::atomic<size_t> bad_reads{0};
+  std::atomic<size_t> priced_reads{0};
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 3; ++r) {
+    readers.emplace_back([&] {
+      const auto reader = order_book.make_reader();
+      while (!done.load(std::memory_order_relaxed)) {
+        const auto cost = reader.get_pricer_sell_cost_cent(target_size);
+        if (!cost.has_value())
+          continue;
+        ++priced_reads;
+        const auto scaled = cost.value() - int64_t{target_size} * base_price_cent + 20 * price_step_cent;
+        const auto top = scaled / (int64_t{target_size} * price_step_cent);
+        if (scaled % (int64_t{target_size} * price_step_cent) != 0 || top < 2 || top >= level_count)
+          ++bad_reads;
+        EXPECT_FALSE(reader.get_pricer_buy_cost_cent(1).has_value());
+      }
+    });
+  }
+
+  for (int round = 0; round < 50; ++round) {
+    for (int k = 0; k < level_count; ++k)
+      order_book.add_order(make_bid(k));
+    for (int k = level_count - 1; k >= 0; --k)
+      order_book.add_order(make_reduce(k));
+  }
+  done = true;
+  for (auto &reader: readers)
+    reader.join();
+
+  EXPECT_EQ(bad_reads.load(), 0);
+  EXPECT_FALSE(order_book.get_pricer_sell_cost_cent(1).has_value());
+  std::cout << "Priced reads: " << priced_reads.load() << std::endl;
+}
+
+TYPED_TEST(ConcurrentOrderBookTest, ReaderShouldMatchWriterWhenIdle) {
+  TypeParam order_book;
+  for (int k = 0; k < level_count; ++k)
+    order_book.add_order(make_bid(k));
+  const auto reader = order_book.make_reader();
+  for (const auto size: {1, 25, 1000, level_count * order_size, level_count * order_size + 1})
+    EXPECT_EQ(reader.get_pricer_sell_cost_cent(size), order_book.get_pricer_sell_cost_cent(size));
+}
+
+TEST(VersionedLevelArraysTest, RetiredBuffersShouldBeFreedOnceReadersUnpin) {
+  using Arrays = Problem::VersionedLevelArrays<int, int, true>;
+  Arrays arrays;
+  const auto price_of = [](const size_t i) { return static_cast<int>(i); };
+  const auto reader = arrays.register_reader();
+
+  std::atomic<bool> pinned{false};
+  std::atomic<bool> release{false};
+  std::thread pinning_reader([&] {
+    arrays.read(reader, [&](const int *, const int *, size_t, size_t) {
+      pinned = true;
+      while (!release)
+        std::this_thread::yield();
+      return 0;
+    });
+  });
+  while (!pinned)
+    std::this_thread::yield();
+
+  {
+    Arrays::WriteSection section(arrays);
+    arrays.resize(8, price_of);
+  }
+  {
+    // Concurrent read() calls spin while a write section is open, so the
+    // pinned reader is only let go once it is closed
+    Arrays::WriteSection section(arrays);
+    arrays.resize(64, price_of);
+  }
+  EXPECT_EQ(arrays.retired_buffer_count(), 1);
+  release = true;
+  pinning_reader.join();
+
+  {
+    Arrays::WriteSection section(arrays);
+    arrays.resize(1024, price_of);
+  }
+  EXPECT_EQ(arrays.retired_buffer_count(), 0);
+  EXPECT_EQ(arrays.size(), 1024);
+  EXPECT_EQ(arrays.prices()[1023], 1023);
+  arrays.unregister_reader(reader);
+}
@@ -0,0 +1,139 @@
+#include "../depth-kernel.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using namespace OrderBookProgrammingProblem;
+
+namespace {
+  template<bool Descending>
+  std::optional<int64_t> naive_fill_cost_cent(const std::vector<int32_t> &prices,
+                                              const std::vector<int32_t> &sizes,
+                                              int64_t target_size) {
+    int64_t cost_cent = 0;
+    for (size_t k = 0; k < sizes.size(); ++k) {
+      const auto i = Descending ? sizes.size() - 1 - k : k;
+      const auto filled = std::min<int64_t>(sizes[i], target_size);
+      cost_cent += filled * prices[i];
+      target_size -= filled;
+      if (target_size == 0 && filled > 0)
+        return cost_cent;
+    }
+    return std::nullopt;
+  }
+
+  template<bool Descending>
+  void expect_kernels_agree(const std::vector<int32_t> &prices,
+                            const std::vector<int32_t> &sizes,
+                            const int64_t target_size) {
+    const auto expected = naive_fill_cost_cent<Descending>(prices, sizes, target_size);
+    EXPECT_EQ(DepthKernel::fill_cost_cent_scalar<Descending>(prices.data(), sizes.data(),
+                sizes.size(), target_size), expected)
+        << "n: " << sizes.size() << ", target_size: " << target_size;
+#if DEPTH_KERNEL_HAS_AVX2
+    if (DepthKernel::cpu_supports_avx2()) {
+      EXPECT_EQ(DepthKernel::fill_cost_cent_avx2<Descending>(prices.data(), sizes.data(),
+                  sizes.size(), target_size), expected)
+          << "n: " << sizes.size() << ", target_size: " << target_size;
+    }
+#endif
+    EXPECT_EQ(DepthKernel::fill_cost_cent<Descending>(prices.data(), sizes.data(),
+                sizes.size(), target_size), expected);
+  }
+} // namespace
+
+TEST(DepthKernel, EmptyDepthShouldReturnNullopt) {
+  const std::vector<int32_t> prices, sizes;
+  expect_kernels_agree<false>(prices, sizes, 1);
+  expect_kernels_agree<true>(prices, sizes, 1);
+}
+
+TEST(DepthKernel, FillEndingExactlyOnABlockBoundaryShouldWork) {
+  std::vector<int32_t> prices(16), sizes(16, 100);
+  for (int i = 0; i < 16; ++i)
+    prices[i] = 4400 + i;
+  for (const auto target_size: {100, 799, 800, 801, 1600, 1601}) {
+    expect_kernels_agree<false>(prices, sizes, target_size);
+    expect_kernels_agree<true>(prices, sizes, target_size);
+  }
+}
+
+TEST(DepthKernel, LargeNotionalShouldNotOverflow) {
+  // Every level's notional is far beyond INT32_MAX, while the whole fill,
+  // two full 8-level blocks and then some, still fits in int64_t
+  const std::vector<int32_t> prices(20, 2'000'000'000), sizes(20, 100'000'000);
+  const int64_t target_size = 1'950'000'001;
+  static_assert(static_cast<__int128>(1'950'000'001) * 2'000'000'000 < INT64_MAX);
+  const auto cost_cent = DepthKernel::fill_cost_cent<false>(prices.data(), sizes.data(),
+                                                            sizes.size(), target_size);
+  ASSERT_TRUE(cost_cent.has_value());
+  EXPECT_EQ(cost_cent.value(), target_size * 2'000'000'000);
+  expect_kernels_agree<false>(prices, sizes, target_size);
+  expect_kernels_agree<true>(prices, sizes, target_size);
+}
+
+TEST(DepthKernel, RandomSparseDepthShouldMatchNaiveSweep) {
+  std::mt19937 gen(9527);
+  std::uniform_int_distribution<int32_t> size_dis(1, 1000);
+  for (int round = 0; round < 2'000; ++round) {
+    const auto n = gen() % 100;
+    std::vector<int32_t> prices(n), sizes(n);
+    for (size_t i = 0; i < n; ++i) {
+      prices[i] = 4000 + static_cast<int32_t>(i);
+      // Mostly empty cent slots, like the array book
+      sizes[i] = gen() % 4 == 0 ? size_dis(gen) : 0;
+    }
+    const int64_t target_size = 1 + gen() % 20'000;
+    expect_kernels_agree<false>(prices, sizes, target_size);
+    expect_kernels_agree<true>(prices, sizes, target_size);
+  }
+}
+
+TEST(DepthKernel, InverseQueriesShouldMatchNaiveSweep) {
+  std::mt19937 gen(4242);
+  std::uniform_int_distribution<int32_t> size_dis(1, 1000);
+  for (int round = 0; round < 2'000; ++round) {
+    const auto n = gen() % 100;
+    std::vector<int32_t> prices(n), sizes(n);
+    for (size_t i = 0; i < n; ++i) {
+      prices[i] = 4000 + static_cast<int32_t>(i);
+      sizes[i] = gen() % 4 == 0 ? size_dis(gen) : 0;
+    }
+    int64_t total = 0;
+    for (const auto size: sizes)
+      total += size;
+    EXPECT_EQ(DepthKernel::total_size(sizes.data(), n), total);
+
+    // Share by share in fill order, until one does not fit
+    const int64_t budget_cent = gen() % 50'000'000;
+    for (const bool descending: {false, true}) {
+      int64_t expected = 0;
+      int64_t spent = 0;
+      for (size_t k = 0; k < n; ++k) {
+        const auto i = descending ? n - 1 - k : k;
+        int32_t s = 0;
+        for (; s < sizes[i] && spent + prices[i] <= budget_cent; ++s) {
+          spent += prices[i];
+          ++expected;
+        }
+        if (s < sizes[i])
+          break;
+      }
+      const auto scalar = descending
+                            ? DepthKernel::size_within_budget_scalar<true>(prices.data(), sizes.data(), n, budget_cent)
+                            : DepthKernel::size_within_budget_scalar<false>(prices.data(), sizes.data(), n, budget_cent);
+      EXPECT_EQ(scalar, expected) << "n: " << n << ", budget_cent: " << budget_cent;
+#if DEPTH_KERNEL_HAS_AVX2
+      if (DepthKernel::cpu_supports_avx2()) {
+        const auto avx2 = descending
+                            ? DepthKernel::size_within_budget_avx2<true>(prices.data(), sizes.data(), n, budget_cent)
+                            : DepthKernel::size_within_budget_avx2<false>(prices.data(), sizes.data(), n, budget_cent);
+        EXPECT_EQ(avx2, expected) << "n: " << n << ", budget_cent: " << budget_cent;
+      }
+#endif
+    }
+  }
+}
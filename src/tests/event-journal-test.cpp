@@ -0,0 +1,200 @@
+#include "../feed-generator.h"
+#include "../journal/event-journal.h"
+#include "../order-book/order-book-registry.h"
+#include "test-utils.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace Problem = OrderBookProgrammingProblem;
+namespace Order = Problem::Order;
+namespace Journal = Problem::Journal;
+using Problem::Testing::TempPath;
+using Problem::Testing::levels;
+
+namespace {
+  using Record = std::pair<uint64_t, Order::LimitOrder>;
+
+  std::vector<Record> read_all(const Journal::EventJournal &journal) {
+    std::vector<Record> records;
+    journal.replay([&](const uint64_t sequence, const Order::LimitOrder &lo) { records.emplace_back(sequence, lo); });
+    return records;
+  }
+
+  // LimitOrder::operator== only compares prices
+  auto fields(const Order::LimitOrder &lo) {
+    return std::tuple(lo.timestamp, lo.type, lo.id, lo.side, lo.price_cent, lo.size);
+  }
+
+  void expect_same(const std::vector<Record> &actual, const std::vector<Record> &expected) {
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+      EXPECT_EQ(actual[i].first, expected[i].first) << i;
+      EXPECT_EQ(fields(actual[i].second), fields(expected[i].second)) << i;
+    }
+  }
+} // namespace
+
+TEST(EventJournalTest, RecordsShouldSurviveReopening) {
+  const TempPath file("reopen");
+  std::vector<Record> expected;
+  uint64_t sequence = 0;
+  for (const auto &lo: Problem::generate_synthetic_feed(1'000, 3, 100, 20))
+    expected.emplace_back(++sequence, lo);
+  // Every id length up to a few padding rounds
+  for (size_t n = 1; n <= 17; ++n) {
+    auto lo = expected.back().second;
+    lo.id = std::string(n, 'x');
+    expected.emplace_back(++sequence, lo);
+  }
+  {
+    Journal::EventJournal journal(file.path, 0, std::chrono::milliseconds(0));
+    for (size_t i = 0; i < 500; ++i)
+      journal.append(expected[i].first, expected[i].second);
+  }
+  {
+    Journal::EventJournal journal(file.path, 0, std::chrono::milliseconds(0));
+    EXPECT_EQ(journal.size(), 500);
+    EXPECT_EQ(journal.last_sequence_number(), 500);
+    for (size_t i = 500; i < expected.size(); ++i)
+      journal.append(expected[i].first, expected[i].second);
+    journal.commit();
+  }
+  const Journal::EventJournal journal(file.path, 0, std::chrono::milliseconds(0));
+  EXPECT_EQ(journal.last_sequence_number(), sequence);
+  expect_same(read_all(journal), expected);
+}
+
+TEST(EventJournalTest, JournalShouldGrowPastItsInitialCapacity) {
+  const TempPath file("grow");
+  const auto feed = Problem::generate_synthetic_feed(100'000, 5, 1'000, 50);
+  std::vector<Record> expected;
+  {
+    // The background thread syncs while the writer remaps
+    Journal::EventJournal journal(file.path, 0, std::chrono::milliseconds(1));
+    for (const auto &lo: feed) {
+      expected.emplace_back(expected.size() + 1, lo);
+      journal.append(expected.back().first, lo);
+    }
+    EXPECT_GT(journal.bytes_used(), size_t{1} << 20);
+  }
+  EXPECT_GT(std::filesystem::file_size(file.path), size_t{1} << 20);
+  expect_same(read_all(Journal::EventJournal(file.path, 0, std::chrono::milliseconds(0))), expected);
+}
+
+TEST(EventJournalTest, TornRecordShouldEndTheJournal) {
+  const TempPath file("torn");
+  const auto feed = Problem::generate_synthetic_feed(10, 7, 10, 5);
+  size_t third_record_offset = 0;
+  {
+    Journal::EventJournal journal(file.path, 0, std::chrono::milliseconds(0));
+    for (size_t i = 0; i < feed.size(); ++i) {
+      if (i == 2)
+        third_record_offset = journal.bytes_used();
+      journal.append(i + 1, feed[i]);
+    }
+  }
+  // Flips a byte of the third record's order id, as if the write had been
+  // cut short
+  const int fd = open(file.path.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  const auto offset = static_cast<off_t>(third_record_offset + sizeof(Journal::RecordHeader));
+  char byte = 0;
+  ASSERT_EQ(pread(fd, &byte, 1, offset), 1);
+  byte ^= 0x20;
+  ASSERT_EQ(pwrite(fd, &byte, 1, offset), 1);
+  close(fd);
+
+  {
+    Journal::EventJournal journal(file.path, 0, std::chrono::milliseconds(0));
+    EXPECT_EQ(journal.size(), 2);
+    EXPECT_EQ(journal.last_sequence_number(), 2);
+    // Appending overwrites the torn record, and what followed it is gone
+    journal.append(3, feed[2]);
+  }
+  const auto records = read_all(Journal::EventJournal(file.path, 0, std::chrono::milliseconds(0)));
+  ASSERT_EQ(records.size(), 3);
+  EXPECT_EQ(fields(records.back().second), fields(feed[2]));
+}
+
+TEST(EventJournalTest, RecordsPastAZeroedOneShouldBeDropped) {
+  const TempPath file("gap");
+  auto feed = Problem::generate_synthetic_feed(5'000, 19, 100, 5);
+  // Same id length throughout, so that new records land exactly on the
+  // headers of old ones
+  for (auto &lo: feed)
+    lo.id.resize(8, 'x');
+  size_t second_record_offset = 0;
+  {
+    Journal::EventJournal journal(file.path, 0, std::chrono::milliseconds(0));
+    for (size_t i = 0; i < feed.size(); ++i) {
+      if (i == 1)
+        second_record_offset = journal.bytes_used();
+      journal.append(i + 1, feed[i]);
+    }
+  }
+  // Zeroes the second record, as if its page had not reached the disk
+  // before a crash while later pages had
+  const int fd = open(file.path.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  const std::vector<char> zeros(Journal::record_size(8), 0);
+  ASSERT_EQ(pwrite(fd, zeros.data(), zeros.size(), static_cast<off_t>(second_record_offset)),
+            static_cast<ssize_t>(zeros.size()));
+  close(fd);
+
+  // Appends well past the first 64 KiB, over the old records
+  constexpr size_t appended = 3'000;
+  {
+    Journal::EventJournal journal(file.path, 0, std::chrono::milliseconds(0));
+    EXPECT_EQ(journal.size(), 1);
+    for (size_t i = 1; i <= appended; ++i)
+      journal.append(10'000 + i, feed[i]);
+  }
+  const Journal::EventJournal journal(file.path, 0, std::chrono::milliseconds(0));
+  EXPECT_EQ(journal.size(), appended + 1);
+  EXPECT_EQ(journal.last_sequence_number(), 10'000 + appended);
+}
+
+TEST(EventJournalTest, ReplayedBookShouldMatchTheOriginal) {
+  const TempPath file("replay");
+  const auto feed = Problem::generate_synthetic_feed(20'000, 11, 500, 20);
+  Problem::OrderBookStdMap<> original;
+  {
+    Journal::EventJournal journal(file.path, 0, std::chrono::milliseconds(5));
+    for (size_t i = 0; i < feed.size(); ++i) {
+      if (original.try_add_order(feed[i]).has_value())
+        journal.append(i + 1, feed[i]);
+    }
+  }
+  const Journal::EventJournal journal(file.path, 0, std::chrono::milliseconds(0));
+  for (const auto name: Problem::order_book_names) {
+    Problem::visit_order_book(name, [&]<typename OrderBookImpl>() {
+      OrderBookImpl recovered;
+      journal.replay([&](uint64_t, const Order::LimitOrder &lo) {
+        EXPECT_TRUE(recovered.try_add_order(lo).has_value()) << name << " " << lo;
+      });
+      for (const auto side: {Order::Side::Ask, Order::Side::Bid})
+        EXPECT_EQ(levels(recovered, side), levels(original, side)) << name;
+    });
+  }
+}
+
+TEST(EventJournalTest, OtherFilesShouldBeRefused) {
+  const TempPath file("foreign");
+  const int fd = open(file.path.c_str(), O_CREAT | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(write(fd, "not a journal", 13), 13);
+  close(fd);
+  EXPECT_THROW(Journal::EventJournal(file.path, 0, std::chrono::milliseconds(0)), std::invalid_argument);
+}
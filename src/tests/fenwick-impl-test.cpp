@@ -0,0 +1,87 @@
+#include "../fenwick-impl.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace OrderBookProgrammingProblem;
+
+TEST(Fenwick, AFewUpdatesShouldWork) {
+  FenwickTree<int64_t> fenwick;
+  EXPECT_EQ(fenwick.size(), 0);
+  EXPECT_EQ(fenwick.total(), 0);
+  EXPECT_EQ(fenwick.count_below(1), 0);
+  fenwick.grow(5);
+  fenwick.add(1, 10);
+  fenwick.add(3, 5);
+  fenwick.add(4, 7);
+  // Values: 0 10 0 5 7
+  EXPECT_EQ(fenwick.prefix_sum(0), 0);
+  EXPECT_EQ(fenwick.prefix_sum(2), 10);
+  EXPECT_EQ(fenwick.prefix_sum(4), 15);
+  EXPECT_EQ(fenwick.total(), 22);
+  EXPECT_EQ(fenwick.count_below(0), 0);
+  EXPECT_EQ(fenwick.count_below(10), 1);
+  EXPECT_EQ(fenwick.count_below(11), 3);
+  EXPECT_EQ(fenwick.count_below(23), 5);
+  EXPECT_EQ(fenwick.count_at_most(9), 1);
+  EXPECT_EQ(fenwick.count_at_most(10), 3);
+  EXPECT_EQ(fenwick.count_at_most(22), 5);
+  fenwick.add(1, -10);
+  EXPECT_EQ(fenwick.count_at_most(0), 3);
+  EXPECT_EQ(fenwick.total(), 12);
+}
+
+TEST(Fenwick, GrowShouldKeepValues) {
+  FenwickTree<int64_t> fenwick;
+  std::vector<int64_t> expected;
+  std::mt19937 gen(9527);
+  for (const size_t n: {1U, 3U, 8U, 13U, 64U, 100U}) {
+    fenwick.grow(n);
+    expected.resize(n);
+    for (int i = 0; i < 50; ++i) {
+      const auto idx = gen() % n;
+      const auto delta = static_cast<int64_t>(gen() % 100);
+      fenwick.add(idx, delta);
+      expected[idx] += delta;
+    }
+    ASSERT_EQ(fenwick.size(), n);
+    for (size_t count = 0; count <= n; ++count)
+      ASSERT_EQ(fenwick.prefix_sum(count), std::accumulate(expected.begin(), expected.begin() + count, int64_t{0}));
+  }
+  fenwick.grow(10);
+  EXPECT_EQ(fenwick.size(), 100);
+}
+
+TEST(Fenwick, SearchShouldMatchLinearScan) {
+  std::mt19937 gen(5);
+  constexpr size_t n = 300;
+  FenwickTree<int64_t> fenwick;
+  fenwick.grow(n);
+  std::vector<int64_t> values(n);
+  for (int i = 0; i < 5'000; ++i) {
+    // Mostly empty slots, as in a sparse book
+    const auto idx = gen() % n;
+    const auto delta = gen() % 4 == 0 ? static_cast<int64_t>(gen() % 50) : -values[idx];
+    fenwick.add(idx, delta);
+    values[idx] += delta;
+
+    const auto limit = static_cast<int64_t>(gen() % (fenwick.total() + 2));
+    size_t below = 0, at_most = 0;
+    int64_t sum = 0;
+    for (size_t count = 0; count <= n; ++count) {
+      if (sum < limit)
+        below = count;
+      if (sum <= limit)
+        at_most = count;
+      if (count < n)
+        sum += values[count];
+    }
+    ASSERT_EQ(fenwick.count_below(limit), below) << limit;
+    ASSERT_EQ(fenwick.count_at_most(limit), at_most) << limit;
+  }
+}
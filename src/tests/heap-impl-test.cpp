@@ -3,6 +3,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <queue>
+#include <set>
+#include <string>
 
 #include <print>
 #include <random>
@@ -53,3 +55,67 @@ TEST(Heap, MoreInsertAndDeleteShouldStillWork) {
         h.pop();
     }
 }
+
+TEST(IndexedHeap, EraseAndUpdateKeyShouldKeepTheOrder) {
+    IndexedHeap<int, std::string, std::greater<>> h;
+    EXPECT_THROW(h.top(), std::out_of_range);
+    const auto a = h.push(3, "a");
+    const auto b = h.push(7, "b");
+    const auto c = h.push(5, "c");
+    EXPECT_EQ(h.value(h.top()), "b");
+    h.erase(b);
+    EXPECT_EQ(h.value(h.top()), "c");
+    EXPECT_THROW(h.erase(b), std::out_of_range);
+    h.update_key(a, 9);
+    EXPECT_EQ(h.top(), a);
+    EXPECT_EQ(h.key(a), 9);
+    h.update_key(a, 1);
+    EXPECT_EQ(h.top(), c);
+    std::vector<int> keys;
+    h.for_each_in_order([&](const int key, auto) {
+        keys.push_back(key);
+        return true;
+    });
+    EXPECT_THAT(keys, testing::ElementsAre(5, 1));
+}
+
+TEST(IndexedHeap, RandomOperationsShouldMatchStdMultiset) {
+    std::mt19937 gen(9527);
+    std::uniform_int_distribution dis(0, 1'000);
+    IndexedHeap<int, int> h;
+    std::multiset<int> expected;
+    std::vector<IndexedHeap<int, int>::Handle> handles;
+
+    for (int i = 0; i < 100'000; ++i) {
+        const auto op = gen() % 4;
+        if (op < 2 || handles.empty()) {
+            const auto key = dis(gen);
+            handles.push_back(h.push(key, key));
+            expected.insert(key);
+        } else {
+            const auto pos = gen() % handles.size();
+            const auto handle = handles[pos];
+            expected.erase(expected.find(h.key(handle)));
+            if (op == 2) {
+                h.erase(handle);
+                handles[pos] = handles.back();
+                handles.pop_back();
+            } else {
+                const auto key = dis(gen);
+                h.update_key(handle, key);
+                expected.insert(key);
+            }
+        }
+        ASSERT_EQ(h.size(), expected.size());
+        if (!expected.empty())
+            ASSERT_EQ(h.key(h.top()), *expected.begin());
+        if (i % 1'000 == 0) {
+            std::vector<int> keys;
+            h.for_each_in_order([&](const int key, auto) {
+                keys.push_back(key);
+                return true;
+            });
+            ASSERT_TRUE(std::ranges::equal(keys, expected));
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#include "../huge-page-arena.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace OrderBookProgrammingProblem;
+
+TEST(HugePageArena, BlocksShouldBeAlignedAndReused) {
+  HugePageArena arena(1);
+  EXPECT_EQ(arena.size(), HugePageArena::huge_page_size);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(arena.allocate(1)) % HugePageArena::huge_page_size, 0);
+  void *small = arena.allocate(24);
+  void *aligned = arena.allocate(100, 64);
+  EXPECT_TRUE(arena.contains(small));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(small) % 32, 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0);
+  int on_stack = 0;
+  EXPECT_FALSE(arena.contains(&on_stack));
+
+  void *large = arena.allocate(100'000);
+  std::memset(large, 0xab, 100'000);
+  arena.deallocate(large);
+  EXPECT_EQ(arena.allocate(70'000), large);
+  arena.deallocate(small);
+  EXPECT_EQ(arena.allocate(32), small);
+}
+
+TEST(HugePageArena, LargeBlocksShouldBeAlignedToTheirSize) {
+  HugePageArena arena(HugePageArena::huge_page_size);
+  auto *first = static_cast<std::byte *>(arena.allocate(1));
+  void *large = arena.allocate(128 << 10);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % (128 << 10), 0);
+  // The chunk skipped to align it is not lost
+  EXPECT_EQ(arena.allocate(64 << 10), first + (64 << 10));
+  void *aligned = arena.allocate(100, 1 << 20);
+  ASSERT_NE(aligned, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % (1 << 20), 0);
+  EXPECT_EQ(arena.allocate(100, 2 * HugePageArena::huge_page_size), nullptr);
+}
+
+TEST(HugePageArena, ShouldReturnNullptrOnceFull) {
+  HugePageArena arena(HugePageArena::huge_page_size);
+  EXPECT_EQ(arena.allocate(HugePageArena::huge_page_size + 1), nullptr);
+  void *whole = arena.allocate(HugePageArena::huge_page_size);
+  ASSERT_NE(whole, nullptr);
+  EXPECT_EQ(arena.allocate(16), nullptr);
+  arena.deallocate(whole);
+  EXPECT_EQ(arena.allocate(HugePageArena::huge_page_size), whole);
+}
+
+TEST(HugePageArena, RandomBlocksShouldNotOverlap) {
+  HugePageArena arena(8 * HugePageArena::huge_page_size);
+  std::mt19937 gen(9527);
+  // Block start -> size, every live block is filled with its own byte
+  std::vector<std::pair<unsigned char *, size_t> > blocks;
+  for (int i = 0; i < 20'000; ++i) {
+    if (!blocks.empty() && gen() % 3 == 0) {
+      const auto victim = gen() % blocks.size();
+      const auto [p, size] = blocks[victim];
+      for (size_t k = 0; k < size; ++k)
+        ASSERT_EQ(p[k], static_cast<unsigned char>(reinterpret_cast<uintptr_t>(p) >> 4));
+      arena.deallocate(p);
+      blocks[victim] = blocks.back();
+      blocks.pop_back();
+      continue;
+    }
+    const size_t size = gen() % 8 == 0 ? gen() % 200'000 : gen() % 300;
+    auto *p = static_cast<unsigned char *>(arena.allocate(size));
+    if (p == nullptr)
+      continue;
+    std::memset(p, static_cast<unsigned char>(reinterpret_cast<uintptr_t>(p) >> 4), size);
+    blocks.emplace_back(p, size);
+  }
+  std::set<unsigned char *> starts;
+  for (const auto &[p, size]: blocks)
+    EXPECT_TRUE(starts.insert(p).second);
+}
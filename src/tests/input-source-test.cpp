@@ -0,0 +1,171 @@
+#include "../input/input-source-registry.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Problem = OrderBookProgrammingProblem;
+
+namespace {
+  // Lines of every length from 0 to 40, the last one without a newline
+  std::string make_content() {
+    std::string content;
+    for (int i = 0; i <= 40; ++i)
+      content += std::string(i, static_cast<char>('a' + i % 26)) + (i < 40 ? "\n" : "");
+    return content;
+  }
+
+  template<typename InputSource>
+  std::vector<std::string> read_all(Problem::IInputSource<InputSource> &source) {
+    std::vector<std::string> lines;
+    while (const auto line = source.next_line())
+      lines.emplace_back(line.value());
+    return lines;
+  }
+
+  class TempFile {
+    std::string path = "/tmp/input-source-test-XXXXXX";
+
+  public:
+    int fd;
+
+    explicit TempFile(const std::string &content) {
+      fd = mkstemp(path.data());
+      EXPECT_EQ(write(fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+      lseek(fd, 0, SEEK_SET);
+    }
+
+    ~TempFile() {
+      close(fd);
+      unlink(path.c_str());
+    }
+  };
+
+  std::string gzip(const std::string &content) {
+    z_stream stream{};
+    // 15 + 16: largest window, gzip header
+    EXPECT_EQ(deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY), Z_OK);
+    std::string compressed(deflateBound(&stream, content.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(content.data()));
+    stream.avail_in = static_cast<uInt>(content.size());
+    stream.next_out = reinterpret_cast<Bytef *>(compressed.data());
+    stream.avail_out = static_cast<uInt>(compressed.size());
+    EXPECT_EQ(deflate(&stream, Z_FINISH), Z_STREAM_END);
+    compressed.resize(stream.total_out);
+    deflateEnd(&stream);
+    return compressed;
+  }
+
+  std::vector<std::string> expected_lines() {
+    std::istringstream in(make_content());
+    Problem::StreamInputSource source(in);
+    return read_all(source);
+  }
+} // namespace
+
+TEST(InputSourceTest, StreamSourceShouldSplitLines) {
+  const auto lines = expected_lines();
+  ASSERT_EQ(lines.size(), 41);
+  EXPECT_EQ(lines[0], "");
+  EXPECT_EQ(lines[40], std::string(40, 'o'));
+}
+
+TEST(InputSourceTest, ReadSourceShouldMatchStreamSourceForAnyBlockSize) {
+  for (const size_t block_size: {1, 7, 64, 4096}) {
+    TempFile file(make_content());
+    Problem::BlockInputSource<Problem::ReadBlockReader> source(file.fd, block_size);
+    EXPECT_EQ(read_all(source), expected_lines()) << "block_size: " << block_size;
+  }
+}
+
+TEST(InputSourceTest, IoUringSourceShouldMatchStreamSourceForAnyBlockSize) {
+  for (const size_t block_size: {1, 7, 64, 4096}) {
+    for (const size_t queue_depth: {1, 2, 8}) {
+      TempFile file(make_content());
+      Problem::BlockInputSource<Problem::IoUringBlockReader> source(file.fd, block_size, queue_depth);
+      EXPECT_EQ(read_all(source), expected_lines())
+          << "block_size: " << block_size << ", queue_depth: " << queue_depth;
+    }
+  }
+}
+
+TEST(InputSourceTest, IoUringShouldFallBackToReadForPipes) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  const auto content = make_content();
+  ASSERT_EQ(write(fds[1], content.data(), content.size()), static_cast<ssize_t>(content.size()));
+  close(fds[1]);
+  EXPECT_THROW(Problem::IoUringBlockReader reader(fds[0]), std::system_error);
+  const auto lines = Problem::visit_input_source("io-uring", fds[0], [](auto &source) {
+    return read_all(source);
+  });
+  EXPECT_EQ(lines, expected_lines());
+  close(fds[0]);
+}
+
+TEST(InputSourceTest, UnknownInputSourceShouldThrow) {
+  EXPECT_THROW(Problem::visit_input_source("nope", STDIN_FILENO, [](auto &) { return 0; }),
+               std::invalid_argument);
+}
+
+TEST(InputSourceTest, GzipSourceShouldMatchStreamSourceForAnyBlockSize) {
+  for (const size_t block_size: {1, 7, 4096}) {
+    for (const size_t block_count: {1, 2, 4}) {
+      TempFile file(gzip(make_content()));
+      Problem::BlockInputSource<Problem::DecompressingBlockReader<Problem::GzipDecoder> > source(
+        file.fd, block_size, block_count);
+      EXPECT_EQ(read_all(source), expected_lines())
+          << "block_size: " << block_size << ", block_count: " << block_count;
+    }
+  }
+}
+
+TEST(InputSourceTest, GzipSourceShouldReadConcatenatedMembers) {
+  TempFile file(gzip("1 A a B 1.00 1\n") + gzip("2 R a 1\n"));
+  const auto lines = Problem::visit_input_source("gzip", file.fd, [](auto &source) {
+    return read_all(source);
+  });
+  EXPECT_THAT(lines, testing::ElementsAre("1 A a B 1.00 1", "2 R a 1"));
+}
+
+TEST(InputSourceTest, TruncatedGzipInputShouldThrow) {
+  const auto compressed = gzip(make_content());
+  TempFile file(compressed.substr(0, compressed.size() / 2));
+  Problem::BlockInputSource<Problem::DecompressingBlockReader<Problem::GzipDecoder> > source(file.fd);
+  EXPECT_THROW(read_all(source), std::runtime_error);
+}
+
+TEST(InputSourceTest, InputSourceShouldFollowFileExtension) {
+  EXPECT_EQ(Problem::input_source_for_path("pricer.in.gz"), "gzip");
+  EXPECT_EQ(Problem::input_source_for_path("pricer.in.zst"), "zstd");
+  EXPECT_EQ(Problem::input_source_for_path("pricer.in"), "io-uring");
+  EXPECT_EQ(Problem::input_source_for_path(""), "io-uring");
+}
+
+#if defined(HAS_ZSTD) && (HAS_ZSTD == 1)
+TEST(InputSourceTest, ZstdSourceShouldMatchStreamSource) {
+  const auto content = make_content();
+  std::string compressed(ZSTD_compressBound(content.size()), '\0');
+  compressed.resize(ZSTD_compress(compressed.data(), compressed.size(), content.data(), content.size(), 3));
+  for (const size_t block_size: {1, 7, 4096}) {
+    TempFile file(compressed + compressed);
+    Problem::BlockInputSource<Problem::DecompressingBlockReader<Problem::ZstdDecoder> > source(
+      file.fd, block_size, 2);
+    const auto lines = expected_lines();
+    auto expected = lines;
+    // The last line has no newline, so it runs into the first one of the
+    // second frame
+    expected.back() += lines.front();
+    expected.insert(expected.end(), lines.begin() + 1, lines.end());
+    EXPECT_EQ(read_all(source), expected) << "block_size: " << block_size;
+  }
+}
+#endif
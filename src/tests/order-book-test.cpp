@@ -0,0 +1,411 @@
+#include "../order-book/order-book-registry.h"
+#include "../order.h"
+#include "../utils.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+
+namespace Problem = OrderBookProgrammingProblem;
+namespace Order = Problem::Order;
+
+namespace {
+  // Keeps every live order in a plain map and prices a side by sorting it,
+  // slow but obviously correct
+  class BruteForceBook {
+    std::map<std::string, Order::LimitOrder> orders;
+
+  public:
+    void add_order(const Order::LimitOrder &lo) {
+      if (lo.type == Order::Type::Add) {
+        orders[lo.id] = lo;
+        return;
+      }
+      auto &existing = orders.at(lo.id);
+      if (lo.type == Order::Type::Replace) {
+        existing.price_cent = lo.price_cent;
+        existing.size = lo.size;
+        return;
+      }
+      existing.size -= lo.type == Order::Type::Cancel ? existing.size : lo.size;
+      if (existing.size == 0)
+        orders.erase(lo.id);
+    }
+
+    // Levels of one side in fill order as (price_cent, size) pairs
+    [[nodiscard]] std::vector<std::pair<int, int> > get_levels(const Order::Side side) const {
+      std::map<int, int> levels;
+      for (const auto &order: orders | std::views::values)
+        if (order.side == side)
+          levels[order.price_cent] += order.size;
+      std::vector<std::pair<int, int> > result(levels.begin(), levels.end());
+      if (side == Order::Side::Bid)
+        std::ranges::reverse(result);
+      return result;
+    }
+
+    [[nodiscard]] std::optional<int64_t> get_cost_cent(const Order::Side side, int target_size) const {
+      int64_t cost_cent = 0;
+      for (const auto &[price_cent, size]: get_levels(side)) {
+        const auto filled = std::min(size, target_size);
+        cost_cent += static_cast<int64_t>(filled) * price_cent;
+        target_size -= filled;
+        if (target_size == 0)
+          return cost_cent;
+      }
+      return std::nullopt;
+    }
+
+    [[nodiscard]] int64_t get_size_within_price(const Order::Side side, const int limit_price_cent) const {
+      int64_t size = 0;
+      for (const auto &order: orders | std::views::values) {
+        if (order.side == side &&
+            (side == Order::Side::Bid ? order.price_cent >= limit_price_cent : order.price_cent <= limit_price_cent))
+          size += order.size;
+      }
+      return size;
+    }
+
+    // Binary search for the largest size whose cost fits, as cost only grows
+    // with size
+    [[nodiscard]] int64_t get_size_within_budget(const Order::Side side, const int64_t budget_cent) const {
+      int64_t low = 0;
+      int64_t high = 0;
+      for (const auto &[price_cent, size]: get_levels(side))
+        high += size;
+      while (low < high) {
+        const auto mid = (low + high + 1) / 2;
+        if (get_cost_cent(side, static_cast<int>(mid)).value() <= budget_cent)
+          low = mid;
+        else
+          high = mid - 1;
+      }
+      return budget_cent < 0 ? 0 : low;
+    }
+
+    [[nodiscard]] std::vector<std::string> get_ids() const {
+      std::vector<std::string> ids;
+      for (const auto &id: orders | std::views::keys)
+        ids.push_back(id);
+      return ids;
+    }
+
+    [[nodiscard]] int get_order_size(const std::string &id) const { return orders.at(id).size; }
+
+    [[nodiscard]] int get_order_price_cent(const std::string &id) const { return orders.at(id).price_cent; }
+
+    [[nodiscard]] Order::Side get_order_side(const std::string &id) const { return orders.at(id).side; }
+  };
+
+  // A feed of Add/Reduce messages around 44.20 which only reduces live
+  // orders, with Cancel and Replace messages mixed in if modify is set
+  std::vector<Order::LimitOrder> generate_feed(const size_t n, const unsigned seed, const bool modify = false) {
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<> offset(0, 60);
+    std::uniform_int_distribution<> size_idx(0, 5);
+    constexpr std::array sizes = {10, 50, 100, 157, 200, 1000};
+    BruteForceBook book;
+    std::vector<Order::LimitOrder> feed;
+    uint64_t timestamp = 28800000;
+    for (size_t i = 0; i < n; ++i) {
+      Order::LimitOrder lo;
+      lo.timestamp = timestamp += gen() % 3;
+      const auto ids = book.get_ids();
+      if (modify && !ids.empty() && gen() % 100 < 30) {
+        lo.id = ids[gen() % ids.size()];
+        if (gen() % 3 == 0) {
+          lo.type = Order::Type::Cancel;
+        } else {
+          // Half of the replaces keep the price and only change the size
+          lo.type = Order::Type::Replace;
+          const auto side = book.get_order_side(lo.id);
+          lo.price_cent = gen() % 2
+                            ? book.get_order_price_cent(lo.id)
+                            : side == Order::Side::Bid ? 4419 - offset(gen) : 4420 + offset(gen);
+          lo.size = sizes[size_idx(gen)];
+        }
+      } else if (!ids.empty() && gen() % 100 < 45) {
+        lo.type = Order::Type::Reduce;
+        lo.id = ids[gen() % ids.size()];
+        const auto order_size = book.get_order_size(lo.id);
+        lo.size = gen() % 2 ? order_size : 1 + static_cast<int>(gen() % order_size);
+      } else {
+        lo.type = Order::Type::Add;
+        lo.id = std::to_string(i);
+        lo.side = gen() % 2 ? Order::Side::Bid : Order::Side::Ask;
+        lo.price_cent = lo.side == Order::Side::Bid ? 4419 - offset(gen) : 4420 + offset(gen);
+        lo.size = sizes[size_idx(gen)];
+      }
+      book.add_order(lo);
+      feed.push_back(lo);
+    }
+    return feed;
+  }
+
+  template<typename OrderBookImpl>
+  void expect_same_costs_as_brute_force(const std::vector<Order::LimitOrder> &feed) {
+    OrderBookImpl order_book;
+    BruteForceBook reference;
+    for (const auto &lo: feed) {
+      order_book.add_order(lo);
+      reference.add_order(lo);
+      for (const auto target_size: {1, 200, 1000, 10000}) {
+        const auto sell = order_book.get_pricer_sell_cost_cent(target_size);
+        const auto buy = order_book.get_pricer_buy_cost_cent(target_size);
+        ASSERT_EQ(sell.has_value(), reference.get_cost_cent(Order::Side::Bid, target_size).has_value());
+        ASSERT_EQ(buy.has_value(), reference.get_cost_cent(Order::Side::Ask, target_size).has_value());
+        if (sell.has_value())
+          ASSERT_EQ(sell.value(), reference.get_cost_cent(Order::Side::Bid, target_size).value())
+              << lo << ", target_size: " << target_size;
+        if (buy.has_value())
+          ASSERT_EQ(buy.value(), reference.get_cost_cent(Order::Side::Ask, target_size).value())
+              << lo << ", target_size: " << target_size;
+      }
+    }
+  }
+
+  template<typename OrderBookImpl>
+  class OrderBookTest : public testing::Test {
+  };
+
+  using Policy = Problem::DefaultOrderBookPolicy;
+  using DictPackedPolicy = Problem::OrderBookPolicy<Problem::PriceLevelDict, Problem::PackedIdPolicy>;
+  using ListRangePolicy = Problem::OrderBookPolicy<Problem::PriceLevelDoublyLinkedList,
+    Problem::StringIdPolicy, Problem::PricePolicy<int, 4000, 5000> >;
+  using OrderBookTypes = testing::Types<
+    Problem::OrderBookArray<Policy>, Problem::OrderBookArray<DictPackedPolicy>,
+    Problem::OrderBookArray<ListRangePolicy>,
+    Problem::OrderBookFenwickArray<Policy>, Problem::OrderBookFenwickArray<DictPackedPolicy>,
+    Problem::OrderBookFenwickArray<ListRangePolicy>,
+    Problem::OrderBookBst<Policy>, Problem::OrderBookBst<DictPackedPolicy>,
+    Problem::OrderBookBst<ListRangePolicy>,
+    Problem::OrderBookAugmentedBst<Policy>, Problem::OrderBookAugmentedBst<DictPackedPolicy>,
+    Problem::OrderBookAugmentedBst<ListRangePolicy>,
+    Problem::OrderBookHeap<Policy>, Problem::OrderBookHeap<DictPackedPolicy>,
+    Problem::OrderBookHeap<ListRangePolicy>,
+    Problem::OrderBookSkipList<Policy>, Problem::OrderBookSkipList<DictPackedPolicy>,
+    Problem::OrderBookSkipList<ListRangePolicy>,
+    Problem::OrderBookStdMap<Policy>, Problem::OrderBookStdMap<DictPackedPolicy>,
+    Problem::OrderBookStdMap<ListRangePolicy>,
+    Problem::OrderBookVeb<Policy>, Problem::OrderBookVeb<DictPackedPolicy>,
+    Problem::OrderBookVeb<ListRangePolicy> >;
+  TYPED_TEST_SUITE(OrderBookTest, OrderBookTypes);
+} // namespace
+
+TYPED_TEST(OrderBookTest, ExampleInputShouldMatchExampleOutput) {
+  Problem::Utils utils;
+  TypeParam order_book;
+  const std::vector<std::string> lines = {
+    "28800538 A b S 44.26 100", "28800562 A c B 44.10 100",
+    "28800744 R b 100", "28800758 A d B 44.18 157",
+    "28800773 A e S 44.38 100", "28800796 R d 157",
+    "28800812 A f B 44.18 157", "28800974 A g S 44.27 100"
+  };
+  std::vector<std::optional<int64_t> > sells, buys;
+  for (const auto &line: lines) {
+    order_book.add_order(utils.parse_limit_order(line));
+    sells.emplace_back(order_book.get_pricer_sell_cost_cent(200));
+    buys.emplace_back(order_book.get_pricer_buy_cost_cent(200));
+  }
+  const std::vector<std::optional<int64_t> > expected_sells = {
+    std::nullopt, std::nullopt, std::nullopt, 883256, 883256, std::nullopt, 883256, 883256
+  };
+  const std::vector<std::optional<int64_t> > expected_buys = {
+    std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, 886500
+  };
+  EXPECT_EQ(sells, expected_sells);
+  EXPECT_EQ(buys, expected_buys);
+}
+
+TYPED_TEST(OrderBookTest, RandomFeedShouldMatchBruteForce) {
+  expect_same_costs_as_brute_force<TypeParam>(generate_feed(3'000, 9527));
+}
+
+TYPED_TEST(OrderBookTest, CancelAndReplaceFeedShouldMatchBruteForce) {
+  expect_same_costs_as_brute_force<TypeParam>(generate_feed(3'000, 2024, true));
+}
+
+TYPED_TEST(OrderBookTest, ReplaceShouldModifyInPlaceOrMoveTheOrder) {
+  Problem::Utils utils;
+  TypeParam order_book;
+  for (const auto *line: {"1 A a S 44.26 100", "2 A b S 44.30 100", "3 A c B 44.10 100"})
+    order_book.add_order(utils.parse_limit_order(line));
+
+  // Same price: the level grows or shrinks and keeps its place
+  order_book.add_order(utils.parse_limit_order("4 U a 44.26 300"));
+  EXPECT_EQ(order_book.get_pricer_buy_cost_cent(300), 300 * 4426);
+  order_book.add_order(utils.parse_limit_order("5 U a 44.26 50"));
+  EXPECT_EQ(order_book.get_pricer_buy_cost_cent(150), 50 * 4426 + 100 * 4430);
+
+  // New price: the order leaves 44.26 and joins 44.30
+  order_book.add_order(utils.parse_limit_order("6 U a 44.30 50"));
+  std::vector<std::pair<int, int> > levels;
+  order_book.for_each_level(Order::Side::Ask, [&](const auto price_cent, const auto size) {
+    levels.emplace_back(price_cent, size);
+    return true;
+  });
+  EXPECT_EQ(levels, (std::vector<std::pair<int, int> >{{4430, 150}}));
+
+  // The order still exists under its id after the move
+  order_book.add_order(utils.parse_limit_order("7 R a 25"));
+  EXPECT_EQ(order_book.get_pricer_buy_cost_cent(125), 125 * 4430);
+  order_book.add_order(utils.parse_limit_order("8 C a"));
+  order_book.add_order(utils.parse_limit_order("9 C c"));
+  EXPECT_EQ(order_book.get_pricer_buy_cost_cent(100), 100 * 4430);
+  EXPECT_FALSE(order_book.get_pricer_buy_cost_cent(101).has_value());
+  EXPECT_FALSE(order_book.get_pricer_sell_cost_cent(1).has_value());
+  EXPECT_EQ(order_book.try_add_order(utils.parse_limit_order("10 C a")).error(),
+            Problem::RejectReason::unknown_id);
+  EXPECT_EQ(order_book.try_add_order(utils.parse_limit_order("11 U b 44.30 0")).error(),
+            Problem::RejectReason::non_positive_size);
+}
+
+TYPED_TEST(OrderBookTest, InverseQueriesShouldMatchBruteForce) {
+  TypeParam order_book;
+  BruteForceBook reference;
+  const auto feed = generate_feed(2'000, 77, true);
+  for (size_t i = 0; i < feed.size(); ++i) {
+    order_book.add_order(feed[i]);
+    reference.add_order(feed[i]);
+    if (i % 10 != 0)
+      continue;
+    for (const auto limit_price_cent: {0, 4350, 4400, 4419, 4420, 4421, 4440, 4490, 100'000}) {
+      ASSERT_EQ(order_book.get_pricer_sell_size_within_price(limit_price_cent),
+                reference.get_size_within_price(Order::Side::Bid, limit_price_cent)) << i << ", " << limit_price_cent;
+      ASSERT_EQ(order_book.get_pricer_buy_size_within_price(limit_price_cent),
+                reference.get_size_within_price(Order::Side::Ask, limit_price_cent)) << i << ", " << limit_price_cent;
+    }
+    for (const int64_t budget_cent: {int64_t{-1}, int64_t{0}, int64_t{4419}, int64_t{100'000}, int64_t{2'210'000},
+                                     int64_t{20'000'000}, int64_t{1} << 40}) {
+      ASSERT_EQ(order_book.get_pricer_sell_size_within_budget(budget_cent),
+                reference.get_size_within_budget(Order::Side::Bid, budget_cent)) << i << ", " << budget_cent;
+      ASSERT_EQ(order_book.get_pricer_buy_size_within_budget(budget_cent),
+                reference.get_size_within_budget(Order::Side::Ask, budget_cent)) << i << ", " << budget_cent;
+    }
+  }
+}
+
+TYPED_TEST(OrderBookTest, LevelsShouldBeVisitedFromTheBestPrice) {
+  TypeParam order_book;
+  BruteForceBook reference;
+  for (const auto &lo: generate_feed(2'000, 42)) {
+    order_book.add_order(lo);
+    reference.add_order(lo);
+  }
+  for (const auto side: {Order::Side::Bid, Order::Side::Ask}) {
+    std::vector<std::pair<int, int> > levels;
+    order_book.for_each_level(side, [&](const auto price_cent, const auto size) {
+      levels.emplace_back(price_cent, size);
+      return true;
+    });
+    EXPECT_EQ(levels, reference.get_levels(side));
+
+    levels.clear();
+    order_book.for_each_level(side, [&](const auto price_cent, const auto size) {
+      levels.emplace_back(price_cent, size);
+      return levels.size() < 3;
+    });
+    EXPECT_EQ(levels.size(), std::min<size_t>(3, reference.get_levels(side).size()));
+  }
+}
+
+TYPED_TEST(OrderBookTest, DeepFillCostShouldNotOverflowInt) {
+  TypeParam order_book;
+  Order::LimitOrder lo;
+  lo.side = Order::Side::Ask;
+  lo.price_cent = 4999;
+  lo.size = 1'000'000;
+  for (int i = 0; i < 3; ++i) {
+    lo.id = std::to_string(i);
+    order_book.add_order(lo);
+  }
+  EXPECT_EQ(order_book.get_pricer_buy_cost_cent(2'500'000), int64_t{2'500'000} * 4999);
+}
+
+TYPED_TEST(OrderBookTest, NonPositiveTargetSizeShouldNotThrow) {
+  Problem::Utils utils;
+  TypeParam order_book;
+  for (const auto target_size: {0, -1}) {
+    EXPECT_FALSE(order_book.get_pricer_sell_cost_cent(target_size).has_value());
+    EXPECT_FALSE(order_book.get_pricer_buy_cost_cent(target_size).has_value());
+  }
+  for (const auto *line: {"1 A a S 44.26 100", "2 A b B 44.10 100"})
+    order_book.add_order(utils.parse_limit_order(line));
+  EXPECT_EQ(order_book.get_pricer_sell_cost_cent(0), 0);
+  EXPECT_EQ(order_book.get_pricer_buy_cost_cent(0), 0);
+  EXPECT_TRUE(order_book.get_pricer_sell_cost_cent(-1).has_value());
+  EXPECT_TRUE(order_book.get_pricer_buy_cost_cent(-1).has_value());
+}
+
+TYPED_TEST(OrderBookTest, UnknownOrderIdShouldThrow) {
+  TypeParam order_book;
+  Order::LimitOrder lo;
+  lo.type = Order::Type::Reduce;
+  lo.id = "nope";
+  lo.size = 1;
+  EXPECT_THROW(order_book.add_order(lo), std::invalid_argument);
+}
+
+TYPED_TEST(OrderBookTest, RejectedOrdersShouldLeaveTheBookUntouched) {
+  TypeParam order_book;
+  Order::LimitOrder lo;
+  lo.id = "a";
+  lo.side = Order::Side::Ask;
+  lo.price_cent = 4500;
+  lo.size = 100;
+  ASSERT_TRUE(order_book.try_add_order(lo).has_value());
+  const auto before = order_book.to_string();
+
+  auto rejected = lo;
+  EXPECT_EQ(order_book.try_add_order(rejected).error(), Problem::RejectReason::duplicate_id);
+  rejected.id = "b";
+  rejected.size = 0;
+  EXPECT_EQ(order_book.try_add_order(rejected).error(), Problem::RejectReason::non_positive_size);
+  rejected.size = -10;
+  EXPECT_EQ(order_book.try_add_order(rejected).error(), Problem::RejectReason::non_positive_size);
+  rejected.size = 10;
+  rejected.price_cent = -1;
+  EXPECT_EQ(order_book.try_add_order(rejected).error(), Problem::RejectReason::price_out_of_range);
+  rejected.type = Order::Type::Reduce;
+  EXPECT_EQ(order_book.try_add_order(rejected).error(), Problem::RejectReason::unknown_id);
+  EXPECT_EQ(order_book.to_string(), before);
+  EXPECT_EQ(order_book.get_pricer_buy_cost_cent(100), 450000);
+
+  // Reducing by more than what is left removes the order
+  lo.type = Order::Type::Reduce;
+  lo.size = 1000;
+  ASSERT_TRUE(order_book.try_add_order(lo).has_value());
+  EXPECT_FALSE(order_book.get_pricer_buy_cost_cent(1).has_value());
+  EXPECT_EQ(order_book.try_add_order(lo).error(), Problem::RejectReason::unknown_id);
+}
+
+TEST(OrderBookRegistryTest, AllRegisteredNamesShouldResolve) {
+  for (const auto name: Problem::order_book_names) {
+    EXPECT_TRUE(Problem::visit_order_book(name, []<typename OrderBookImpl>() {
+      OrderBookImpl order_book;
+      return !order_book.get_pricer_buy_cost_cent(1).has_value();
+      }));
+  }
+  EXPECT_THROW(Problem::visit_order_book("nope", []<typename>() { return true; }),
+               std::invalid_argument);
+}
+
+TEST(OrderBookPolicyTest, PricesOutOfRangeShouldBeRejected) {
+  Problem::OrderBookArray<ListRangePolicy> order_book;
+  Order::LimitOrder lo;
+  lo.id = "a";
+  lo.price_cent = 3999;
+  lo.size = 100;
+  EXPECT_THROW(order_book.add_order(lo), std::invalid_argument);
+  lo.price_cent = 4000;
+  order_book.add_order(lo);
+  EXPECT_EQ(order_book.get_pricer_sell_cost_cent(100), 400000);
+}
+
+TEST(OrderBookPolicyTest, PackedIdPolicyShouldRejectLongIds) {
+  EXPECT_NE(Problem::PackedIdPolicy::to_key("abcd"), Problem::PackedIdPolicy::to_key("abce"));
+  EXPECT_THROW(Problem::PackedIdPolicy::to_key("123456789"), std::invalid_argument);
+}
@@ -125,3 +125,54 @@ TEST(OrderTest, TestInputLines) {
   EXPECT_EQ(lo.price_cent, 4427);
   EXPECT_EQ(lo.size, 100);
 }
+
+TEST(OrderTest, MalformedLinesShouldBeRejectedWithReason) {
+  Problem::Utils utils;
+  using Problem::RejectReason;
+  const std::vector<std::pair<std::string, RejectReason> > cases = {
+    {"28800538", RejectReason::malformed_line},
+    {"28800538 X b S 44.26 100", RejectReason::bad_type},
+    {"28800538 A b S 44.26", RejectReason::malformed_line},
+    {"28800744 R b 100 1", RejectReason::malformed_line},
+    {"2880o538 A b S 44.26 100", RejectReason::bad_timestamp},
+    {"28800538 A b Q 44.26 100", RejectReason::bad_side},
+    {"28800538 A b S 44.265 100", RejectReason::bad_price},
+    {"28800538 A b S abc 100", RejectReason::bad_price},
+    {"28800538 A b S 44.26 lots", RejectReason::bad_size},
+    {"28800538 A b S 44.26x 100", RejectReason::bad_price},
+    {"28800538 A b S 44.26 100x", RejectReason::bad_size},
+    {"28800744 R b ", RejectReason::bad_size},
+    {"28800744 C b 100", RejectReason::malformed_line},
+    {"28800744 U b 100", RejectReason::malformed_line},
+    {"28800744 U b 44.265 100", RejectReason::bad_price},
+    {"28800744 U b 44.26 x", RejectReason::bad_size},
+  };
+  for (const auto &[line, reason]: cases) {
+    const auto lo = utils.try_parse_limit_order(line);
+    ASSERT_FALSE(lo.has_value()) << line;
+    EXPECT_EQ(lo.error(), reason) << line;
+    EXPECT_THROW(utils.parse_limit_order(line), std::invalid_argument) << line;
+  }
+  const auto lo = utils.try_parse_limit_order("28800744 R b -5");
+  ASSERT_TRUE(lo.has_value());
+  EXPECT_EQ(lo->size, -5);
+}
+
+TEST(OrderTest, CancelAndReplaceLinesShouldParse) {
+  Problem::Utils utils;
+  auto lo = utils.parse_limit_order("28800744 C b");
+  EXPECT_EQ(lo.timestamp, 28800744);
+  EXPECT_EQ(lo.type, Order::Type::Cancel);
+  EXPECT_EQ(lo.id, "b");
+
+  lo = utils.parse_limit_order("28800812 U f 44.20 250");
+  EXPECT_EQ(lo.timestamp, 28800812);
+  EXPECT_EQ(lo.type, Order::Type::Replace);
+  EXPECT_EQ(lo.id, "f");
+  EXPECT_EQ(lo.price_cent, 4420);
+  EXPECT_EQ(lo.size, 250);
+
+  std::stringstream ss;
+  ss << lo;
+  EXPECT_EQ(ss.str(), "LimitOrder { timestamp: 28800812, type: Replace, id: f, price_cent: 4420, size: 250 }");
+}
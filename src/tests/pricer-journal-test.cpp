@@ -0,0 +1,99 @@
+#include "../journal/event-journal.h"
+#include "../order-book/order-book-std-map.h"
+#include "../utils.h"
+#include "test-utils.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Problem = OrderBookProgrammingProblem;
+namespace Order = Problem::Order;
+namespace Journal = Problem::Journal;
+using Problem::Testing::TempDir;
+using Problem::Testing::feed_text;
+using Problem::Testing::levels;
+
+namespace {
+  // Runs the pricer binary (PRICER_PATH) on input with args and returns what
+  // it printed to stdout
+  std::string run_pricer(const std::filesystem::path &input, const std::filesystem::path &output,
+                         std::vector<std::string> args) {
+    args.insert(args.begin(), PRICER_PATH);
+    args.push_back("--input-file=" + input.string());
+    const pid_t pid = fork();
+    if (pid == 0) {
+      const int out_fd = open(output.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+      const int null_fd = open("/dev/null", O_WRONLY);
+      if (out_fd < 0 || null_fd < 0 || dup2(out_fd, STDOUT_FILENO) < 0 || dup2(null_fd, STDERR_FILENO) < 0)
+        _exit(127);
+      std::vector<char *> argv;
+      for (auto &arg: args)
+        argv.push_back(arg.data());
+      argv.push_back(nullptr);
+      execv(argv[0], argv.data());
+      _exit(127);
+    }
+    int status = 0;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0) << PRICER_PATH << " " << status;
+    std::ifstream in(output);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+  }
+
+  void write_file(const std::filesystem::path &path, const std::string &text) {
+    std::ofstream(path) << text;
+  }
+} // namespace
+
+// A rerun on the same feed after a crash resumes after the last journaled
+// line: together the two runs print and journal what one run would have
+TEST(PricerJournalTest, RestartShouldResumeAfterTheJournaledLines) {
+  const TempDir dir("pricer-journal");
+  const auto text = feed_text(5'000, 29);
+  auto cut = text.begin();
+  for (int i = 0; i < 2'000; ++i)
+    cut = std::find(cut, text.end(), '\n') + 1;
+  write_file(dir.path / "feed", text);
+  write_file(dir.path / "head", std::string(text.begin(), cut));
+
+  const auto uninterrupted = run_pricer(dir.path / "feed", dir.path / "out", {"200"});
+  const auto journal_arg = "--journal=" + (dir.path / "journal").string();
+  const auto before_crash = run_pricer(dir.path / "head", dir.path / "out", {"200", journal_arg});
+  const auto after_restart = run_pricer(dir.path / "feed", dir.path / "out", {"200", journal_arg});
+  ASSERT_FALSE(uninterrupted.empty());
+  EXPECT_EQ(before_crash + after_restart, uninterrupted);
+
+  Problem::Utils utils;
+  Problem::OrderBookStdMap<> expected;
+  std::istringstream lines(text);
+  std::vector<uint64_t> expected_sequences;
+  uint64_t line_number = 0;
+  for (std::string line; std::getline(lines, line);) {
+    ++line_number;
+    if (expected.try_add_order(utils.parse_limit_order(line)).has_value())
+      expected_sequences.push_back(line_number);
+  }
+  Problem::OrderBookStdMap<> recovered;
+  std::vector<uint64_t> sequences;
+  const Journal::EventJournal journal((dir.path / "journal").string(), Journal::read_only);
+  journal.replay([&](const uint64_t sequence, const Order::LimitOrder &lo) {
+    sequences.push_back(sequence);
+    EXPECT_TRUE(recovered.try_add_order(lo).has_value()) << sequence;
+  });
+  EXPECT_EQ(sequences, expected_sequences);
+  for (const auto side: {Order::Side::Ask, Order::Side::Bid})
+    EXPECT_EQ(levels(recovered, side), levels(expected, side));
+}
@@ -0,0 +1,137 @@
+#include "../feed-generator.h"
+#include "../order-book/order-book-registry.h"
+#include "../pricing-subscriptions.h"
+#include "../utils.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace Problem = OrderBookProgrammingProblem;
+namespace Order = Problem::Order;
+
+namespace {
+  using Notification = std::tuple<size_t, size_t, std::optional<int64_t> >;
+
+  struct Subscription {
+    Order::Side side;
+    int target_size;
+    int64_t threshold_cent;
+  };
+
+  // The synthetic feed with every 7th add followed by a Replace of the new
+  // order to another price (same size, so that later reduces still fit)
+  std::vector<Order::LimitOrder> generate_feed(const size_t n, const uint64_t seed) {
+    std::vector<Order::LimitOrder> feed;
+    std::mt19937 gen(seed);
+    for (auto &lo: Problem::generate_synthetic_feed(n, seed, 500, 20)) {
+      feed.push_back(lo);
+      if (lo.type != Order::Type::Add || gen() % 7 != 0)
+        continue;
+      lo.type = Order::Type::Replace;
+      lo.price_cent += static_cast<int>(gen() % 11) - 5;
+      feed.push_back(lo);
+    }
+    return feed;
+  }
+
+  // Reprices every subscription after every message, obviously correct
+  template<typename OrderBookImpl>
+  std::vector<Notification> naive_notifications(const std::vector<Order::LimitOrder> &feed,
+                                                const std::vector<Subscription> &subscriptions) {
+    OrderBookImpl order_book;
+    std::vector<std::optional<int64_t> > costs(subscriptions.size());
+    std::vector<Notification> notifications;
+    for (size_t i = 0; i < feed.size(); ++i) {
+      if (!order_book.try_add_order(feed[i]).has_value())
+        continue;
+      for (size_t id = 0; id < subscriptions.size(); ++id) {
+        const auto &[side, target_size, threshold_cent] = subscriptions[id];
+        const auto cost = side == Order::Side::Bid
+                            ? order_book.get_pricer_sell_cost_cent(target_size)
+                            : order_book.get_pricer_buy_cost_cent(target_size);
+        const std::optional<int64_t> cost_cent = cost.has_value() ? std::optional<int64_t>(*cost) : std::nullopt;
+        if (cost_cent.has_value() == costs[id].has_value() &&
+            (!cost_cent.has_value() || std::abs(*cost_cent - *costs[id]) <= threshold_cent))
+          continue;
+        costs[id] = cost_cent;
+        notifications.emplace_back(i, id, cost_cent);
+      }
+    }
+    std::ranges::sort(notifications);
+    return notifications;
+  }
+
+  template<typename OrderBookImpl>
+  std::vector<Notification> registry_notifications(const std::vector<Order::LimitOrder> &feed,
+                                                   const std::vector<Subscription> &subscriptions) {
+    OrderBookImpl order_book;
+    Problem::PricingSubscriptions registry;
+    for (const auto &[side, target_size, threshold_cent]: subscriptions)
+      registry.subscribe(order_book, side, target_size, threshold_cent);
+    std::vector<Notification> notifications;
+    for (size_t i = 0; i < feed.size(); ++i) {
+      const auto applied = order_book.try_add_order(feed[i]);
+      if (!applied.has_value())
+        continue;
+      registry.on_change(order_book, applied.value(), [&](const size_t id, Order::Side, const auto cost_cent) {
+        notifications.emplace_back(i, id, cost_cent);
+      });
+    }
+    std::ranges::sort(notifications);
+    return notifications;
+  }
+} // namespace
+
+TEST(PricingSubscriptionsTest, SmallMovesShouldBeSuppressed) {
+  Problem::OrderBookStdMap<> order_book;
+  Problem::PricingSubscriptions registry;
+  const auto id = registry.subscribe(order_book, Order::Side::Ask, 100, 5000);
+  EXPECT_FALSE(registry.cost_cent(id).has_value());
+  std::vector<std::optional<int64_t> > notified;
+  const auto apply = [&](const std::string &line) {
+    Problem::Utils utils;
+    registry.on_change(order_book, order_book.try_add_order(utils.parse_limit_order(line)).value(),
+                       [&](size_t, Order::Side, const auto cost_cent) { notified.push_back(cost_cent); });
+  };
+  apply("1 A a S 10.00 100");
+  // Moves by 5000 cents, not more than the threshold
+  apply("2 U a 10.50 100");
+  // 10000 cents away from the last notified cost
+  apply("3 U a 11.00 100");
+  // Bids and deeper asks do not change the fill
+  apply("4 A b B 9.00 100");
+  apply("5 A c S 12.00 100");
+  apply("6 C a");
+  EXPECT_EQ(notified, (std::vector<std::optional<int64_t> >{100000, 110000, 120000}));
+  apply("7 C c");
+  EXPECT_EQ(notified.back(), std::nullopt);
+  EXPECT_EQ(registry.cost_cent(id), std::nullopt);
+  EXPECT_TRUE(registry.unsubscribe(id));
+  EXPECT_FALSE(registry.unsubscribe(id));
+  EXPECT_EQ(registry.size(), 0);
+}
+
+TEST(PricingSubscriptionsTest, NotificationsShouldMatchRepricingEverySubscription) {
+  const auto feed = generate_feed(20'000, 7);
+  std::mt19937 gen(11);
+  std::vector<Subscription> subscriptions;
+  for (int i = 0; i < 200; ++i)
+    subscriptions.push_back({gen() % 2 ? Order::Side::Bid : Order::Side::Ask, 1 + static_cast<int>(gen() % 5'000),
+                             static_cast<int64_t>(gen() % 4 == 0 ? 0 : gen() % 2'000)});
+  const auto expected = naive_notifications<Problem::OrderBookStdMap<> >(feed, subscriptions);
+  ASSERT_GT(expected.size(), feed.size() / 10);
+  for (const auto name: Problem::order_book_names) {
+    Problem::visit_order_book(name, [&]<typename OrderBookImpl>() {
+      EXPECT_EQ(registry_notifications<OrderBookImpl>(feed, subscriptions), expected) << name;
+    });
+  }
+}
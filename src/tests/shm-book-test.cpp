@@ -0,0 +1,114 @@
+#include "../order-book/order-book-registry.h"
+#include "../shm/shm-book-publisher.h"
+#include "../shm/shm-book-reader.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+namespace Problem = OrderBookProgrammingProblem;
+namespace Order = Problem::Order;
+namespace Shm = Problem::Shm;
+
+namespace {
+  std::string unique_shm_name(const std::string &test) {
+    return "/obpp-" + test + "-" + std::to_string(getpid());
+  }
+
+  Order::LimitOrder make_add(const std::string &id, const Order::Side side, const int price_cent,
+                             const int size) {
+    Order::LimitOrder lo;
+    lo.type = Order::Type::Add;
+    lo.id = id;
+    lo.side = side;
+    lo.price_cent = price_cent;
+    lo.size = size;
+    return lo;
+  }
+} // namespace
+
+TEST(ShmBookTest, ReaderShouldSeePublishedBook) {
+  const auto name = unique_shm_name("publish");
+  Shm::BookPublisher publisher(name);
+  const Shm::BookReader reader(name);
+  EXPECT_FALSE(reader.read().has_value());
+
+  Problem::OrderBookArray<> order_book;
+  order_book.add_order(make_add("b1", Order::Side::Bid, 4410, 100));
+  order_book.add_order(make_add("b2", Order::Side::Bid, 4415, 50));
+  order_book.add_order(make_add("b3", Order::Side::Bid, 4415, 25));
+  order_book.add_order(make_add("a1", Order::Side::Ask, 4420, 30));
+  const auto sell = order_book.get_pricer_sell_cost_cent(100);
+  const auto buy = order_book.get_pricer_buy_cost_cent(100);
+  publisher.publish(28800538, order_book, 100, sell, buy);
+
+  const auto snapshot = reader.read();
+  ASSERT_TRUE(snapshot.has_value());
+  EXPECT_EQ(reader.publish_count(), 1);
+  EXPECT_EQ(snapshot->timestamp, 28800538);
+  EXPECT_EQ(snapshot->target_size, 100);
+  EXPECT_EQ(snapshot->sell_cost(), sell);
+  EXPECT_FALSE(snapshot->buy_cost().has_value());
+  ASSERT_EQ(snapshot->bid_count, 2);
+  EXPECT_EQ(snapshot->bids[0].price_cent, 4415);
+  EXPECT_EQ(snapshot->bids[0].size, 75);
+  EXPECT_EQ(snapshot->bids[1].price_cent, 4410);
+  EXPECT_EQ(snapshot->bids[1].size, 100);
+  ASSERT_TRUE(snapshot->best_ask().has_value());
+  EXPECT_EQ(snapshot->best_ask()->price_cent, 4420);
+  EXPECT_EQ(snapshot->ask_count, 1);
+  EXPECT_FALSE(reader.closed());
+}
+
+TEST(ShmBookTest, DepthShouldBeCappedAtMaxDepth) {
+  const auto name = unique_shm_name("depth");
+  Shm::BookPublisher publisher(name);
+  const Shm::BookReader reader(name);
+  Problem::OrderBookStdMap<> order_book;
+  for (int i = 0; i < 40; ++i)
+    order_book.add_order(make_add(std::to_string(i), Order::Side::Ask, 5000 + i, 10));
+  publisher.publish(1, order_book, 1, order_book.get_pricer_sell_cost_cent(1),
+                    order_book.get_pricer_buy_cost_cent(1));
+  const auto snapshot = reader.read();
+  ASSERT_TRUE(snapshot.has_value());
+  EXPECT_EQ(snapshot->ask_count, Shm::max_depth);
+  EXPECT_EQ(snapshot->asks[Shm::max_depth - 1].price_cent, 5000 + Shm::max_depth - 1);
+  EXPECT_EQ(snapshot->bid_count, 0);
+}
+
+// Every field of a published snapshot is derived from its timestamp, a torn
+// copy would break that
+TEST(ShmBookTest, ConcurrentReaderShouldNeverSeeTornSnapshots) {
+  const auto name = unique_shm_name("torn");
+  Shm::BookPublisher publisher(name);
+  std::atomic<bool> done{false};
+  std::atomic<size_t> bad_reads{0};
+  std::thread reader_thread([&] {
+    const Shm::BookReader reader(name);
+    while (!done.load(std::memory_order_relaxed)) {
+      const auto snapshot = reader.read();
+      if (!snapshot.has_value())
+        continue;
+      const auto t = static_cast<int64_t>(snapshot->timestamp);
+      bool ok = snapshot->sell_cost_cent == t && snapshot->buy_cost_cent == -t;
+      for (const auto &level: snapshot->bids)
+        ok = ok && level.price_cent == t && level.size == t + 1;
+      if (!ok)
+        ++bad_reads;
+    }
+  });
+  Shm::BookSnapshot snapshot;
+  for (uint64_t t = 1; t <= 200000; ++t) {
+    snapshot.timestamp = t;
+    snapshot.sell_cost_cent = static_cast<int64_t>(t);
+    snapshot.buy_cost_cent = -static_cast<int64_t>(t);
+    for (auto &level: snapshot.bids)
+      level = {static_cast<int64_t>(t), static_cast<int64_t>(t) + 1};
+    publisher.publish(snapshot);
+  }
+  done = true;
+  reader_thread.join();
+  EXPECT_EQ(bad_reads.load(), 0);
+}
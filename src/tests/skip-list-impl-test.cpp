@@ -0,0 +1,103 @@
+#include "../skip-list-impl.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <map>
+#include <random>
+#include <ranges>
+#include <thread>
+#include <vector>
+
+using namespace OrderBookProgrammingProblem;
+
+namespace {
+  template<typename List>
+  std::vector<int> keys_of(const List &list) {
+    std::vector<int> keys;
+    for (const auto *node = list.first(); node != nullptr; node = node->next())
+      keys.push_back(node->key());
+    return keys;
+  }
+} // namespace
+
+TEST(SkipList, AFewInsertAndEraseShouldWork) {
+  SkipList<int, int, std::greater<> > list;
+  EXPECT_EQ(list.first(), nullptr);
+  EXPECT_EQ(list.find(1), nullptr);
+  list.insert(3)->value = 30;
+  list.insert(7)->value = 70;
+  list.insert(5)->value = 50;
+  EXPECT_THAT(keys_of(list), testing::ElementsAre(7, 5, 3));
+  EXPECT_EQ(list.find(5)->value, 50);
+  list.erase(list.find(7));
+  EXPECT_THAT(keys_of(list), testing::ElementsAre(5, 3));
+  EXPECT_EQ(list.size(), 2);
+  list.erase(list.find(3));
+  list.erase(list.find(5));
+  EXPECT_EQ(list.first(), nullptr);
+}
+
+TEST(SkipList, RandomOperationsShouldMatchStdMap) {
+  std::mt19937 gen(9527);
+  SkipList<int, int> list;
+  std::map<int, int> expected;
+  for (int i = 0; i < 100'000; ++i) {
+    const auto key = static_cast<int>(gen() % 5'000);
+    if (auto *node = list.find(key); node != nullptr) {
+      ASSERT_EQ(expected.at(key), node->value);
+      list.erase(node);
+      expected.erase(key);
+    } else {
+      ASSERT_FALSE(expected.contains(key));
+      list.insert(key)->value = i;
+      expected[key] = i;
+    }
+    ASSERT_EQ(list.size(), expected.size());
+  }
+  EXPECT_TRUE(std::ranges::equal(keys_of(list), expected | std::views::keys));
+}
+
+// Erased nodes stay readable until the readers that may have seen them unpin
+TEST(SkipList, ReadersShouldWalkWhileTheWriterInsertsAndErases) {
+  using List = SkipList<int, int, std::less<>, true>;
+  List list;
+  std::atomic<bool> done{false};
+  std::atomic<size_t> bad_reads{0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 3; ++r) {
+    readers.emplace_back([&] {
+      const auto reader = list.register_reader();
+      while (!done.load(std::memory_order_relaxed)) {
+        // Every value is its key times ten and keys are strictly increasing
+        const auto ok = list.read(reader, [&] {
+          int previous = -1;
+          for (const auto *node = list.first(); node != nullptr; node = node->next()) {
+            if (node->is_deleted())
+              continue;
+            if (node->key() <= previous || List::load(node->value) != node->key() * 10)
+              return false;
+            previous = node->key();
+          }
+          return true;
+        });
+        bad_reads += !ok;
+      }
+      list.unregister_reader(reader);
+    });
+  }
+  std::mt19937 gen(9527);
+  for (int i = 0; i < 20'000; ++i) {
+    const auto key = static_cast<int>(gen() % 500);
+    List::WriteSection section(list);
+    if (auto *node = list.find(key); node != nullptr)
+      list.erase(node);
+    else
+      List::store(list.insert(key)->value, key * 10);
+  }
+  done = true;
+  for (auto &reader: readers)
+    reader.join();
+  EXPECT_EQ(bad_reads.load(), 0);
+}
@@ -0,0 +1,63 @@
+#ifndef TEST_UTILS_H
+#define TEST_UTILS_H
+
+#include "../feed-generator.h"
+#include "../order.h"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace OrderBookProgrammingProblem::Testing {
+  // A path under the temp directory, unique to the test and the process,
+  // removed with whatever is there when the test ends
+  struct TempPath {
+    std::filesystem::path path;
+
+    explicit TempPath(const std::string &test)
+      : path(std::filesystem::temp_directory_path() / ("obpp-" + test + "-" + std::to_string(getpid()))) {
+      std::filesystem::remove_all(path);
+    }
+
+    TempPath(const TempPath &) = delete;
+
+    TempPath &operator=(const TempPath &) = delete;
+
+    ~TempPath() { std::filesystem::remove_all(path); }
+  };
+
+  struct TempDir : TempPath {
+    explicit TempDir(const std::string &test) : TempPath(test) { std::filesystem::create_directories(path); }
+  };
+
+  // The (price, size) levels of one side of book, from the best price
+  template<typename Book>
+  std::vector<std::pair<int, int64_t> > levels(Book &book, const Order::Side side) {
+    std::vector<std::pair<int, int64_t> > out;
+    book.for_each_level(side, [&](const auto price_cent, const auto size) {
+      out.emplace_back(price_cent, size);
+      return true;
+    });
+    return out;
+  }
+
+  // The synthetic feed in the format of pricer.in
+  inline std::string feed_text(const size_t n, const uint64_t seed) {
+    std::string text;
+    for (const auto &lo: generate_synthetic_feed(n, seed, 500, 20)) {
+      if (lo.type == Order::Type::Add)
+        text += std::format("{} A {} {} {}.{:02} {}\n", lo.timestamp, lo.id, lo.side == Order::Side::Ask ? 'S' : 'B',
+                            lo.price_cent / 100, lo.price_cent % 100, lo.size);
+      else
+        text += std::format("{} R {} {}\n", lo.timestamp, lo.id, lo.size);
+    }
+    return text;
+  }
+} // namespace OrderBookProgrammingProblem::Testing
+
+#endif // TEST_UTILS_H
@@ -0,0 +1,84 @@
+#include "../veb-impl.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+#include <ranges>
+#include <set>
+#include <vector>
+
+using namespace OrderBookProgrammingProblem;
+
+namespace {
+  std::vector<VebTree::Key> ascending(const VebTree &veb) {
+    std::vector<VebTree::Key> keys;
+    for (auto key = veb.min(); key.has_value(); key = veb.successor(*key))
+      keys.push_back(*key);
+    return keys;
+  }
+
+  std::vector<VebTree::Key> descending(const VebTree &veb) {
+    std::vector<VebTree::Key> keys;
+    for (auto key = veb.max(); key.has_value(); key = veb.predecessor(*key))
+      keys.push_back(*key);
+    return keys;
+  }
+} // namespace
+
+TEST(Veb, AFewInsertAndEraseShouldWork) {
+  VebTree veb(32);
+  EXPECT_TRUE(veb.empty());
+  EXPECT_FALSE(veb.min().has_value());
+  EXPECT_FALSE(veb.successor(0).has_value());
+  veb.insert(4412);
+  veb.insert(0);
+  veb.insert(std::numeric_limits<uint32_t>::max());
+  veb.insert(4410);
+  EXPECT_THAT(ascending(veb), testing::ElementsAre(0, 4410, 4412, std::numeric_limits<uint32_t>::max()));
+  EXPECT_THAT(descending(veb), testing::ElementsAre(std::numeric_limits<uint32_t>::max(), 4412, 4410, 0));
+  EXPECT_EQ(veb.successor(4411), 4412);
+  EXPECT_EQ(veb.predecessor(4411), 4410);
+  EXPECT_TRUE(veb.contains(4410));
+  EXPECT_FALSE(veb.contains(4411));
+  veb.erase(0);
+  veb.erase(std::numeric_limits<uint32_t>::max());
+  EXPECT_THAT(ascending(veb), testing::ElementsAre(4410, 4412));
+  veb.erase(4410);
+  veb.erase(4412);
+  EXPECT_TRUE(veb.empty());
+  EXPECT_THROW(VebTree(0), std::invalid_argument);
+}
+
+TEST(Veb, RandomOperationsShouldMatchStdSet) {
+  for (const unsigned bits: {5U, 12U, 31U, 64U}) {
+    std::mt19937_64 gen(9527 + bits);
+    // Keys cluster in a few narrow bands so that clusters fill up and empty
+    const auto draw = [&] {
+      const auto key = (gen() % 4) * (bits == 64 ? uint64_t{1} << 62 : (uint64_t{1} << bits) / 4) + gen() % 40;
+      return bits == 64 ? key : key & ((uint64_t{1} << bits) - 1);
+    };
+    VebTree veb(bits);
+    std::set<VebTree::Key> expected;
+    for (int i = 0; i < 20'000; ++i) {
+      const auto key = draw();
+      if (expected.contains(key)) {
+        veb.erase(key);
+        expected.erase(key);
+      } else {
+        veb.insert(key);
+        expected.insert(key);
+      }
+      const auto probe = draw();
+      const auto next = expected.upper_bound(probe);
+      ASSERT_EQ(veb.successor(probe), next == expected.end() ? std::nullopt : std::optional(*next)) << bits;
+      const auto prev = expected.lower_bound(probe);
+      ASSERT_EQ(veb.predecessor(probe), prev == expected.begin() ? std::nullopt : std::optional(*std::prev(prev)))
+          << bits;
+      ASSERT_EQ(veb.contains(probe), expected.contains(probe));
+    }
+    EXPECT_TRUE(std::ranges::equal(ascending(veb), expected));
+    EXPECT_TRUE(std::ranges::equal(descending(veb), expected | std::views::reverse));
+  }
+}
@@ -23,61 +23,75 @@ bool Utils::at_most_n_decimal_places(const std::string_view str,
   return decimal_places <= n;
 }
 
-Order::LimitOrder Utils::parse_limit_order(const std::string &str) {
+std::expected<Order::LimitOrder, RejectReason> Utils::try_parse_limit_order(const std::string_view str) {
   split_string(str, ' ', order_line_parts);
-  if (order_line_parts.size() < 2)
-    throw std::invalid_argument("order_line_parts.size() < 2 (==" +
-                                std::to_string(order_line_parts.size()) + ")");
+  if (order_line_parts.size() < 2) [[unlikely]]
+    return std::unexpected(RejectReason::malformed_line);
   Order::LimitOrder lo;
-  lo.type = order_line_parts[1] == "A" ? Order::Type::Add : Order::Type::Reduce;
+  // Fields per type: "ts A id side price size", "ts R id size", "ts C id"
+  // and "ts U id price size"
+  size_t part_count = 0;
+  if (order_line_parts[1] == "A") {
+    lo.type = Order::Type::Add;
+    part_count = 6;
+  } else if (order_line_parts[1] == "R") {
+    lo.type = Order::Type::Reduce;
+    part_count = 4;
+  } else if (order_line_parts[1] == "C") {
+    lo.type = Order::Type::Cancel;
+    part_count = 3;
+  } else if (order_line_parts[1] == "U") {
+    lo.type = Order::Type::Replace;
+    part_count = 5;
+  } else [[unlikely]]
+    return std::unexpected(RejectReason::bad_type);
 
-  if (lo.type == Order::Type::Add && order_line_parts.size() != 6)
-    throw std::invalid_argument("Unexpected order_line_parts.size() != 6 (==" +
-                                std::to_string(order_line_parts.size()) + ")");
-  if (lo.type == Order::Type::Reduce && order_line_parts.size() != 4)
-    throw std::invalid_argument("Unexpected order_line_parts.size() != 4 (==" +
-                                std::to_string(order_line_parts.size()) + ")");
+  if (order_line_parts.size() != part_count) [[unlikely]]
+    return std::unexpected(RejectReason::malformed_line);
 
   auto [ptr, ec] = std::from_chars(
       order_line_parts[0].data(),
       order_line_parts[0].data() + order_line_parts[0].size(), lo.timestamp);
-  if (ec != std::errc()) {
-    throw std::invalid_argument("Timestamp conversion failed");
-  }
+  if (ec != std::errc() || ptr != order_line_parts[0].data() + order_line_parts[0].size()) [[unlikely]]
+    return std::unexpected(RejectReason::bad_timestamp);
 
   lo.id = order_line_parts[2];
 
+  if (lo.type == Order::Type::Cancel)
+    return lo;
+
+  const auto &size_part = order_line_parts[part_count - 1];
+  if (const auto [size_ptr, size_ec] = std::from_chars(size_part.data(), size_part.data() + size_part.size(), lo.size);
+    size_ec != std::errc() || size_ptr != size_part.data() + size_part.size()) [[unlikely]]
+    return std::unexpected(RejectReason::bad_size);
+
   if (lo.type == Order::Type::Add) {
-    lo.side = order_line_parts[3] == "S" ? Order::Side::Ask : Order::Side::Bid;
-    {
-      float price = 0;
-      auto [ptr, ec] = std::from_chars(
-          order_line_parts[4].data(),
-          order_line_parts[4].data() + order_line_parts[4].size(), price);
-      if (ec != std::errc()) {
-        throw std::invalid_argument("Price conversion failed");
-      }
-      if (!at_most_n_decimal_places(order_line_parts[4], 2))
-        throw std::invalid_argument("Price has more than 2 decimal places");
-      lo.price_cent = price * 100;
-    }
-    {
-      auto [ptr, ec] = std::from_chars(
-          order_line_parts[5].data(),
-          order_line_parts[5].data() + order_line_parts[5].size(), lo.size);
-      if (ec != std::errc()) {
-        throw std::invalid_argument("Size conversion failed");
-      }
-    }
-  } else {
-    auto [ptr, ec] = std::from_chars(
-        order_line_parts[3].data(),
-        order_line_parts[3].data() + order_line_parts[3].size(), lo.size);
-    if (ec != std::errc()) {
-      throw std::invalid_argument("Size conversion failed");
-    }
+    if (order_line_parts[3] == "S")
+      lo.side = Order::Side::Ask;
+    else if (order_line_parts[3] == "B")
+      lo.side = Order::Side::Bid;
+    else [[unlikely]]
+      return std::unexpected(RejectReason::bad_side);
+  }
+
+  if (lo.type == Order::Type::Add || lo.type == Order::Type::Replace) {
+    const auto &price_part = order_line_parts[part_count - 2];
+    float price = 0;
+    auto [price_ptr, price_ec] = std::from_chars(
+        price_part.data(), price_part.data() + price_part.size(), price);
+    if (price_ec != std::errc() || price_ptr != price_part.data() + price_part.size() ||
+        !at_most_n_decimal_places(price_part, 2)) [[unlikely]]
+      return std::unexpected(RejectReason::bad_price);
+    lo.price_cent = price * 100;
   }
 
   return lo;
-};
+}
+
+Order::LimitOrder Utils::parse_limit_order(const std::string_view str) {
+  auto lo = try_parse_limit_order(str);
+  if (!lo.has_value())
+    throw std::invalid_argument(std::string(to_string(lo.error())) + ": " + std::string(str));
+  return std::move(lo.value());
+}
 } // namespace OrderBookProgrammingProblem
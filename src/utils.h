@@ -2,7 +2,9 @@
 #define UTILS_H
 
 #include "order.h"
+#include "reject-reason.h"
 
+#include <expected>
 #include <string_view>
 #include <vector>
 #include <ranges>
@@ -33,7 +35,11 @@ namespace OrderBookProgrammingProblem {
   public:
     static bool at_most_n_decimal_places(std::string_view str, size_t n);
 
-    Order::LimitOrder parse_limit_order(const std::string &);
+    // Returns why the line is malformed instead of throwing
+    std::expected<Order::LimitOrder, RejectReason> try_parse_limit_order(std::string_view);
+
+    // Throws std::invalid_argument if the line is malformed
+    Order::LimitOrder parse_limit_order(std::string_view);
   };
 } // namespace OrderBookProgrammingProblem
 
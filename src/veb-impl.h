@@ -0,0 +1,183 @@
+#ifndef VEB_IMPL_H
+#define VEB_IMPL_H
+
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace OrderBookProgrammingProblem {
+  // van Emde Boas tree over the keys [0, 2^universe_bits), universe_bits <= 64.
+  // Clusters are kept in hash maps and only exist while they hold a key, so
+  // memory is proportional to the number of keys rather than to the universe
+  // (a "hashed" vEB tree), while successor() and predecessor() still take
+  // O(log log U). Universes of up to 64 keys are a single bitmap.
+  class VebTree {
+  public:
+    using Key = uint64_t;
+
+  private:
+    static constexpr unsigned base_bits = 6;
+
+    unsigned bits;
+    // Base case: bit k is set if k is in the set
+    uint64_t bitmap = 0;
+    // Otherwise min is not stored in any cluster (as in the textbook version),
+    // which makes inserting into an empty tree O(1)
+    bool has_min = false;
+    Key min_key = 0;
+    Key max_key = 0;
+    // Keys are split into high (the cluster) and low (the key in the cluster)
+    // bits, summary holds the high bits of the non-empty clusters
+    std::unique_ptr<VebTree> summary;
+    std::unordered_map<Key, std::unique_ptr<VebTree> > clusters;
+
+    [[nodiscard]] bool is_base() const { return bits <= base_bits; }
+    [[nodiscard]] unsigned low_bits() const { return bits / 2; }
+    [[nodiscard]] Key high(const Key key) const { return key >> low_bits(); }
+    [[nodiscard]] Key low(const Key key) const { return key & ((Key{1} << low_bits()) - 1); }
+    [[nodiscard]] Key index(const Key high_part, const Key low_part) const {
+      return (high_part << low_bits()) | low_part;
+    }
+
+    [[nodiscard]] VebTree *cluster(const Key high_part) const {
+      const auto it = clusters.find(high_part);
+      return it == clusters.end() ? nullptr : it->second.get();
+    }
+
+  public:
+    explicit VebTree(const unsigned universe_bits) : bits(universe_bits) {
+      if (bits == 0 || bits > 64)
+        throw std::invalid_argument("universe_bits must be in [1, 64]");
+    }
+
+    [[nodiscard]] bool empty() const { return is_base() ? bitmap == 0 : !has_min; }
+
+    [[nodiscard]] std::optional<Key> min() const {
+      if (empty())
+        return std::nullopt;
+      return is_base() ? static_cast<Key>(std::countr_zero(bitmap)) : min_key;
+    }
+
+    [[nodiscard]] std::optional<Key> max() const {
+      if (empty())
+        return std::nullopt;
+      return is_base() ? static_cast<Key>(63 - std::countl_zero(bitmap)) : max_key;
+    }
+
+    [[nodiscard]] bool contains(const Key key) const {
+      if (is_base())
+        return (bitmap >> key) & 1;
+      if (!has_min)
+        return false;
+      if (key == min_key || key == max_key)
+        return true;
+      const auto *c = cluster(high(key));
+      return c != nullptr && c->contains(low(key));
+    }
+
+    // key must not be in the set yet
+    void insert(Key key) {
+      if (is_base()) {
+        bitmap |= uint64_t{1} << key;
+        return;
+      }
+      if (!has_min) {
+        has_min = true;
+        min_key = max_key = key;
+        return;
+      }
+      if (key < min_key)
+        std::swap(key, min_key);
+      if (key > max_key)
+        max_key = key;
+      auto &c = clusters[high(key)];
+      if (c == nullptr) {
+        c = std::make_unique<VebTree>(low_bits());
+        if (summary == nullptr)
+          summary = std::make_unique<VebTree>(bits - low_bits());
+        summary->insert(high(key));
+      }
+      c->insert(low(key));
+    }
+
+    // key must be in the set
+    void erase(Key key) {
+      if (is_base()) {
+        bitmap &= ~(uint64_t{1} << key);
+        return;
+      }
+      if (min_key == max_key) {
+        has_min = false;
+        return;
+      }
+      if (key == min_key) {
+        // Promote the smallest key in the clusters to min
+        const auto first = summary->min().value();
+        key = min_key = index(first, cluster(first)->min().value());
+      }
+      const auto high_part = high(key);
+      auto *c = cluster(high_part);
+      c->erase(low(key));
+      if (c->empty()) {
+        clusters.erase(high_part);
+        summary->erase(high_part);
+        if (key == max_key) {
+          const auto last = summary->max();
+          max_key = last.has_value() ? index(*last, cluster(*last)->max().value()) : min_key;
+        }
+      } else if (key == max_key) {
+        max_key = index(high_part, c->max().value());
+      }
+    }
+
+    // Smallest key greater than key
+    [[nodiscard]] std::optional<Key> successor(const Key key) const {
+      if (is_base()) {
+        if (key >= 63)
+          return std::nullopt;
+        const auto above = bitmap & (~uint64_t{0} << (key + 1));
+        if (above == 0)
+          return std::nullopt;
+        return static_cast<Key>(std::countr_zero(above));
+      }
+      if (!has_min || key >= max_key)
+        return std::nullopt;
+      if (key < min_key)
+        return min_key;
+      const auto high_part = high(key);
+      if (const auto *c = cluster(high_part); c != nullptr && low(key) < c->max().value())
+        return index(high_part, c->successor(low(key)).value());
+      const auto next = summary->successor(high_part);
+      return index(next.value(), cluster(*next)->min().value());
+    }
+
+    // Largest key smaller than key
+    [[nodiscard]] std::optional<Key> predecessor(const Key key) const {
+      if (is_base()) {
+        if (key == 0)
+          return std::nullopt;
+        const auto below = key >= 64 ? bitmap : bitmap & ((uint64_t{1} << key) - 1);
+        if (below == 0)
+          return std::nullopt;
+        return static_cast<Key>(63 - std::countl_zero(below));
+      }
+      if (!has_min || key <= min_key)
+        return std::nullopt;
+      if (key > max_key)
+        return max_key;
+      const auto high_part = high(key);
+      if (const auto *c = cluster(high_part); c != nullptr && low(key) > c->min().value())
+        return index(high_part, c->predecessor(low(key)).value());
+      if (summary != nullptr) {
+        if (const auto prev = summary->predecessor(high_part); prev.has_value())
+          return index(*prev, cluster(*prev)->max().value());
+      }
+      return min_key;
+    }
+  };
+} // namespace OrderBookProgrammingProblem
+
+#endif // VEB_IMPL_H